@@ -18,6 +18,7 @@
 #include <string>
 #include <boost/program_options.hpp>
 #include "tiffWriter/image.hpp"
+#include "tiffWriter/WriteOptionsArgs.hpp"
 #include "tiffWriter/traitsAndPolicies.hpp"
 #include "libLiFFT/FFT.hpp"
 #if defined(WITH_CUDA)
@@ -37,7 +38,12 @@
 #include "libLiFFT/policies/CalcIntensityFunctor.hpp"
 #include "libLiFFT/types/View.hpp"
 #include "libLiFFT/types/SliceView.hpp"
+#include "libLiFFT/mem/ImageStackContainer.hpp"
+#include <algorithm>
 #include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace po = boost::program_options;
 using std::string;
@@ -65,11 +71,26 @@ void showHelp()
 }
 
 void
-do2D_FFT(const string& inFilePath, const string& outFilePath)
+do2D_FFT(const string& inFilePath, const string& outFilePath, unsigned x0, unsigned y0, int size,
+         const tiffWriter::WriteOptions& writeOptions)
 {
     using namespace LiFFT;
     using FFT = FFT_2D_R2C<FP_Type>;
-    auto input = FFT::wrapInput(ImgType(inFilePath, false));
+    ImgType img;
+    if(x0 || y0 || size >= 0)
+    {
+        unsigned width, height;
+        ImgType::readFileExtents(inFilePath, width, height);
+        if(x0 >= width || y0 >= height)
+            throw std::runtime_error("Region start [" + std::to_string(x0) + ", " + std::to_string(y0) +
+                    "] is outside of the image (" + std::to_string(width) + "x" + std::to_string(height) + ")");
+        // Only the strips/tiles of the region are decoded
+        const unsigned actualSize = (size < 0) ? std::min(width - x0, height - y0) : size;
+        std::cout << "Processing region: [" << x0 << ", " << y0 << "] size " << actualSize << std::endl;
+        img.openRegion(inFilePath, x0, y0, actualSize, actualSize, false);
+    }else
+        img.open(inFilePath, false);
+    auto input = FFT::wrapInput(std::move(img));
     auto output = FFT::createNewOutput(input);
     auto fft = makeFFT<FFT_LIB, false>(input, output);
     input.getBase().load();
@@ -80,7 +101,7 @@ do2D_FFT(const string& inFilePath, const string& outFilePath)
                             accessors::makeTransformAccessorFor(policies::CalcIntensityFunc(), fullOutput)
                         );
     policies::copy(fullOutput, outImg, transformAcc);
-    outImg.save();
+    outImg.save(writeOptions);
 }
 
 string
@@ -111,6 +132,8 @@ main(int argc, char** argv)
         ("yStart,y", po::value<unsigned>(&y0)->default_value(0), "Offset in y-Direction")
         ("size,s", po::value<int>(&size)->default_value(-1), "Size of the image to use (-1=all)")
     ;
+    tiffWriter::WriteOptionsArgs writeOptionsArgs;
+    writeOptionsArgs.addTo(options::desc);
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, options::desc), vm);
@@ -128,11 +151,20 @@ main(int argc, char** argv)
         return 1;
     }
 
+    const tiffWriter::WriteOptions writeOptions = writeOptionsArgs.getWriteOptions();
+
     if(firstIdx == lastIdx || inFilePath.find("%i") == string::npos)
     {
         // Only 1 image --> 2D FFT
         inFilePath = replace(inFilePath, "%i", getFilledNumber(firstIdx, minSize, filler));
-        do2D_FFT(inFilePath, outFilePath);
+        try
+        {
+            do2D_FFT(inFilePath, outFilePath, x0, y0, size, writeOptions);
+        }catch(const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
         return 0;
     }
 
@@ -141,22 +173,32 @@ main(int argc, char** argv)
     using LiFFT::types::makeRange;
 
     // Multiple images --> 3D FFT
-    // Assume all images have the same size --> load the first one to get extents and create FFT Data
+    // All images must have the same size, they are decoded in parallel when the data is loaded
     auto start = std::chrono::high_resolution_clock::now();
-    string curFilePath = replace(inFilePath, "%i", getFilledNumber(firstIdx, minSize, filler));
-    ImgType img(curFilePath);
+    std::vector<string> filePaths;
+    for(unsigned i=firstIdx; i<=lastIdx; ++i)
+        filePaths.push_back(replace(inFilePath, "%i", getFilledNumber(i, minSize, filler)));
+    LiFFT::mem::ImageStackContainer<ImgType, LiFFT::accessors::VolumeAccessor, FP_Type> stack(filePaths);
+    if(x0 >= stack.getExtents()[2] || y0 >= stack.getExtents()[1])
+    {
+        std::cerr << "Region start [" << x0 << ", " << y0 << "] is outside of the images ("
+                  << stack.getExtents()[2] << "x" << stack.getExtents()[1] << ")" << std::endl;
+        return 1;
+    }
     if(size < 0 )
-        actualSize = std::min(img.getWidth(), img.getHeight());
+        actualSize = std::min(stack.getExtents()[1] - y0, stack.getExtents()[2] - x0);
     else
         actualSize = size;
+    if(actualSize > stack.getExtents()[1] - y0 || actualSize > stack.getExtents()[2] - x0)
+    {
+        std::cerr << "Region [" << x0 << ", " << y0 << "] size " << actualSize << " exceeds the images ("
+                  << stack.getExtents()[2] << "x" << stack.getExtents()[1] << ")" << std::endl;
+        return 1;
+    }
     std::cout << "Processing " << (lastIdx - firstIdx + 1) << " images with region: [" << x0 << ", " << y0 << "] size " << actualSize << std::endl;
-    auto imgView = LiFFT::types::makeView(img, makeRange(Vec2(x0, y0), Vec2(actualSize, actualSize)));
+    stack.setRegion(Vec2(y0, x0), Vec2(actualSize, actualSize));
     using FFT = LiFFT::FFT_3D_R2C<FP_Type>;
-    auto input = FFT::wrapInput(
-                    LiFFT::mem::RealContainer<3, FP_Type>(
-                            LiFFT::types::Vec<3>(lastIdx-firstIdx+1, actualSize, actualSize)
-                    )
-                 );
+    auto input = FFT::wrapInput(LiFFT::mem::RealContainer<3, FP_Type>(stack.getExtents()));
     auto output = FFT::createNewOutput(input);
     auto diff = std::chrono::high_resolution_clock::now() - start;
     auto sec = std::chrono::duration_cast<std::chrono::seconds>(diff);
@@ -169,18 +211,9 @@ main(int argc, char** argv)
     sec = std::chrono::duration_cast<std::chrono::seconds>(diff);
     std::cout << "FFT initialized: " << sec.count() << "s" << std::endl;
 
-    // Now copy all the data into one memory region
+    // Now decode all images directly into the FFT input (no intermediate image buffers)
     start = std::chrono::high_resolution_clock::now();
-    auto inputView = LiFFT::types::makeSliceView<0>(input, makeRange());
-    LiFFT::policies::copy(imgView, inputView);
-    for(unsigned i=firstIdx+1; i<=lastIdx; ++i)
-    {
-        curFilePath = replace(inFilePath, "%i", getFilledNumber(i, minSize, filler));
-        imgView.getBase().open(curFilePath);
-        auto view = LiFFT::types::makeSliceView<0>(input, makeRange(Vec3(i-firstIdx, 0u, 0u)));
-        LiFFT::policies::copy(imgView, view);
-    }
-    img.close();
+    stack.materialize(input.getBase());
     diff = std::chrono::high_resolution_clock::now() - start;
     sec = std::chrono::duration_cast<std::chrono::seconds>(diff);
     std::cout << "Data loaded: " << sec.count() << "s" << std::endl;
@@ -199,7 +232,7 @@ main(int argc, char** argv)
     auto acc = LiFFT::accessors::makeTransformAccessorFor(LiFFT::policies::CalcIntensityFunc(), outView);
     auto accImg = LiFFT::accessors::makeTransposeAccessorFor(outImg);
     LiFFT::policies::copy(outView, outImg , acc, accImg);
-    outImg.save();
+    outImg.save(writeOptions);
     diff = std::chrono::high_resolution_clock::now() - start;
     sec = std::chrono::duration_cast<std::chrono::seconds>(diff);
     std::cout << "Image saved: " << sec.count() << "s" << std::endl;
@@ -0,0 +1,72 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#pragma once
+
+/**
+ * LiFFT_X86_DISPATCH is defined if vectorized x86 code can be compiled per function (see LiFFT_TARGET)
+ * independent of the compiler flags and selected at runtime with \ref LiFFT::getCpuFeatures
+ */
+#if !defined(__CUDACC__) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define LiFFT_X86_DISPATCH
+#   define LiFFT_TARGET(isa) __attribute__((target(isa)))
+#   include <immintrin.h>
+#endif
+
+namespace LiFFT {
+
+    /**
+     * Instruction set extensions supported by the CPU the program runs on
+     */
+    struct CpuFeatures
+    {
+        bool sse2 = false;
+        bool ssse3 = false;
+        bool avx2 = false;
+        bool f16c = false;
+        bool avx512f = false;
+    };
+
+    /**
+     * Queries the CPU for its features (all false if runtime dispatch is not supported)
+     */
+    inline CpuFeatures
+    detectCpuFeatures()
+    {
+        CpuFeatures features;
+#if defined(LiFFT_X86_DISPATCH)
+        __builtin_cpu_init();
+        features.sse2 = __builtin_cpu_supports("sse2");
+        features.ssse3 = __builtin_cpu_supports("ssse3");
+        features.avx2 = __builtin_cpu_supports("avx2");
+        features.f16c = features.avx2 && __builtin_cpu_supports("f16c");
+        features.avx512f = __builtin_cpu_supports("avx512f");
+#endif
+        return features;
+    }
+
+    /**
+     * Returns the features of the CPU, detected once on first use
+     */
+    inline const CpuFeatures&
+    getCpuFeatures()
+    {
+        static const CpuFeatures features = detectCpuFeatures();
+        return features;
+    }
+
+}  // namespace LiFFT
@@ -22,6 +22,7 @@
 #include "libLiFFT/FFT_Definition.hpp"
 #include "libLiFFT/FFT_LibPtrWrapper.hpp"
 #include "libLiFFT/FFT_DataWrapper.hpp"
+#include "libLiFFT/Normalization.hpp"
 #include <boost/mpl/apply.hpp>
 #include <type_traits>
 
@@ -40,6 +41,8 @@ namespace LiFFT {
      *      2) Execute the FFT with <fftInstance>(input, output), which performs the transform
      *         from the memories in the wrappers. If the base accessors of the wrappers do not return a reference type
      *         internal memory is allocated and data is copied before/after the FFT
+     *      3) Optionally a Normalization can be passed to the constructor. The scaling is applied during the
+     *         copies from 2) if there are any, otherwise the output is scaled in-place after the transform
      *
      * Parameters:
      * \tparam T_Library FFT Library to use
@@ -76,64 +79,89 @@ namespace LiFFT {
         static constexpr bool isInplace = FFT_Properties::isInplace;
 
         ActLibrary m_lib;
+        Normalization m_normalization;
+
+        /**
+         * Returns the factor the result has to be scaled with
+         * Must be called after the full extents are set
+         */
+        double
+        getScale(const Input& input) const
+        {
+            return m_normalization.getFactor(policies::getNumElementsFromExtents(input.getFullExtents()));
+        }
+
+        /**
+         * Returns true if the scaling should be done on the output,
+         * false if it can be folded into the copy of the input (and the output is not copied)
+         */
+        static bool
+        scaleOutput(const Input& input, const Output& output)
+        {
+            return output.usesInternalMemory() || !input.usesInternalMemory();
+        }
     public:
 
-        explicit FFT(Input& input, Output& output)
-        : m_lib(input, output)
+        explicit FFT(Input& input, Output& output, const Normalization& normalization = Normalization())
+        : m_lib(input, output), m_normalization(normalization)
         {
             static_assert(!isInplace, "Must not be called for inplace transforms");
         }
 
-        explicit FFT(Input& inOut)
-        : m_lib(inOut)
+        explicit FFT(Input& inOut, const Normalization& normalization = Normalization())
+        : m_lib(inOut), m_normalization(normalization)
         {
             static_assert(isInplace, "Must not be called for out-of-place transforms");
         }
 
         template<typename T=int, typename EnableIfQueuePresentAndOutplace<T>::type=0 >
-        explicit FFT(Input& input, Output& output, T_Queue& queue)
-        : m_lib(input, output, queue)
+        explicit FFT(Input& input, Output& output, T_Queue& queue, const Normalization& normalization = Normalization())
+        : m_lib(input, output, queue), m_normalization(normalization)
         {
             static_assert(!isInplace, "Must not be called for inplace transforms");
         }
 
         template<typename T=int, typename EnableIfQueuePresentAndInplace<T>::type=0 >
-        explicit FFT(Input& inOut, T_Queue& queue)
-        : m_lib(inOut, queue)
+        explicit FFT(Input& inOut, T_Queue& queue, const Normalization& normalization = Normalization())
+        : m_lib(inOut, queue), m_normalization(normalization)
         {
             static_assert(isInplace, "Must not be called for out-of-place transforms");
         }
 
         FFT(FFT&& obj)
-        : m_lib(std::move(obj.m_lib))
+        : m_lib(std::move(obj.m_lib)), m_normalization(obj.m_normalization)
         {}
 
         template<typename T=int, typename EnableIfNoQueueAndOutplace<T>::type=0 >
         void operator()(Input& input, Output& output)
         {
             static_assert(!isInplace, "Must not be called for inplace transforms");
-            // Set full extents for C2R/R2C (rest is set in constructor)
-            if(FFT_Def::kind == FFT_Kind::Complex2Real)
+            // Set full extents for C2R/R2C (rest is set in constructor, static extents are always known)
+            if(FFT_Def::kind == FFT_Kind::Complex2Real && !FFT_Def::hasStaticExtents)
                 input.setFullExtents(output.getExtents());
-            else if(FFT_Def::kind == FFT_Kind::Real2Complex)
+            else if(FFT_Def::kind == FFT_Kind::Real2Complex && !FFT_Def::hasStaticExtents)
                 output.setFullExtents(input.getExtents());
-            input.preProcess();
+            const double scale = getScale(input);
+            const bool scaleOut = scaleOutput(input, output);
+            input.preProcess(scaleOut ? 1 : scale);
             m_lib(input, output);
-            output.postProcess();
+            output.postProcess(scaleOut ? scale : 1, m_normalization.numThreads);
         }
 
         template<typename T=int, typename EnableIfQueuePresentAndOutplace<T>::type=0 >
         void operator()(Input& input, Output& output, T_Queue& queue)
         {
             static_assert(!isInplace, "Must not be called for inplace transforms");
-            // Set full extents for C2R/R2C (rest is set in constructor)
-            if(FFT_Def::kind == FFT_Kind::Complex2Real)
+            // Set full extents for C2R/R2C (rest is set in constructor, static extents are always known)
+            if(FFT_Def::kind == FFT_Kind::Complex2Real && !FFT_Def::hasStaticExtents)
                 input.setFullExtents(output.getExtents());
-            else if(FFT_Def::kind == FFT_Kind::Real2Complex)
+            else if(FFT_Def::kind == FFT_Kind::Real2Complex && !FFT_Def::hasStaticExtents)
                 output.setFullExtents(input.getExtents());
-            input.preProcess();
+            const double scale = getScale(input);
+            const bool scaleOut = scaleOutput(input, output);
+            input.preProcess(scaleOut ? 1 : scale);
             m_lib(input, output, queue);
-            output.postProcess();
+            output.postProcess(scaleOut ? scale : 1, m_normalization.numThreads);
         }
 
         template<typename T=int, typename EnableIfNoQueueAndInplace<T>::type=0 >
@@ -142,7 +170,7 @@ namespace LiFFT {
             static_assert(isInplace, "Must not be called for out-of-place transforms");
             inout.preProcess();
             m_lib(inout);
-            inout.postProcess();
+            inout.postProcess(getScale(inout), m_normalization.numThreads);
         }
 
         template<typename T=int, typename EnableIfQueuePresentAndInplace<T>::type=0 >
@@ -151,7 +179,7 @@ namespace LiFFT {
             static_assert(isInplace, "Must not be called for out-of-place transforms");
             inout.preProcess();
             m_lib(inout, queue);
-            inout.postProcess();
+            inout.postProcess(getScale(inout), m_normalization.numThreads);
         }
     };
 
@@ -159,12 +187,13 @@ namespace LiFFT {
         class T_Library,
         bool T_constructWithReadOnly = true,
         typename T_InputWrapper,
-        typename T_OutputWrapper
+        typename T_OutputWrapper,
+        typename = std::enable_if_t< !std::is_same< T_OutputWrapper, Normalization >::value >
         >
     FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly >
-    makeFFT(T_InputWrapper& input, T_OutputWrapper& output)
+    makeFFT(T_InputWrapper& input, T_OutputWrapper& output, const Normalization& normalization = Normalization())
     {
-        return FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly >(input, output);
+        return FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly >(input, output, normalization);
     }
 
     template<
@@ -173,9 +202,9 @@ namespace LiFFT {
         typename T_DataWrapper
         >
     FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly >
-    makeFFT(T_DataWrapper& input)
+    makeFFT(T_DataWrapper& input, const Normalization& normalization = Normalization())
     {
-        return FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly >(input);
+        return FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly >(input, normalization);
     }
 
     template<
@@ -186,9 +215,9 @@ namespace LiFFT {
         typename T_OutputWrapper
         >
     FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly, T_Queue >
-    makeFFTInQueue(T_InputWrapper& input, T_OutputWrapper& output, T_Queue& queue)
+    makeFFTInQueue(T_InputWrapper& input, T_OutputWrapper& output, T_Queue& queue, const Normalization& normalization = Normalization())
     {
-        return FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly, T_Queue >(input, output, queue);
+        return FFT< T_Library, T_InputWrapper, T_OutputWrapper, T_constructWithReadOnly, T_Queue >(input, output, queue, normalization);
     }
 
     template<
@@ -198,9 +227,9 @@ namespace LiFFT {
         typename T_DataWrapper
         >
     FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly, T_Queue >
-    makeFFTInQueue(T_DataWrapper& input, T_Queue& queue)
+    makeFFTInQueue(T_DataWrapper& input, T_Queue& queue, const Normalization& normalization = Normalization())
     {
-        return FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly, T_Queue >(input, queue);
+        return FFT< T_Library, T_DataWrapper, T_DataWrapper, T_constructWithReadOnly, T_Queue >(input, queue, normalization);
     }
 
 
@@ -27,11 +27,13 @@
 #include "libLiFFT/mem/ComplexAoSValues.hpp"
 #include "libLiFFT/mem/ComplexSoAValues.hpp"
 #include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/BufferPool.hpp"
 #include "libLiFFT/traits/IdentityAccessor.hpp"
 #include "libLiFFT/traits/IsDeviceMemory.hpp"
 #include "libLiFFT/types/SymmetricWrapper.hpp"
 #include "libLiFFT/c++14_types.hpp"
 #include "libLiFFT/FFT_Memory.hpp"
+#include "libLiFFT/Normalization.hpp"
 #include <type_traits>
 #include <functional>
 
@@ -164,16 +166,18 @@ namespace LiFFT {
         static constexpr bool isStrided = !needOwnMemoryPtr && traits::IsStrided< Base >::value;
         using IsDeviceMemory = traits::IsDeviceMemory< Base >;
 
+        // Internal buffers are recycled between wrappers and aligned so the library can use its SIMD code paths
+        using Allocator = mem::PoolAllocator;
         using Memory_t = mem::DataContainer<
                              numDims,
                              std::conditional_t<
                                  isComplex,
                                  std::conditional_t<
                                      isAoS,
-                                     mem::ComplexAoSValues<PrecisionType, needOwnMemoryPtr>,
-                                     mem::ComplexSoAValues<PrecisionType, needOwnMemoryPtr>
+                                     mem::ComplexAoSValues<PrecisionType, needOwnMemoryPtr, Allocator>,
+                                     mem::ComplexSoAValues<PrecisionType, needOwnMemoryPtr, Allocator>
                                  >,
-                                 mem::RealValues<PrecisionType, needOwnMemoryPtr>
+                                 mem::RealValues<PrecisionType, needOwnMemoryPtr, Allocator>
                              >
                          >;
         using MemoryFallback_t = mem::DataContainer<
@@ -182,10 +186,10 @@ namespace LiFFT {
                                  isComplex,
                                  std::conditional_t<
                                      isAoS,
-                                     mem::ComplexAoSValues<PrecisionType>,
-                                     mem::ComplexSoAValues<PrecisionType>
+                                     mem::ComplexAoSValues<PrecisionType, true, Allocator>,
+                                     mem::ComplexSoAValues<PrecisionType, true, Allocator>
                                  >,
-                                 mem::RealValues<PrecisionType>
+                                 mem::RealValues<PrecisionType, true, Allocator>
                              >
                          >;
         using Memory = detail::FFT_Memory< Memory_t, needOwnMemoryPtr >;
@@ -231,6 +235,7 @@ namespace LiFFT {
                 m_fullExtents = m_extents;
             else
                 m_fullExtents = m_fullExtents.all(0);
+            initStaticExtents(std::integral_constant< bool, FFT_Def::hasStaticExtents >());
             if(m_memory.checkPtr(m_base, m_acc, FFT_Def::isInplace && !isComplex))
                 m_memFallback = nullptr;
             else if(FFT_Def::isInplace)
@@ -265,6 +270,7 @@ namespace LiFFT {
                 m_fullExtents = m_extents;
                 m_fullExtents[numDims - 1] = fullSizeLastDim;
             }
+            initStaticExtents(std::integral_constant< bool, FFT_Def::hasStaticExtents >());
 
             m_memory.init(m_extents);
             if(m_memory.checkPtr(m_base, m_acc, FFT_Def::isInplace && !isComplex))
@@ -369,39 +375,126 @@ namespace LiFFT {
             return policies::getNumElementsFromExtents(m_extents);
         }
 
+        /**
+         * Returns true if the data is copied from/to internal memory before/after the FFT
+         */
+        bool
+        usesInternalMemory() const
+        {
+            return needOwnMemoryPtr || m_memFallback;
+        }
+
         /**
          * Internal method. Called before each FFT for input
          * Copies data to internal memory if required
+         *
+         * @param scale Factor the data is multiplied with during the copy. Ignored if no copy is done
          */
         void
-        preProcess()
+        preProcess(double scale = 1)
         {
             if(isInput)
             {
                 if(m_memFallback)
-                    m_memFallback->copyFrom(m_base, m_acc);
+                    m_memFallback->copyFrom(m_base, m_acc, scale);
                 else
-                    m_memory.copyFrom(m_base, m_acc);
+                    m_memory.copyFrom(m_base, m_acc, scale);
             }
             Parent::preProcess();
         }
 
         /**
-         * Internal method. Called after each FFT for output wrappers
+         * Internal method. Called after each FFT for output wrappers (and the input of inplace FFTs)
          * Copies data from internal memory if required
+         *
+         * @param scale Factor the result is multiplied with, during the copy or in-place if no copy is done
+         * @param numThreads Number of threads used for in-place scaling, 0 for all hardware threads
          */
         void
-        postProcess()
+        postProcess(double scale = 1, unsigned numThreads = 0)
         {
             if(!isInput)
             {
                 if(m_memFallback)
-                    m_memFallback->copyTo(m_base, m_acc);
-                else
-                    m_memory.copyTo(m_base, m_acc);
-            }
+                    m_memFallback->copyTo(m_base, m_acc, scale);
+                else if(usesInternalMemory())
+                    m_memory.copyTo(m_base, m_acc, scale);
+                else if(scale != 1)
+                    scaleData(scale, numThreads);
+            }else if(FFT_Def::isInplace && scale != 1)
+                scaleData(scale, numThreads);
             Parent::postProcess();
         }
+
+    private:
+        /**
+         * For FFTs with static extents: Checks the extents of the base container and sets the full extents
+         * so they are known at planning time (also for C2R inputs)
+         */
+        void
+        initStaticExtents(std::false_type)
+        {}
+
+        void
+        initStaticExtents(std::true_type)
+        {
+            using FullExtents = typename FFT_Def::StaticExtents;
+            using ExpectedExtents = std::conditional_t< isHalfData, typename FFT_Def::StaticHalfExtents, FullExtents >;
+            checkStaticExtents< ExpectedExtents >(traits::HasStaticExtents<Base>());
+            for(unsigned i = 0; i < numDims; ++i)
+                m_fullExtents[i] = FullExtents()[i];
+        }
+
+        template< class T_Expected >
+        void
+        checkStaticExtents(std::true_type) const
+        {
+            static_assert(std::is_same< typename Base::StaticExtents, T_Expected >::value, "Extents do not match the static extents of the FFT");
+        }
+
+        template< class T_Expected >
+        void
+        checkStaticExtents(std::false_type) const
+        {
+            for(unsigned i = 0; i < numDims; ++i)
+                if(m_extents[i] != T_Expected()[i])
+                    throw std::runtime_error("Dimension " + std::to_string(i) + ": Extents do not match the static extents of the FFT");
+        }
+
+        /**
+         * Scales the data at getDataPtr() in-place
+         * For inplace FFTs this is the output of the FFT which might differ in type and size from the input
+         */
+        void
+        scaleData(double scale, unsigned numThreads)
+        {
+            size_t numValues;
+            if(FFT_Def::isInplace)
+            {
+                // Output of inplace FFTs: Always AoS complex values (C2R output is padded the same way)
+                Extents extents = m_fullExtents;
+                if(FFT_Def::kind != FFT_Kind::Complex2Complex)
+                    extents[numDims - 1] = extents[numDims - 1] / 2 + 1;
+                numValues = policies::getNumElementsFromExtents(extents) * 2;
+            }else
+                numValues = getNumElements() * ((isComplex && isAoS) ? 2 : 1);
+            scalePtr(getDataPtr(), numValues, static_cast<PrecisionType>(scale), numThreads);
+        }
+
+        template< typename T >
+        static void
+        scalePtr(T* ptr, size_t numValues, PrecisionType scale, unsigned numThreads)
+        {
+            detail::scaleInplace(reinterpret_cast<PrecisionType*>(ptr), numValues, scale, numThreads);
+        }
+
+        template< typename T >
+        static void
+        scalePtr(std::pair<T*, T*> ptr, size_t numValues, PrecisionType scale, unsigned numThreads)
+        {
+            scalePtr(ptr.first, numValues, scale, numThreads);
+            scalePtr(ptr.second, numValues, scale, numThreads);
+        }
     };
 
     template< class T_FFT_Def, // FFT_Definition (FFT attributes)
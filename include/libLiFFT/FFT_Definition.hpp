@@ -25,6 +25,7 @@
 #include "libLiFFT/FFT_InplaceOutput.hpp"
 #include "libLiFFT/types/View.hpp"
 #include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/BufferPool.hpp"
 #include "libLiFFT/mem/RealValues.hpp"
 #include "libLiFFT/mem/ComplexAoSValues.hpp"
 
@@ -32,6 +33,39 @@ namespace LiFFT {
 
     namespace detail {
 
+        /**
+         * Creates a container with the given extents (which are implicit for containers with static extents)
+         */
+        template< class T_Container, class T_Extents >
+        std::enable_if_t< !LiFFT::traits::HasStaticExtents<T_Container>::value, T_Container >
+        createContainer(const T_Extents& extents)
+        {
+            return T_Container(extents);
+        }
+
+        template< class T_Container, class T_Extents >
+        std::enable_if_t< LiFFT::traits::HasStaticExtents<T_Container>::value, T_Container >
+        createContainer(const T_Extents& /*extents*/)
+        {
+            return T_Container();
+        }
+
+        /**
+         * Extents of the complex (half) side of R2C/C2R transforms with static extents
+         */
+        template< class T_Extents, bool T_isHalf >
+        struct StaticFFT_Extents
+        {
+            using type = T_Extents;
+        };
+
+        template< unsigned... T_extents >
+        struct StaticFFT_Extents< types::StaticExtents< T_extents... >, true >
+        {
+            using Extents = types::StaticExtents< T_extents... >;
+            using type = typename types::ReplaceLastExtent< Extents, Extents::get(Extents::numDims - 1) / 2 + 1 >::type;
+        };
+
         // Real inplace input
         template<
             class T_FFT_Def,
@@ -43,18 +77,23 @@ namespace LiFFT {
             using FFT_Def = T_FFT_Def;
             using Precision = typename FFT_Def::PrecisionType;
             static constexpr unsigned numDims = FFT_Def::numDims;
+            using Allocator = mem::PoolAllocator;
 
-            using Data = mem::DataContainer<numDims, mem::RealValues<Precision> >;
+            using Data = mem::DataContainer<numDims, mem::RealValues<Precision, true, Allocator> >;
+            using Extents = types::Vec<numDims>;
 
             template<class T_Extents>
             static auto
             create(const T_Extents& extents)
-            -> decltype( types::makeView(Data(extents), types::makeRange(types::Origin(), extents)) )
+            -> decltype( types::makeView(Data(std::declval<Extents>()), types::makeRange(types::Origin(), std::declval<Extents>())) )
             {
-                T_Extents bigExtents = extents;
+                Extents bigExtents;
+                for(unsigned i = 0; i < numDims; ++i)
+                    bigExtents[i] = extents[i];
+                const Extents realExtents = bigExtents;
                 // We need some padding: row size is (n / 2 + 1) complex elements. 1 complex element = 2 real elements
                 bigExtents[numDims - 1] = (bigExtents[numDims - 1] / 2 + 1) * 2;
-                return types::makeView(Data(bigExtents), types::makeRange(types::Origin(), extents));
+                return types::makeView(Data(bigExtents), types::makeRange(types::Origin(), realExtents));
             }
         };
 
@@ -65,14 +104,20 @@ namespace LiFFT {
             using FFT_Def = T_FFT_Def;
             using Precision = typename FFT_Def::PrecisionType;
             static constexpr unsigned numDims = FFT_Def::numDims;
+            using Allocator = mem::PoolAllocator;
 
-            using Data = mem::DataContainer<numDims, mem::RealValues<Precision> >;
+            template<class T_Extents>
+            using Data = std::conditional_t<
+                            types::IsStaticExtents<T_Extents>::value,
+                            mem::StaticDataContainer< mem::RealValues<Precision, true, Allocator>, T_Extents >,
+                            mem::DataContainer< numDims, mem::RealValues<Precision, true, Allocator> >
+                         >;
 
             template<class T_Extents>
-            static Data
+            static Data<T_Extents>
             create(const T_Extents& extents)
             {
-                return Data(extents);
+                return detail::createContainer< Data<T_Extents> >(extents);
             }
         };
 
@@ -86,14 +131,20 @@ namespace LiFFT {
             using FFT_Def = T_FFT_Def;
             using Precision = typename FFT_Def::PrecisionType;
             static constexpr unsigned numDims = FFT_Def::numDims;
+            using Allocator = mem::PoolAllocator;
 
-            using Data = mem::DataContainer<numDims, mem::ComplexAoSValues<Precision> >;
+            template<class T_Extents>
+            using Data = std::conditional_t<
+                            types::IsStaticExtents<T_Extents>::value,
+                            mem::StaticDataContainer< mem::ComplexAoSValues<Precision, true, Allocator>, T_Extents >,
+                            mem::DataContainer< numDims, mem::ComplexAoSValues<Precision, true, Allocator> >
+                         >;
 
             template<class T_Extents>
-            static Data
+            static Data<T_Extents>
             create(const T_Extents& extents)
             {
-                return Data(extents);
+                return detail::createContainer< Data<T_Extents> >(extents);
             }
         };
 
@@ -113,8 +164,8 @@ namespace LiFFT {
                     FFT_Def,
                     std::conditional_t<
                         isComplexOutput,
-                        mem::ComplexContainer< T_Wrapper::numDims, typename T_Wrapper::PrecisionType >,
-                        mem::RealContainer< T_Wrapper::numDims, typename T_Wrapper::PrecisionType >
+                        mem::ComplexContainer< T_Wrapper::numDims, typename T_Wrapper::PrecisionType, false, mem::PoolAllocator >,
+                        mem::RealContainer< T_Wrapper::numDims, typename T_Wrapper::PrecisionType, false, mem::PoolAllocator >
                     >,
                     std::true_type
                 >;
@@ -207,13 +258,15 @@ namespace LiFFT {
      * \tparam T_PrecisionType Base type to use (float, double, ...)
      * \tparam T_IsFwd Whether to perform a forward FFT. Can be left at AutoDetect so it is true for Real-Complex and false for Complex-Real
      * \tparam T_isInplace Whether to perform the FFT inplace, that is, it does not allocate separate memory for the output
+     * \tparam T_StaticExtents types::StaticExtents with the (real space) extents if they are known at compile time, void otherwise
      */
     template<
         FFT_Kind T_kind,
         unsigned T_numDims,
         typename T_PrecisionType,
         class T_IsFwd = AutoDetect,
-        bool T_isInplace = false
+        bool T_isInplace = false,
+        class T_StaticExtents = void
         >
     struct FFT_Definition
     {
@@ -222,6 +275,21 @@ namespace LiFFT {
         using PrecisionType = T_PrecisionType;
         using IsFwd = T_IsFwd;
         static constexpr bool isInplace = T_isInplace;
+        using StaticExtents = T_StaticExtents;
+        static constexpr bool hasStaticExtents = !std::is_void<StaticExtents>::value;
+        static_assert(!hasStaticExtents || types::IsStaticExtents<StaticExtents>::value, "Static extents must be of type types::StaticExtents");
+        static_assert(!hasStaticExtents || traits::NumDims<std::conditional_t<hasStaticExtents, StaticExtents, types::Vec<numDims>>>::value == numDims,
+                "Wrong number of dimensions for the static extents");
+        /**
+         * Static extents of the complex side of a R2C/C2R transform (last dimension is n/2+1), void if not static
+         */
+        using StaticHalfExtents = typename detail::StaticFFT_Extents< StaticExtents, kind != FFT_Kind::Complex2Complex >::type;
+
+        /**
+         * The same FFT with extents fixed at compile time (types::StaticExtents)
+         */
+        template< class T_Extents >
+        using WithExtents = FFT_Definition< kind, numDims, PrecisionType, IsFwd, isInplace, T_Extents >;
 
         static constexpr bool autoDetectIsFwd = std::is_same< T_IsFwd, AutoDetect >::value;
         static_assert(
@@ -407,6 +475,18 @@ namespace LiFFT {
             return wrapInput(CreateFFT_Input::create(extents));
         }
 
+        /**
+         * Creates a new input for FFTs with static extents
+         * The container has its extents fixed at compile time too (except for inplace R2C transforms which need padding)
+         */
+        template< typename T_Extents = std::conditional_t< kind == FFT_Kind::Complex2Real, StaticHalfExtents, StaticExtents > >
+        static auto
+        createNewInput()
+        -> decltype(wrapInput(CreateFFT_Input::create(T_Extents())))
+        {
+            return wrapInput(CreateFFT_Input::create(T_Extents()));
+        }
+
         /**
          * Gets an instance of a FFT_OutputDataWrapper for the given
          * @param fftInput InputDataWrapper
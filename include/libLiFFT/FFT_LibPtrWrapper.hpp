@@ -254,12 +254,21 @@ namespace LiFFT {
             return policies::getNumElementsFromExtents(m_extents);
         }
 
+        /**
+         * Returns true if the data is copied from/to internal memory before/after the FFT
+         */
+        bool
+        usesInternalMemory() const
+        {
+            return false;
+        }
+
         /**
          * Internal method. Called before each FFT for input
          * Copies data to internal memory if required
          */
         void
-        preProcess()
+        preProcess(double = 1)
         {
             Parent::preProcess();
         }
@@ -267,10 +276,14 @@ namespace LiFFT {
         /**
          * Internal method. Called after each FFT for output wrappers
          * Copies data from internal memory if required
+         *
+         * @param scale Normalization factor, the library pointer lives on the device so only 1 is supported
          */
         void
-        postProcess()
+        postProcess(double scale = 1, unsigned = 0)
         {
+            if(scale != 1)
+                throw std::runtime_error("Normalization is not supported for library pointers");
             Parent::postProcess();
         }
     };
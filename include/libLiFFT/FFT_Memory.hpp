@@ -22,6 +22,7 @@
 #include "libLiFFT/traits/GetMemSize.hpp"
 #include "libLiFFT/policies/GetExtents.hpp"
 #include "libLiFFT/accessors/ConvertAccessor.hpp"
+#include "libLiFFT/Normalization.hpp"
 #include <algorithm>
 
 namespace LiFFT {
@@ -42,6 +43,7 @@ namespace detail {
 
         using MemAcc = traits::IdentityAccessor_t< Memory >;
         using DataType = std::remove_reference_t< std::result_of_t< MemAcc(types::Vec<numDims>&, Memory&) > >;
+        using Precision = traits::IntegralType_t< DataType >;
 
         Memory m_data;
 
@@ -85,6 +87,25 @@ namespace detail {
             copy(obj, m_data);
         }
 
+        /**
+         * Copies data from the given object into this memory and scales it on the fly
+         *
+         * @param obj Object to read from
+         * @param acc Accessor to access the elements
+         * @param scale Factor all values are multiplied with
+         */
+        template< class T_Obj, class T_Acc >
+        void
+        copyFrom(T_Obj& obj, T_Acc&& acc, double scale)
+        {
+            if(scale == 1)
+                return copyFrom(obj, std::forward<T_Acc>(acc));
+            using PlainAcc = std::remove_cv_t< std::remove_reference_t< T_Acc > >;
+            using ScaleAcc = ScaleAccessor< PlainAcc, Precision >;
+            auto copy = policies::makeCopy(ScaleAcc(std::forward<T_Acc>(acc), scale), MemAcc());
+            copy(obj, m_data);
+        }
+
         /**
          * Copies data from this memory to the given object
          *
@@ -107,6 +128,33 @@ namespace detail {
             copy(m_data, obj);
         }
 
+        /**
+         * Copies data from this memory to the given object and scales it on the fly
+         *
+         * @param obj Object to write to
+         * @param acc Accessor to access the elements
+         * @param scale Factor all values are multiplied with
+         */
+        template< class T_Obj, class T_Acc >
+        void
+        copyTo(T_Obj& obj, T_Acc&& acc, double scale) const
+        {
+            if(scale == 1)
+                return copyTo(obj, std::forward<T_Acc>(acc));
+            using ScaleAcc = ScaleAccessor< MemAcc, Precision >;
+            using ScaledType = std::result_of_t< ScaleFunc<Precision>(DataType&) >;
+            using ObjDataType = std::remove_reference_t< std::result_of_t< T_Acc(types::Vec<numDims>&, T_Obj&) > >;
+            using PlainAcc = std::remove_cv_t< std::remove_reference_t< T_Acc > >;
+            using AccDst = std::conditional_t<
+                    traits::IsBinaryCompatible<ScaledType, ObjDataType>::value &&
+                        !std::is_same<ScaledType, ObjDataType>::value,
+                    accessors::ConvertAccessor<PlainAcc, ScaledType>,
+                    PlainAcc>;
+
+            auto copy = policies::makeCopy(ScaleAcc(MemAcc(), scale), AccDst(std::forward<T_Acc>(acc)));
+            copy(m_data, obj);
+        }
+
         /**
          * Checks whether the pointer(s) is/are valid for use. That is they point to contiguous memory
          * @return
@@ -161,7 +209,7 @@ namespace detail {
             Ptr startPtr = doGetPtr(obj, acc, idx);
             policies::GetExtents<T_Obj> extents(obj);
             // Basically set check dimensions to the end-index and check if the returned pointer matches the expected one
-            unsigned factor = 1;
+            size_t factor = 1;
             for(unsigned i=numDims; i>0; --i)
             {
                 unsigned j = i-1;
@@ -219,7 +267,7 @@ namespace detail {
             Ptr startPtr = doGetPtr(obj, acc, idx);
             policies::GetExtents<T_Obj> extents(obj);
             // Basically set check dimensions to the end-index and check if the returned pointer matches the expected one
-            unsigned factor = 1;
+            size_t factor = 1;
             for(unsigned i=numDims-1; i>0; --i)
             {
                 startPtr.first  += extents[i] * factor;
@@ -249,9 +297,15 @@ namespace detail {
         template< class T_Obj, class T_Acc >
         void copyFrom(T_Obj&, T_Acc&){}
 
+        template< class T_Obj, class T_Acc >
+        void copyFrom(T_Obj&, T_Acc&, double){}
+
         template< class T_Obj, class T_Acc >
         void copyTo(T_Obj&, T_Acc&){}
 
+        template< class T_Obj, class T_Acc >
+        void copyTo(T_Obj&, T_Acc&, double){}
+
         size_t
         getMemSize() const
         {
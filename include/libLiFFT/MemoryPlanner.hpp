@@ -0,0 +1,248 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/FFT_Kind.hpp"
+#include "libLiFFT/types/Vec.hpp"
+#include <cstddef>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#if defined(__unix__)
+#   include <unistd.h>
+#endif
+
+namespace LiFFT {
+
+    /**
+     * Bytes required to execute a FFT, split by their purpose
+     */
+    struct MemoryRequirements
+    {
+        /** Input data (including the row padding of inplace R2C/C2R transforms) */
+        size_t input = 0;
+        /** Output data, 0 for inplace transforms */
+        size_t output = 0;
+        /** Internal memory of the data wrappers used when the data cannot be passed directly to the library */
+        size_t staging = 0;
+        /** Additional host memory used by the FFT library (plans, scratch buffers) */
+        size_t workspace = 0;
+        /** Memory required on the device for GPU libraries (not included in getTotal) */
+        size_t device = 0;
+
+        /**
+         * Returns the total number of bytes required on the host
+         */
+        size_t
+        getTotal() const
+        {
+            return input + output + staging + workspace;
+        }
+    };
+
+    /**
+     * Describes how the data is passed to the FFT
+     */
+    struct MemoryStrategy
+    {
+        /** The input is not contiguous or its accessor does not return references, so it is copied to internal memory */
+        bool stageInput = false;
+        /** Same as stageInput for the output (out-of-place transforms only) */
+        bool stageOutput = false;
+    };
+
+    /**
+     * Result of \ref MemoryPlanner::choose
+     */
+    struct MemoryPlan
+    {
+        /** Whether the FFT should be executed inplace */
+        bool isInplace = false;
+        /** Number of slabs the first dimension is split into, 1 if the whole data fits at once */
+        size_t numSlabs = 1;
+        /** Extent of the first dimension of one slab */
+        size_t slabSize = 0;
+        /** Memory required for one slab */
+        MemoryRequirements requirements;
+    };
+
+namespace traits {
+
+    /**
+     * Adds the memory an FFT library allocates itself to the requirements
+     * The default assumes the library works on the passed memory only (which is true for FFTW)
+     * Specialize this for a library (the type passed to makeFFT) if it needs more
+     *
+     * \tparam T_Library FFT library
+     */
+    template< class T_Library >
+    struct LibraryMemory
+    {
+        /**
+         * @param fullExtents Extents of the transform in real space
+         * @param isInplace   Whether the transform is executed inplace
+         * @param req         Requirements of the data, workspace and device are updated
+         */
+        template< class T_FFT_Def, class T_Extents >
+        static void
+        add(const T_Extents& /*fullExtents*/, bool /*isInplace*/, MemoryRequirements& /*req*/)
+        {}
+    };
+
+}  // namespace traits
+
+    /**
+     * Calculates the memory required by a FFT before anything is allocated and chooses
+     * a configuration that fits into a given budget
+     *
+     * \tparam T_FFT_Def FFT_Definition
+     * \tparam T_Library FFT library, used to query the memory the library needs itself
+     */
+    template< class T_FFT_Def, class T_Library >
+    struct MemoryPlanner
+    {
+        using FFT_Def = T_FFT_Def;
+        using Library = T_Library;
+        static constexpr unsigned numDims = FFT_Def::numDims;
+        static constexpr FFT_Kind kind = FFT_Def::kind;
+        using Precision = typename FFT_Def::PrecisionType;
+        using Extents = types::Vec< numDims, size_t >;
+
+        /**
+         * Returns the memory required for the given extents
+         *
+         * @param fullExtents Extents of the transform in real space (that is the extents of the real data for R2C/C2R)
+         * @param isInplace   Whether the transform is executed inplace
+         * @param strategy    How the data is passed
+         * @return Required memory
+         */
+        template< class T_Extents >
+        static MemoryRequirements
+        getRequirements(const T_Extents& fullExtents, bool isInplace, const MemoryStrategy& strategy = MemoryStrategy())
+        {
+            size_t numElements = 1;
+            for(unsigned i = 0; i < numDims; ++i)
+                numElements *= fullExtents[i];
+            const size_t lastExtent = fullExtents[numDims - 1];
+            // Number of complex values of the half data of R2C/C2R transforms
+            const size_t numHalf = lastExtent ? numElements / lastExtent * (lastExtent / 2 + 1) : 0;
+            const size_t realBytes = numElements * sizeof(Precision);
+            const size_t complexBytes = (kind == FFT_Kind::Complex2Complex ? numElements : numHalf) * 2 * sizeof(Precision);
+
+            MemoryRequirements req;
+            if(isInplace)
+            {
+                // Real data is padded to the size of the complex data, internal memory cannot be used
+                req.input = complexBytes;
+            }else
+            {
+                req.input  = kind == FFT_Kind::Real2Complex ? realBytes : complexBytes;
+                req.output = kind == FFT_Kind::Complex2Real ? realBytes : complexBytes;
+                if(strategy.stageInput)
+                    req.staging += req.input;
+                if(strategy.stageOutput)
+                    req.staging += req.output;
+            }
+            traits::LibraryMemory< Library >::template add< FFT_Def >(fullExtents, isInplace, req);
+            return req;
+        }
+
+        /**
+         * Returns the memory required for the given extents with the inplace setting of the FFT_Definition
+         */
+        template< class T_Extents >
+        static MemoryRequirements
+        getRequirements(const T_Extents& fullExtents, const MemoryStrategy& strategy = MemoryStrategy())
+        {
+            return getRequirements(fullExtents, FFT_Def::isInplace, strategy);
+        }
+
+        /**
+         * Chooses a configuration such that the required memory does not exceed the budget
+         * Out-of-place is preferred over inplace, and both over splitting the data.
+         * If neither fits, the first dimension is split into the least number of slabs that fit.
+         * Note: Slabs are only meaningful if the data along the first dimension consists of independent
+         *       transforms (e.g. a stack of images), the caller then executes the FFT for each slab
+         *
+         * @param fullExtents Extents of the transform in real space
+         * @param budget      Available memory in bytes
+         * @param strategy    How the data is passed
+         * @param allowSlabs  Whether the data may be split, if false and nothing fits an exception is thrown
+         * @return Chosen configuration
+         */
+        template< class T_Extents >
+        static MemoryPlan
+        choose(const T_Extents& fullExtents, size_t budget, const MemoryStrategy& strategy = MemoryStrategy(), bool allowSlabs = false)
+        {
+            Extents extents;
+            for(unsigned i = 0; i < numDims; ++i)
+                extents[i] = fullExtents[i];
+            const size_t numRows = extents[0];
+            MemoryPlan plan;
+            // Try each distinct slab size from big to small: The next slab count is the least one that
+            // results in a smaller slab size than the current one
+            for(size_t numSlabs = 1; numSlabs <= numRows; numSlabs = (numRows + plan.slabSize - 2) / (plan.slabSize - 1))
+            {
+                plan.slabSize = (numRows + numSlabs - 1) / numSlabs;
+                plan.numSlabs = (numRows + plan.slabSize - 1) / plan.slabSize;
+                extents[0] = plan.slabSize;
+                for(bool isInplace: {false, true})
+                {
+                    plan.isInplace = isInplace;
+                    plan.requirements = getRequirements(extents, isInplace, strategy);
+                    if(plan.requirements.getTotal() <= budget)
+                        return plan;
+                }
+                if(!allowSlabs || plan.slabSize == 1)
+                    break;
+            }
+            throw std::runtime_error("FFT does not fit into the memory budget of " + std::to_string(budget) + " bytes");
+        }
+    };
+
+    /**
+     * Returns the physical memory currently available on the host in bytes or 0 if unknown
+     * This includes reclaimable memory like the page cache (MemAvailable on Linux)
+     */
+    inline size_t
+    getAvailableMemory()
+    {
+#if defined(__linux__)
+        std::ifstream meminfo("/proc/meminfo");
+        std::string key;
+        size_t value;
+        while(meminfo >> key >> value)
+        {
+            if(key == "MemAvailable:")
+                return value * 1024;
+            // Skip the unit
+            meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+#endif
+        // Fallback: Free memory only, without the reclaimable page cache
+#if defined(__unix__) && defined(_SC_AVPHYS_PAGES)
+        const long pages = sysconf(_SC_AVPHYS_PAGES);
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        if(pages > 0 && pageSize > 0)
+            return size_t(pages) * size_t(pageSize);
+#endif
+        return 0;
+    }
+
+}  // namespace LiFFT
@@ -0,0 +1,144 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include "libLiFFT/traits/IsComplex.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/types/Complex.hpp"
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include "libLiFFT/c++14_types.hpp"
+#include <cmath>
+
+namespace LiFFT {
+
+    /**
+     * Enum to define how the result of an FFT is scaled
+     */
+    enum class NormalizationMode
+    {
+        None,       // Unnormalized result (as returned by e.g. FFTW)
+        ByN,        // Scaled by 1/N where N is the number of (real space) elements
+        BySqrtN,    // Scaled by 1/sqrt(N) (unitary transform)
+        Custom      // Scaled by a user specified factor
+    };
+
+    /**
+     * Normalization of an FFT: Mode and (for the custom mode) the factor
+     * The scaling is folded into the copies to/from internal memory if those happen anyway,
+     * otherwise the output is scaled in-place after the transform using numThreads threads
+     */
+    struct Normalization
+    {
+        NormalizationMode mode;
+        double factor;
+        unsigned numThreads;
+
+        Normalization(NormalizationMode modeIn = NormalizationMode::None, double factorIn = 1, unsigned numThreadsIn = 0):
+            mode(modeIn), factor(factorIn), numThreads(numThreadsIn)
+        {}
+
+        static Normalization none(){ return Normalization(NormalizationMode::None); }
+        static Normalization byN(){ return Normalization(NormalizationMode::ByN); }
+        static Normalization bySqrtN(){ return Normalization(NormalizationMode::BySqrtN); }
+        static Normalization custom(double factorIn){ return Normalization(NormalizationMode::Custom, factorIn); }
+
+        /**
+         * Returns the factor the result needs to be multiplied with
+         *
+         * @param numElements Number of elements of the transform (real space)
+         */
+        double
+        getFactor(size_t numElements) const
+        {
+            switch(mode)
+            {
+            case NormalizationMode::ByN:
+                return 1. / numElements;
+            case NormalizationMode::BySqrtN:
+                return 1. / std::sqrt(static_cast<double>(numElements));
+            case NormalizationMode::Custom:
+                return factor;
+            default:
+                return 1;
+            }
+        }
+    };
+
+    namespace detail {
+
+        /**
+         * Functor that scales real and complex values by a constant factor
+         */
+        template< typename T_Precision >
+        struct ScaleFunc
+        {
+            T_Precision m_factor;
+
+            explicit ScaleFunc(T_Precision factor = 1): m_factor(factor){}
+
+            template< typename T, typename = std::enable_if_t< traits::IsComplex<T>::value > >
+            types::Complex<T_Precision>
+            operator()(const T& val) const
+            {
+                return types::Complex<T_Precision>(val.real * m_factor, val.imag * m_factor);
+            }
+
+            template< typename T, typename = std::enable_if_t< !traits::IsComplex<T>::value >, typename = void >
+            types::Real<T_Precision>
+            operator()(const T& val) const
+            {
+                return types::Real<T_Precision>(val * m_factor);
+            }
+        };
+
+        /**
+         * Accessor that scales all values returned by the base accessor
+         */
+        template< class T_BaseAccessor, typename T_Precision >
+        struct ScaleAccessor
+        {
+            T_BaseAccessor m_acc;
+            ScaleFunc<T_Precision> m_func;
+
+            template< class T >
+            ScaleAccessor(T&& acc, T_Precision factor): m_acc(std::forward<T>(acc)), m_func(factor){}
+
+            template< class T_Index, class T_Data >
+            auto
+            operator()(const T_Index& idx, T_Data& data)
+            -> decltype(m_func(m_acc(idx, data)))
+            {
+                return m_func(m_acc(idx, data));
+            }
+        };
+
+        /**
+         * Scales numElements contiguous values in-place
+         */
+        template< typename T >
+        void
+        scaleInplace(T* data, size_t numElements, T factor, unsigned numThreads)
+        {
+            policies::parallelFor(numElements, numThreads, 1 << 16, [data, factor](size_t begin, size_t end){
+                for(size_t i = begin; i < end; ++i)
+                    data[i] *= factor;
+            });
+        }
+
+    }  // namespace detail
+
+}  // namespace LiFFT
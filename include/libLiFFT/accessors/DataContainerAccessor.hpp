@@ -17,6 +17,7 @@
 #pragma once
 
 #include <libLiFFT/policies/flattenIdx.hpp>
+#include "libLiFFT/traits/AccessorTraits.hpp"
 #include "libLiFFT/c++14_types.hpp"
 #include "libLiFFT/util.hpp"
 
@@ -83,4 +84,14 @@ namespace accessors {
     };
 
 }  // namespace accessors
+
+namespace traits {
+
+    /**
+     * Flat memory is accessed via the flattened index, so a precomputed offset can be used directly
+     */
+    template< typename T_Data >
+    struct IsFlatOffsetAccessor< accessors::DataContainerAccessor<true>, T_Data >: std::true_type{};
+
+}  // namespace traits
 }  // namespace LiFFT
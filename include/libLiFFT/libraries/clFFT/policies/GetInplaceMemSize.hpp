@@ -46,7 +46,7 @@ namespace policies {
             extents[numDims - 1] = extents[numDims - 1] / 2 + 1;
           }
           // Get number of complex elements
-          unsigned numElements = LiFFT::policies::getNumElementsFromExtents(extents);
+          size_t numElements = LiFFT::policies::getNumElementsFromExtents(extents);
           return numElements * 2 * sizeof(T_Precision);
         }
     };
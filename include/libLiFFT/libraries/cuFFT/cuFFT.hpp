@@ -20,6 +20,9 @@
 #include "libLiFFT/libraries/cuFFT/policies/CudaMemCpy.hpp"
 #include "libLiFFT/libraries/cuFFT/policies/Planner.hpp"
 #include "libLiFFT/libraries/cuFFT/policies/ExecutePlan.hpp"
+#include "libLiFFT/libraries/cuFFT/traits/FFTType.hpp"
+#include "libLiFFT/MemoryPlanner.hpp"
+#include <algorithm>
 #include <boost/mpl/placeholders.hpp>
 
 namespace bmpl = boost::mpl;
@@ -120,4 +123,42 @@ namespace cuFFT {
 
 }  // namespace cuFFT
 }  // namespace libraries
+
+namespace traits {
+
+    /**
+     * cuFFT copies host data to device buffers and needs a work area on the device
+     */
+    template< class T_InplacePolicy, class T_Allocator, class T_Copier, class T_FFT_Properties >
+    struct LibraryMemory< libraries::cuFFT::CuFFT< T_InplacePolicy, T_Allocator, T_Copier, T_FFT_Properties > >
+    {
+        template< class T_FFT_Def, class T_Extents >
+        static void
+        add(const T_Extents& fullExtents, bool isInplace, MemoryRequirements& req)
+        {
+            using FFTType = libraries::cuFFT::traits::FFTType<
+                                typename T_FFT_Def::PrecisionType,
+                                T_FFT_Def::kind != FFT_Kind::Real2Complex,
+                                T_FFT_Def::kind != FFT_Kind::Complex2Real
+                            >;
+            constexpr unsigned numDims = T_FFT_Def::numDims;
+            // Assumes host data: One buffer on the device if the transform is executed inplace there
+            if(isInplace || T_InplacePolicy::value)
+                req.device += std::max(req.input, req.output);
+            else
+                req.device += req.input + req.output;
+            size_t workSize = 0;
+            cufftResult result;
+            if(numDims == 1)
+                result = cufftEstimate1d(fullExtents[0], FFTType::value, 1, &workSize);
+            else if(numDims == 2)
+                result = cufftEstimate2d(fullExtents[0], fullExtents[1], FFTType::value, &workSize);
+            else
+                result = cufftEstimate3d(fullExtents[0], fullExtents[1], fullExtents[2], FFTType::value, &workSize);
+            if(result == CUFFT_SUCCESS)
+                req.device += workSize;
+        }
+    };
+
+}  // namespace traits
 }  // namespace LiFFT
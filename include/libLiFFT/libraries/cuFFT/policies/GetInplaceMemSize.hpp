@@ -49,7 +49,7 @@ namespace policies {
             if(!isComplexIn || !isComplexOut)
                 extents[numDims - 1] = extents[numDims - 1] / 2 + 1;
             // Get number of complex elements
-            unsigned numElements = LiFFT::policies::getNumElementsFromExtents(extents);
+            size_t numElements = LiFFT::policies::getNumElementsFromExtents(extents);
             return numElements * (isComplexIn ? sizeof(LibInType) : sizeof(LibOutType));
         }
     };
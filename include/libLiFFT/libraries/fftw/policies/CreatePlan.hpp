@@ -27,6 +27,7 @@ namespace policies{
 
     /**
      * Creates a plan for the given precision type
+     * Uses the guru64 interface, so extents and strides (and hence the total size) are not limited to 32 bit
      */
     template< typename T_Precision >
     struct CreatePlan;
@@ -37,29 +38,30 @@ namespace policies{
         using PlanType = typename traits::LibTypes<float>::PlanType;
         using ComplexType = typename traits::LibTypes<float>::ComplexType;
         using RealType = float;
+        using IoDimType = fftwf_iodim64;
 
         static_assert(!std::is_same<RealType, ComplexType>::value, "Need different types for Real/Complex");
 
         PlanType
-        Create(int rank, const int* n, ComplexType* in, ComplexType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, ComplexType* in, ComplexType* out, int sign, unsigned flags)
         {
-            return fftwf_plan_dft(rank, n, in, out, sign, flags);
+            return fftwf_plan_guru64_dft(rank, dims, 0, nullptr, in, out, sign, flags);
         }
 
         PlanType
-        Create(int rank, const int* n, RealType* in, ComplexType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, RealType* in, ComplexType* out, int sign, unsigned flags)
         {
             assert(sign == FFTW_FORWARD);
             ignore_unused(sign);
-            return fftwf_plan_dft_r2c(rank, n, in, out, flags);
+            return fftwf_plan_guru64_dft_r2c(rank, dims, 0, nullptr, in, out, flags);
         }
 
         PlanType
-        Create(int rank, const int* n, ComplexType* in, RealType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, ComplexType* in, RealType* out, int sign, unsigned flags)
         {
             assert(sign == FFTW_BACKWARD);
             ignore_unused(sign);
-            return fftwf_plan_dft_c2r(rank, n, in, out, flags);
+            return fftwf_plan_guru64_dft_c2r(rank, dims, 0, nullptr, in, out, flags);
         }
     };
 
@@ -69,29 +71,30 @@ namespace policies{
         using PlanType = typename traits::LibTypes<double>::PlanType;
         using ComplexType = typename traits::LibTypes<double>::ComplexType;
         using RealType = double;
+        using IoDimType = fftw_iodim64;
 
         static_assert(!std::is_same<RealType, ComplexType>::value, "Need different types for Real/Complex");
 
         PlanType
-        Create(int rank, const int* n, ComplexType* in, ComplexType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, ComplexType* in, ComplexType* out, int sign, unsigned flags)
         {
-            return fftw_plan_dft(rank, n, in, out, sign, flags);
+            return fftw_plan_guru64_dft(rank, dims, 0, nullptr, in, out, sign, flags);
         }
 
         PlanType
-        Create(int rank, const int* n, RealType* in, ComplexType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, RealType* in, ComplexType* out, int sign, unsigned flags)
         {
             assert(sign == FFTW_FORWARD);
             ignore_unused(sign);
-            return fftw_plan_dft_r2c(rank, n, in, out, flags);
+            return fftw_plan_guru64_dft_r2c(rank, dims, 0, nullptr, in, out, flags);
         }
 
         PlanType
-        Create(int rank, const int* n, ComplexType* in, RealType* out, int sign, unsigned flags)
+        Create(int rank, const IoDimType* dims, ComplexType* in, RealType* out, int sign, unsigned flags)
         {
             assert(sign == FFTW_BACKWARD);
             ignore_unused(sign);
-            return fftw_plan_dft_c2r(rank, n, in, out, flags);
+            return fftw_plan_guru64_dft_c2r(rank, dims, 0, nullptr, in, out, flags);
         }
     };
 
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <libLiFFT/policies/SafePtrCast.hpp>
+#include <array>
 #include <cassert>
+#include <cstddef>
 #include "libLiFFT/types/TypePair.hpp"
 #include "libLiFFT/libraries/fftw/traits/Sign.hpp"
 #include "libLiFFT/libraries/fftw/policies/CreatePlan.hpp"
@@ -72,6 +74,39 @@ namespace policies {
         static_assert(isComplexIn || isComplexOut, "Real2Real transform not supported");
         static_assert(isComplexIn || isFwd, "Real2Complex is always a forward transform");
         static_assert(isComplexOut || !isFwd, "Complex2Real is always a backward transform");
+        using IoDims = std::array< typename policies::CreatePlan<Precision>::IoDimType, numDims >;
+
+        /**
+         * Describes the row-major layout of input and output (in elements of the respective type)
+         * The complex side of R2C/C2R transforms stores n/2+1 values in the last dimension,
+         * the real side of inplace transforms is padded to the same size in bytes
+         */
+        template< class T_Extents >
+        static IoDims
+        getDims(const T_Extents& fullExtents)
+        {
+            IoDims dims;
+            const size_t lastExtent = fullExtents[numDims - 1];
+            const size_t halfExtent = lastExtent / 2 + 1;
+            const size_t realRow = isInplace ? 2 * halfExtent : lastExtent;
+            ptrdiff_t strideIn = 1, strideOut = 1;
+            for(unsigned i = numDims; i-- > 0;)
+            {
+                dims[i].n  = fullExtents[i];
+                dims[i].is = strideIn;
+                dims[i].os = strideOut;
+                if(i + 1 == numDims)
+                {
+                    strideIn  *= isComplexIn  ? (isComplexOut ? lastExtent : halfExtent) : realRow;
+                    strideOut *= isComplexOut ? (isComplexIn  ? lastExtent : halfExtent) : realRow;
+                }else
+                {
+                    strideIn  *= fullExtents[i];
+                    strideOut *= fullExtents[i];
+                }
+            }
+            return dims;
+        }
 
     public:
         using PlanType = typename traits::LibTypes<T_Precision>::PlanType;
@@ -83,9 +118,10 @@ namespace policies {
             static_assert(!isInplace, "Cannot be used for inplace transforms!");
             auto extents(input.getExtents());
             auto extentsOut(output.getExtents());
-            for(unsigned i=0; i<numDims; ++i){
-                unsigned eIn = extents[i];
-                unsigned eOut = extentsOut[i];
+            // Static extents are already checked by the data wrappers
+            for(unsigned i=0; i<numDims && !Input::FFT_Def::hasStaticExtents; ++i){
+                size_t eIn = extents[i];
+                size_t eOut = extentsOut[i];
                 // Same extents in all dimensions unless we have a C2R or R2C and compare the last dimension
                 bool dimOk = (eIn == eOut || (i+1 == numDims && !(isComplexIn && isComplexOut)));
                 // Half input size for first dimension of R2C
@@ -95,9 +131,10 @@ namespace policies {
                 if(!dimOk)
                     throw std::runtime_error("Dimension " + std::to_string(i) + ": Extents mismatch");
             }
+            const IoDims dims = getDims(input.getFullExtents());
             return policies::CreatePlan<Precision>().Create(
                     numDims,
-                    reinterpret_cast<const int*>(input.getFullExtents().data()),
+                    dims.data(),
                     safe_ptr_cast<LibInType>(input.getDataPtr()),
                     safe_ptr_cast<LibOutType>(output.getDataPtr()),
                     traits::Sign<isFwd>::value,
@@ -110,9 +147,10 @@ namespace policies {
         {
             using LiFFT::policies::safe_ptr_cast;
             static_assert(isInplace, "Must be used for inplace transforms!");
+            const IoDims dims = getDims(inOut.getFullExtents());
             return policies::CreatePlan<Precision>().Create(
                     numDims,
-                    reinterpret_cast<const int*>(inOut.getFullExtents().data()),
+                    dims.data(),
                     safe_ptr_cast<LibInType>(inOut.getDataPtr()),
                     reinterpret_cast<LibOutType>(safe_ptr_cast<LibInType>(inOut.getDataPtr())),
                     traits::Sign<isFwd>::value,
@@ -0,0 +1,116 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * Allocator using new[]/delete[], that is: Default alignment and construction of the values
+     */
+    struct NewAllocator
+    {
+        template< typename T >
+        static T*
+        allocate(size_t numElements)
+        {
+            return new T[numElements];
+        }
+
+        template< typename T >
+        static void
+        free(T* ptr)
+        {
+            delete[] ptr;
+        }
+    };
+
+    /**
+     * Allocator that aligns the memory to T_alignment bytes so SIMD code (e.g. FFTW codelets) can use
+     * aligned loads and plans fit all buffers allocated with it.
+     * Values are default-initialized only, so trivial types are not touched (no zeroing of large buffers)
+     * Only pointers returned by allocate may be passed to free (it reads a header in front of the memory), so owning
+     * memory classes must not be given pointers from new[]. Use NewAllocator for those
+     *
+     * \tparam T_alignment Alignment in bytes, must be a power of 2 [64, a cache line and an AVX-512 register]
+     */
+    template< size_t T_alignment = 64 >
+    struct AlignedAllocator
+    {
+        static constexpr size_t alignment = T_alignment;
+        static_assert(alignment >= sizeof(void*) && (alignment & (alignment - 1)) == 0,
+                "Alignment must be a power of 2 and at least the size of a pointer");
+
+        template< typename T >
+        static T*
+        allocate(size_t numElements)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Values are not destroyed on free");
+            if(numElements > (std::numeric_limits<size_t>::max() - alignment) / sizeof(T))
+                throw std::bad_array_new_length();
+            // Over-allocate and store the original pointer right before the aligned memory
+            char* raw = static_cast<char*>(::operator new(numElements * sizeof(T) + alignment));
+            char* aligned = raw + alignment - reinterpret_cast<std::uintptr_t>(raw) % alignment;
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            T* result = reinterpret_cast<T*>(aligned);
+            for(size_t i = 0; i < numElements; ++i)
+                ::new(static_cast<void*>(result + i)) T;
+            return result;
+        }
+
+        template< typename T >
+        static void
+        free(T* ptr)
+        {
+            if(!ptr)
+                return;
+            void* raw = reinterpret_cast<void**>(ptr)[-1];
+            // Catches (most) pointers that were not allocated by this allocator
+            assert(reinterpret_cast<char*>(ptr) > raw && reinterpret_cast<char*>(ptr) - static_cast<char*>(raw) <= std::ptrdiff_t(alignment));
+            ::operator delete(raw);
+        }
+    };
+
+    /**
+     * Allocator used by the memory classes (RealValues, ComplexAoSValues, ...) by default
+     */
+    using DefaultAllocator = AlignedAllocator<>;
+
+    /**
+     * Deleter for std::unique_ptr that frees memory allocated by T_Allocator
+     * The pointer must have been allocated by T_Allocator
+     */
+    template< class T_Allocator >
+    struct AllocatorDeleter
+    {
+        template< typename T >
+        void
+        operator()(T* ptr) const
+        {
+            T_Allocator::free(ptr);
+        }
+    };
+
+}  // namespace mem
+}  // namespace LiFFT
@@ -20,6 +20,7 @@
 #include "libLiFFT/traits/IntegralType.hpp"
 #include "libLiFFT/traits/IsComplex.hpp"
 #include "libLiFFT/accessors/ArrayAccessor.hpp"
+#include "libLiFFT/mem/Allocator.hpp"
 
 #include <cassert>
 
@@ -42,8 +43,9 @@ namespace detail {
      *
      * \tparam T Type to hold
      * \tparam T_ownsPointer Whether this class owns its pointer or not (memory is freed on destroy, when true)
+     * \tparam T_Allocator Allocator used for allocData. Owned pointers passed to the ctor or reset must come from it
      */
-    template< typename T, bool T_ownsPointer = true >
+    template< typename T, bool T_ownsPointer = true, class T_Allocator = DefaultAllocator >
     class AoSValues
     {
     public:
@@ -51,20 +53,28 @@ namespace detail {
         static constexpr bool ownsPointer = T_ownsPointer;
         static constexpr bool isComplex = traits::IsComplex<T>::value;
         static constexpr bool isAoS = true;
+        using Allocator = T_Allocator;
         using Value = T;
         using Ptr = Value*;
         using Ref = Value&;
         using ConstRef = const Value&;
         using Data = std::conditional_t<
                         ownsPointer,
-                        std::unique_ptr< Value[] >,
+                        std::unique_ptr< Value[], AllocatorDeleter<Allocator> >,
                         std::unique_ptr< Value[], NopDeleter >
                      >;
         using IdentityAccessor = accessors::ArrayAccessor<>;
 
         AoSValues(): AoSValues(nullptr, 0){}
+        /**
+         * Takes the pointer which is freed with Allocator::free if this class owns it, so it must come from Allocator
+         * (e.g. not from new[] for the DefaultAllocator)
+         */
         AoSValues(Ptr data, size_t numElements): m_data(data), m_numElements(numElements){}
 
+        /**
+         * Replaces the data, same requirements on the pointer as for the constructor
+         */
         void
         reset(Ptr data, size_t numElements)
         {
@@ -77,7 +87,7 @@ namespace detail {
         allocData(size_t numElements)
         {
             assert(numElements);
-            m_data.reset(new Value[numElements]);
+            m_data.reset(Allocator::template allocate<Value>(numElements));
             m_numElements = numElements;
         }
 
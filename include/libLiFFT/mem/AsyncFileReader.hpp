@@ -0,0 +1,658 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__unix__)
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#if defined(__linux__) && defined(WITH_IO_URING)
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <sys/uio.h>
+#   define LiFFT_USE_IO_URING 1
+#endif
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * Mechanism used to read the file
+     */
+    enum class IoBackend
+    {
+        /** io_uring if available (compiled with WITH_IO_URING and supported by the kernel), threads otherwise */
+        Auto,
+        /** Linux io_uring, many requests in flight from one thread */
+        IoUring,
+        /** A pool of threads issuing blocking reads */
+        Threads
+    };
+
+    /**
+     * Options for the AsyncFileReader
+     */
+    struct AsyncReadOptions
+    {
+        /** Maximum number of requests in flight */
+        unsigned queueDepth = 32;
+        /** Size of each request in bytes, should be a multiple of directIOAlignment */
+        size_t requestSize = size_t(1) << 20;
+        /** Bypass the page cache (O_DIRECT) for requests whose buffer, offset and size are suitably aligned */
+        bool useDirectIO = true;
+        /** Number of threads used by the thread backend */
+        unsigned numThreads = 4;
+        IoBackend backend = IoBackend::Auto;
+    };
+
+    /**
+     * Alignment of buffer, file offset and size required for direct IO
+     * Allocate the destination with AlignedAllocator<directIOAlignment> to make use of it
+     */
+    constexpr size_t directIOAlignment = 4096;
+
+    namespace detail {
+
+        /**
+         * A contiguous part of the read that goes to one slab
+         */
+        struct ReadRequest
+        {
+            char* dst;
+            size_t offset;
+            size_t size;
+            size_t slab;
+            bool isDirect;
+        };
+
+#ifdef LiFFT_USE_IO_URING
+
+        /**
+         * Minimal io_uring instance using the kernel interface directly (no liburing needed)
+         */
+        class IoUring
+        {
+            int m_fd = -1;
+            void* m_sqRing = MAP_FAILED;
+            void* m_cqRing = MAP_FAILED;
+            size_t m_sqRingSize = 0, m_cqRingSize = 0, m_sqesSize = 0;
+            io_uring_sqe* m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            unsigned *m_sqTail = nullptr, *m_sqMask = nullptr, *m_sqArray = nullptr;
+            unsigned *m_cqHead = nullptr, *m_cqTail = nullptr, *m_cqMask = nullptr;
+            io_uring_cqe* m_cqes = nullptr;
+            unsigned m_numToSubmit = 0;
+
+            IoUring(const IoUring&) = delete;
+            IoUring& operator=(const IoUring&) = delete;
+
+            template< typename T >
+            static T*
+            at(void* base, unsigned offset)
+            {
+                return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+            }
+
+            void
+            release()
+            {
+                if(m_sqes != MAP_FAILED)
+                    munmap(m_sqes, m_sqesSize);
+                if(m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+                    munmap(m_cqRing, m_cqRingSize);
+                if(m_sqRing != MAP_FAILED)
+                    munmap(m_sqRing, m_sqRingSize);
+                if(m_fd >= 0)
+                    ::close(m_fd);
+                m_fd = -1;
+                m_sqRing = m_cqRing = MAP_FAILED;
+                m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            }
+
+        public:
+            IoUring() = default;
+            ~IoUring()
+            {
+                release();
+            }
+
+            /**
+             * Sets up the rings, returns false if io_uring is not available (old kernel, seccomp, ...)
+             */
+            bool
+            init(unsigned numEntries)
+            {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                m_fd = static_cast<int>(syscall(__NR_io_uring_setup, numEntries, &params));
+                if(m_fd < 0)
+                    return false;
+                m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if(isSingleMap)
+                    m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+                m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+                if(m_sqRing == MAP_FAILED)
+                    return release(), false;
+                m_cqRing = isSingleMap ? m_sqRing :
+                        mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+                m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                if(m_cqRing != MAP_FAILED)
+                    m_sqes = static_cast<io_uring_sqe*>(
+                            mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+                if(m_sqes == MAP_FAILED)
+                    return release(), false;
+                m_sqTail  = at<unsigned>(m_sqRing, params.sq_off.tail);
+                m_sqMask  = at<unsigned>(m_sqRing, params.sq_off.ring_mask);
+                m_sqArray = at<unsigned>(m_sqRing, params.sq_off.array);
+                m_cqHead  = at<unsigned>(m_cqRing, params.cq_off.head);
+                m_cqTail  = at<unsigned>(m_cqRing, params.cq_off.tail);
+                m_cqMask  = at<unsigned>(m_cqRing, params.cq_off.ring_mask);
+                m_cqes    = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+                return true;
+            }
+
+            /**
+             * Queues a read, the caller must not have more requests in flight than entries in the ring
+             */
+            void
+            queueRead(int fd, struct iovec* iov, size_t offset, uint64_t userData)
+            {
+                const unsigned tail = *m_sqTail;
+                const unsigned idx = tail & *m_sqMask;
+                io_uring_sqe& sqe = m_sqes[idx];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READV;
+                sqe.fd = fd;
+                sqe.off = offset;
+                sqe.addr = reinterpret_cast<uint64_t>(iov);
+                sqe.len = 1;
+                sqe.user_data = userData;
+                m_sqArray[idx] = idx;
+                __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+                ++m_numToSubmit;
+            }
+
+            /**
+             * Submits all queued requests and waits for at least one completion
+             */
+            void
+            submitAndWait()
+            {
+                unsigned minComplete = 1;
+                do
+                {
+                    int res = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, m_numToSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0));
+                    if(res < 0)
+                    {
+                        if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                            continue;
+                        throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+                    }
+                    m_numToSubmit -= std::min<unsigned>(res, m_numToSubmit);
+                    minComplete = 0;
+                } while(m_numToSubmit);
+            }
+
+            /**
+             * Calls func(userData, result) for all available completions
+             */
+            template< class T_Func >
+            void
+            reap(T_Func&& func)
+            {
+                unsigned head = *m_cqHead;
+                while(head != __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE))
+                {
+                    const io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+                    const uint64_t userData = cqe.user_data;
+                    const int res = cqe.res;
+                    __atomic_store_n(m_cqHead, ++head, __ATOMIC_RELEASE);
+                    func(userData, res);
+                }
+            }
+        };
+
+#endif
+
+    }  // namespace detail
+
+    /**
+     * Reads (large) files asynchronously into memory
+     * The read is split into slabs (e.g. planes of a volume) which can be waited for separately,
+     * so processing of the first slabs can start while the rest is still loading.
+     * Each slab is split into requests of which many are in flight at the same time.
+     * The destination must stay valid until the read is finished (wait() or destruction)
+     * An error of a read is reported by waitForSlab and once by wait() (or the next read() if wait() was not called),
+     * after that the reader can be used for new reads
+     */
+    class AsyncFileReader
+    {
+        AsyncReadOptions m_options;
+        IoBackend m_backend;
+        int m_fd = -1;
+        int m_directFd = -1;
+        size_t m_fileSize = 0;
+
+        std::vector<detail::ReadRequest> m_requests;
+        std::unique_ptr< std::atomic<size_t>[] > m_slabRemaining;
+        size_t m_numSlabs = 0;
+        std::thread m_worker;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::exception_ptr m_error;
+        std::atomic<bool> m_failed;
+#ifdef LiFFT_USE_IO_URING
+        std::unique_ptr<detail::IoUring> m_ring;
+#endif
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+        void
+        closeFiles()
+        {
+#if defined(__unix__)
+            if(m_fd >= 0)
+                ::close(m_fd);
+            if(m_directFd >= 0)
+                ::close(m_directFd);
+#endif
+            m_fd = m_directFd = -1;
+        }
+
+        void
+        setError(std::exception_ptr error)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_error)
+                m_error = error;
+            m_failed = true;
+            m_cond.notify_all();
+        }
+
+        /**
+         * Accounts numBytes read for the slab and wakes up waiters if it is complete
+         */
+        void
+        finishBytes(size_t slab, size_t numBytes)
+        {
+            if(m_slabRemaining[slab].fetch_sub(numBytes) == numBytes)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cond.notify_all();
+            }
+        }
+
+        /**
+         * Updates the request after a (possibly short) read of res bytes
+         * Returns true if the request has to be (re)submitted
+         */
+        bool
+        handleResult(detail::ReadRequest& req, long res)
+        {
+            if(res == -EINVAL && req.isDirect)
+            {
+                // File system does not support direct IO for this request
+                req.isDirect = false;
+                return true;
+            }
+            if(res < 0)
+                throw std::runtime_error(std::string("Error reading file: ") + std::strerror(static_cast<int>(-res)));
+            if(res == 0)
+                throw std::runtime_error("Unexpected end of file at offset " + std::to_string(req.offset));
+            const size_t numBytes = static_cast<size_t>(res);
+            finishBytes(req.slab, numBytes);
+            req.dst += numBytes;
+            req.offset += numBytes;
+            req.size -= numBytes;
+            // Remainder of short reads is most likely not aligned anymore
+            req.isDirect &= numBytes % directIOAlignment == 0;
+            return req.size != 0;
+        }
+
+#if defined(__unix__)
+        void
+        readBlocking(detail::ReadRequest& req)
+        {
+            do
+            {
+                ssize_t res = pread(req.isDirect ? m_directFd : m_fd, req.dst, req.size, static_cast<off_t>(req.offset));
+                if(res < 0 && errno == EINTR)
+                    continue;
+                if(!handleResult(req, res < 0 ? -errno : res))
+                    return;
+            } while(!m_failed);
+        }
+#else
+        void
+        readBlocking(detail::ReadRequest&)
+        {
+            throw std::runtime_error("Asynchronous reading is not supported on this platform");
+        }
+#endif
+
+        void
+        runThreads()
+        {
+            std::atomic<size_t> nextRequest(0);
+            auto worker = [this, &nextRequest]()
+            {
+                try
+                {
+                    for(size_t i = nextRequest++; i < m_requests.size() && !m_failed; i = nextRequest++)
+                        readBlocking(m_requests[i]);
+                }catch(...)
+                {
+                    setError(std::current_exception());
+                }
+            };
+            const unsigned numThreads = std::max(1u, std::min<unsigned>(policies::getNumThreads(m_options.numThreads),
+                                                                        static_cast<unsigned>(m_requests.size())));
+            std::vector<std::thread> threads;
+            for(unsigned i = 1; i < numThreads; ++i)
+                threads.emplace_back(worker);
+            worker();
+            for(std::thread& t: threads)
+                t.join();
+        }
+
+#ifdef LiFFT_USE_IO_URING
+        void
+        runIoUring()
+        {
+            const size_t numRequests = m_requests.size();
+            std::vector<struct iovec> iovecs(numRequests);
+            std::vector<size_t> resubmits;
+            size_t nextRequest = 0;
+            unsigned numInFlight = 0;
+            auto queue = [&](size_t i)
+            {
+                detail::ReadRequest& req = m_requests[i];
+                iovecs[i].iov_base = req.dst;
+                iovecs[i].iov_len = req.size;
+                m_ring->queueRead(req.isDirect ? m_directFd : m_fd, &iovecs[i], req.offset, i);
+                ++numInFlight;
+            };
+            try
+            {
+                while(numInFlight || (!m_failed && (nextRequest < numRequests || !resubmits.empty())))
+                {
+                    while(!m_failed && numInFlight < m_options.queueDepth && !resubmits.empty())
+                    {
+                        queue(resubmits.back());
+                        resubmits.pop_back();
+                    }
+                    while(!m_failed && numInFlight < m_options.queueDepth && nextRequest < numRequests)
+                        queue(nextRequest++);
+                    m_ring->submitAndWait();
+                    m_ring->reap([&](uint64_t i, int res)
+                    {
+                        --numInFlight;
+                        if(m_failed)
+                            return;
+                        try
+                        {
+                            if(handleResult(m_requests[i], res))
+                                resubmits.push_back(i);
+                        }catch(...)
+                        {
+                            setError(std::current_exception());
+                        }
+                    });
+                }
+            }catch(...)
+            {
+                // Requests in flight cannot be cancelled reliably here, wait for them before the buffers may be freed
+                setError(std::current_exception());
+                while(numInFlight)
+                {
+                    try
+                    {
+                        m_ring->submitAndWait();
+                    }catch(...)
+                    {
+                        break;
+                    }
+                    m_ring->reap([&](uint64_t, int){ --numInFlight; });
+                }
+            }
+        }
+#endif
+
+        void
+        checkError() const
+        {
+            if(m_error)
+                std::rethrow_exception(m_error);
+        }
+
+        void
+        checkSlab(size_t slab) const
+        {
+            if(slab >= m_numSlabs)
+                throw std::out_of_range("Slab " + std::to_string(slab) + " is out of range (" + std::to_string(m_numSlabs) + " slabs)");
+        }
+
+    public:
+        /**
+         * Opens the file for reading
+         *
+         * @param filePath Path to the file
+         * @param options  Options for reading
+         */
+        explicit AsyncFileReader(const std::string& filePath, const AsyncReadOptions& options = AsyncReadOptions()):
+            m_options(options), m_backend(IoBackend::Threads), m_failed(false)
+        {
+            m_options.queueDepth = std::max(1u, m_options.queueDepth);
+            m_options.requestSize = std::max(m_options.requestSize, directIOAlignment);
+#if defined(__unix__)
+            m_fd = ::open(filePath.c_str(), O_RDONLY);
+            if(m_fd < 0)
+                throw std::runtime_error("Could not open '" + filePath + "': " + std::strerror(errno));
+            struct stat fileStat;
+            if(fstat(m_fd, &fileStat) == 0)
+                m_fileSize = static_cast<size_t>(fileStat.st_size);
+#   ifdef O_DIRECT
+            // Not all file systems support this (e.g. tmpfs), then only buffered IO is used
+            if(m_options.useDirectIO)
+                m_directFd = ::open(filePath.c_str(), O_RDONLY | O_DIRECT);
+#   endif
+#else
+            throw std::runtime_error("Asynchronous reading is not supported on this platform");
+#endif
+#ifdef LiFFT_USE_IO_URING
+            if(m_options.backend != IoBackend::Threads)
+            {
+                m_ring.reset(new detail::IoUring());
+                if(m_ring->init(m_options.queueDepth))
+                    m_backend = IoBackend::IoUring;
+                else
+                    m_ring.reset();
+            }
+#endif
+            if(m_options.backend == IoBackend::IoUring && m_backend != IoBackend::IoUring)
+            {
+                closeFiles();
+                throw std::runtime_error("io_uring is not available");
+            }
+        }
+
+        ~AsyncFileReader()
+        {
+            if(m_worker.joinable())
+                m_worker.join();
+            closeFiles();
+        }
+
+        /**
+         * Starts reading the file into the given memory and returns immediately
+         * Waits for a previous read to finish first and rethrows its error if it was not reported by wait()
+         *
+         * @param dst        Destination
+         * @param size       Number of bytes to read
+         * @param fileOffset Offset in the file [0]
+         * @param slabSize   Size of the slabs in bytes that can be waited for, 0 for one slab [0]
+         */
+        void
+        read(void* dst, size_t size, size_t fileOffset = 0, size_t slabSize = 0)
+        {
+            wait();
+            if(fileOffset + size > m_fileSize)
+                throw std::runtime_error("Read of " + std::to_string(size) + " bytes at offset " + std::to_string(fileOffset) +
+                        " exceeds the file size of " + std::to_string(m_fileSize));
+            if(!slabSize || slabSize > size)
+                slabSize = size;
+            m_numSlabs = size ? (size + slabSize - 1) / slabSize : 0;
+            m_slabRemaining.reset(new std::atomic<size_t>[m_numSlabs]);
+            m_requests.clear();
+            char* const dstBytes = static_cast<char*>(dst);
+            for(size_t slab = 0; slab < m_numSlabs; ++slab)
+            {
+                const size_t slabStart = slab * slabSize;
+                const size_t slabEnd = std::min(slabStart + slabSize, size);
+                m_slabRemaining[slab] = slabEnd - slabStart;
+                for(size_t start = slabStart; start < slabEnd; start += m_options.requestSize)
+                {
+                    detail::ReadRequest req;
+                    req.dst = dstBytes + start;
+                    req.offset = fileOffset + start;
+                    req.size = std::min(m_options.requestSize, slabEnd - start);
+                    req.slab = slab;
+                    req.isDirect = m_directFd >= 0 &&
+                            reinterpret_cast<std::uintptr_t>(req.dst) % directIOAlignment == 0 &&
+                            req.offset % directIOAlignment == 0 &&
+                            req.size % directIOAlignment == 0;
+                    m_requests.push_back(req);
+                }
+            }
+            if(m_requests.empty())
+                return;
+            m_worker = std::thread([this]()
+            {
+#ifdef LiFFT_USE_IO_URING
+                if(m_backend == IoBackend::IoUring)
+                    return runIoUring();
+#endif
+                runThreads();
+            });
+        }
+
+        /**
+         * Starts reading the file into a container (e.g. a DataContainer), slabs are made of planes of the first dimension
+         *
+         * @param data           Container to read into, must be contiguous
+         * @param fileOffset     Offset in the file [0]
+         * @param planesPerSlab  Number of planes (index of the first dimension) per slab [1]
+         */
+        template< class T_Container >
+        void
+        read(T_Container& data, size_t fileOffset = 0, size_t planesPerSlab = 1)
+        {
+            const size_t memSize = data.getMemSize();
+            const size_t numPlanes = data.getExtents()[0];
+            read(data.getData(), memSize, fileOffset, numPlanes ? memSize / numPlanes * planesPerSlab : 0);
+        }
+
+        /**
+         * Returns the number of slabs of the current read
+         */
+        size_t
+        getNumSlabs() const
+        {
+            return m_numSlabs;
+        }
+
+        /**
+         * Returns true if the slab is completely read
+         */
+        bool
+        isSlabReady(size_t slab) const
+        {
+            checkSlab(slab);
+            return m_slabRemaining[slab] == 0;
+        }
+
+        /**
+         * Waits till the slab is completely read, rethrows errors of the read
+         */
+        void
+        waitForSlab(size_t slab)
+        {
+            checkSlab(slab);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this, slab]{ return m_slabRemaining[slab] == 0 || m_error; });
+            checkError();
+        }
+
+        /**
+         * Waits till the current read is finished, rethrows errors of the read
+         * The error is reset, so following reads are not affected
+         */
+        void
+        wait()
+        {
+            if(m_worker.joinable())
+                m_worker.join();
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::swap(error, m_error);
+                m_failed = false;
+            }
+            if(error)
+                std::rethrow_exception(error);
+        }
+
+        /**
+         * Returns the backend actually used
+         */
+        IoBackend
+        getBackend() const
+        {
+            return m_backend;
+        }
+
+        size_t
+        getFileSize() const
+        {
+            return m_fileSize;
+        }
+    };
+
+}  // namespace mem
+}  // namespace LiFFT
+
+#undef LiFFT_USE_IO_URING
@@ -0,0 +1,349 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include "libLiFFT/mem/Allocator.hpp"
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * Usage statistics of a BufferPool
+     */
+    struct PoolStatistics
+    {
+        /** Bytes currently handed out */
+        size_t bytesInUse = 0;
+        /** Maximum of bytesInUse */
+        size_t peakBytesInUse = 0;
+        /** Bytes kept for reuse */
+        size_t bytesCached = 0;
+        /** Number of allocations served */
+        size_t numAllocations = 0;
+        /** Number of allocations served from cached buffers */
+        size_t numReused = 0;
+
+        double
+        getReuseRate() const
+        {
+            return numAllocations ? static_cast<double>(numReused) / numAllocations : 0.;
+        }
+    };
+
+    /**
+     * Pool that recycles buffers instead of returning them to the OS, avoiding allocation and page fault costs
+     * when buffers of similar sizes are needed repeatedly (e.g. FFTs over a series of files).
+     * Sizes are rounded up to size classes (16 per power of two, so at most 6.25% are wasted).
+     * Released buffers go to a small per-thread cache first and then to a shared cache.
+     * All buffers are aligned to 64 bytes.
+     * By default the cache holds up to the peak number of bytes in use (at least 1GiB), so buffers of any size
+     * can be reused without the pool ever growing the memory footprint beyond what the program already needed.
+     */
+    class BufferPool
+    {
+        using RawAllocator = AlignedAllocator<>;
+        /** Space in front of each buffer storing its size class */
+        static constexpr size_t headerSize = RawAllocator::alignment;
+        static constexpr size_t minSizeClass = 256;
+        static constexpr size_t sizeClassesPerPowerOfTwo = 16;
+        static constexpr size_t maxThreadCacheBuffers = 4;
+        /** Lower bound of the automatic cache limit */
+        static constexpr size_t minAutoCachedBytes = size_t(1) << 30;
+
+        struct ThreadCache
+        {
+            std::vector< std::pair<size_t, char*> > buffers;
+
+            ~ThreadCache()
+            {
+                isThreadCacheDestroyed() = true;
+                BufferPool& pool = getInstance();
+                for(auto& buffer: buffers)
+                    pool.releaseShared(buffer.first, buffer.second);
+            }
+        };
+
+        std::mutex m_mutex;
+        std::map< size_t, std::vector<char*> > m_sharedCache;
+        std::atomic<size_t> m_maxCachedBytes;
+        std::atomic<size_t> m_bytesInUse, m_peakBytesInUse, m_bytesCached, m_numAllocations, m_numReused;
+
+        BufferPool(): m_maxCachedBytes(0), m_bytesInUse(0), m_peakBytesInUse(0),
+                m_bytesCached(0), m_numAllocations(0), m_numReused(0){}
+
+        /**
+         * Set when the cache of the calling thread is destroyed (trivially destructible, so valid until the thread ends)
+         */
+        static bool&
+        isThreadCacheDestroyed()
+        {
+            static thread_local bool isDestroyed = false;
+            return isDestroyed;
+        }
+
+        /**
+         * Returns the buffers cached by the calling thread or nullptr if they were already destroyed
+         * (buffers released by static or thread local containers on exit)
+         */
+        static std::vector< std::pair<size_t, char*> >*
+        getThreadCache()
+        {
+            if(isThreadCacheDestroyed())
+                return nullptr;
+            static thread_local ThreadCache cache;
+            return &cache.buffers;
+        }
+
+        static size_t&
+        getSizeClassOf(char* data)
+        {
+            return *reinterpret_cast<size_t*>(data - headerSize);
+        }
+
+        static void
+        freeBuffer(char* data)
+        {
+            RawAllocator::free(data - headerSize);
+        }
+
+        /**
+         * Reserves the bytes in the cache, returns false if the cache would exceed its limit
+         */
+        bool
+        reserveCache(size_t sizeClass)
+        {
+            size_t cached = m_bytesCached.load();
+            do{
+                if(cached + sizeClass > getMaxCachedBytes())
+                    return false;
+            }while(!m_bytesCached.compare_exchange_weak(cached, cached + sizeClass));
+            return true;
+        }
+
+        void
+        releaseShared(size_t sizeClass, char* data)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sharedCache[sizeClass].push_back(data);
+        }
+
+        void
+        trimShared()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(auto& sizeClass: m_sharedCache)
+            {
+                for(char* data: sizeClass.second)
+                {
+                    freeBuffer(data);
+                    m_bytesCached -= sizeClass.first;
+                }
+            }
+            m_sharedCache.clear();
+        }
+
+    public:
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        /**
+         * Returns the process wide pool
+         */
+        static BufferPool&
+        getInstance()
+        {
+            // Never destroyed, so buffers of static objects can still be released at exit
+            static BufferPool* pool = new BufferPool();
+            return *pool;
+        }
+
+        /**
+         * Returns the size of the buffer actually used for the given size
+         */
+        static size_t
+        getSizeClass(size_t numBytes)
+        {
+            if(numBytes <= minSizeClass)
+                return minSizeClass;
+            // Largest power of two with step * sizeClassesPerPowerOfTwo <= numBytes
+            size_t step = 1;
+            while(step * 2 * sizeClassesPerPowerOfTwo <= numBytes)
+                step <<= 1;
+            return (numBytes + step - 1) / step * step;
+        }
+
+        /**
+         * Returns a buffer of at least numBytes bytes, reusing a cached one if possible
+         */
+        void*
+        allocate(size_t numBytes)
+        {
+            const size_t sizeClass = getSizeClass(numBytes);
+            char* result = nullptr;
+            auto* threadCache = getThreadCache();
+            if(threadCache)
+            {
+                for(auto it = threadCache->begin(); it != threadCache->end(); ++it)
+                {
+                    if(it->first == sizeClass)
+                    {
+                        result = it->second;
+                        threadCache->erase(it);
+                        break;
+                    }
+                }
+            }
+            if(!result)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_sharedCache.find(sizeClass);
+                if(it != m_sharedCache.end() && !it->second.empty())
+                {
+                    result = it->second.back();
+                    it->second.pop_back();
+                }
+            }
+            ++m_numAllocations;
+            if(result)
+            {
+                ++m_numReused;
+                m_bytesCached -= sizeClass;
+            }else
+            {
+                result = RawAllocator::allocate<char>(sizeClass + headerSize) + headerSize;
+                getSizeClassOf(result) = sizeClass;
+            }
+            size_t inUse = (m_bytesInUse += sizeClass);
+            size_t peak = m_peakBytesInUse.load();
+            while(peak < inUse && !m_peakBytesInUse.compare_exchange_weak(peak, inUse)){}
+            return result;
+        }
+
+        /**
+         * Returns a buffer obtained from allocate to the pool
+         */
+        void
+        release(void* ptr)
+        {
+            if(!ptr)
+                return;
+            char* data = static_cast<char*>(ptr);
+            const size_t sizeClass = getSizeClassOf(data);
+            m_bytesInUse -= sizeClass;
+            if(!reserveCache(sizeClass))
+            {
+                freeBuffer(data);
+                return;
+            }
+            auto* threadCache = getThreadCache();
+            if(threadCache && threadCache->size() < maxThreadCacheBuffers)
+                threadCache->emplace_back(sizeClass, data);
+            else
+                releaseShared(sizeClass, data);
+        }
+
+        /**
+         * Frees all cached buffers of the shared cache and of the calling threads cache
+         */
+        void
+        trim()
+        {
+            auto* threadCache = getThreadCache();
+            if(threadCache)
+            {
+                for(auto& buffer: *threadCache)
+                {
+                    freeBuffer(buffer.second);
+                    m_bytesCached -= buffer.first;
+                }
+                threadCache->clear();
+            }
+            trimShared();
+        }
+
+        /**
+         * Sets the maximum number of bytes kept for reuse, buffers released above that are freed
+         * 0 selects the automatic limit: The peak number of bytes in use but at least 1GiB [0]
+         */
+        void
+        setMaxCachedBytes(size_t maxCachedBytes)
+        {
+            m_maxCachedBytes = maxCachedBytes;
+        }
+
+        /**
+         * Returns the current maximum number of bytes kept for reuse
+         */
+        size_t
+        getMaxCachedBytes() const
+        {
+            const size_t maxCachedBytes = m_maxCachedBytes.load();
+            if(maxCachedBytes)
+                return maxCachedBytes;
+            const size_t peakBytesInUse = m_peakBytesInUse.load();
+            return peakBytesInUse > minAutoCachedBytes ? peakBytesInUse : minAutoCachedBytes;
+        }
+
+        PoolStatistics
+        getStatistics() const
+        {
+            PoolStatistics stats;
+            stats.bytesInUse = m_bytesInUse.load();
+            stats.peakBytesInUse = m_peakBytesInUse.load();
+            stats.bytesCached = m_bytesCached.load();
+            stats.numAllocations = m_numAllocations.load();
+            stats.numReused = m_numReused.load();
+            return stats;
+        }
+    };
+
+    /**
+     * Allocator drawing its memory from the BufferPool
+     * Used for temporary and output buffers of FFTs that are typically created repeatedly with the same sizes
+     */
+    struct PoolAllocator
+    {
+        static constexpr size_t alignment = AlignedAllocator<>::alignment;
+
+        template< typename T >
+        static T*
+        allocate(size_t numElements)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Values are not destroyed on free");
+            T* result = static_cast<T*>(BufferPool::getInstance().allocate(numElements * sizeof(T)));
+            for(size_t i = 0; i < numElements; ++i)
+                ::new(static_cast<void*>(result + i)) T;
+            return result;
+        }
+
+        template< typename T >
+        static void
+        free(T* ptr)
+        {
+            BufferPool::getInstance().release(ptr);
+        }
+    };
+
+}  // namespace mem
+}  // namespace LiFFT
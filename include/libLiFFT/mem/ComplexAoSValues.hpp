@@ -23,11 +23,11 @@
 namespace LiFFT {
 namespace mem {
 
-    template< typename T, bool T_ownsPointer = true >
-    class ComplexAoSValues: public detail::AoSValues< types::Complex<T>, T_ownsPointer >
+    template< typename T, bool T_ownsPointer = true, class T_Allocator = DefaultAllocator >
+    class ComplexAoSValues: public detail::AoSValues< types::Complex<T>, T_ownsPointer, T_Allocator >
     {
     public:
-        using Parent = detail::AoSValues< types::Complex<T>, T_ownsPointer >;
+        using Parent = detail::AoSValues< types::Complex<T>, T_ownsPointer, T_Allocator >;
 
         using Parent::Parent;
     };
@@ -23,7 +23,7 @@
 namespace LiFFT {
     namespace mem {
 
-        template< typename T, bool T_ownsPointer = true >
+        template< typename T, bool T_ownsPointer = true, class T_Allocator = DefaultAllocator >
         class ComplexSoAValues
         {
         public:
@@ -31,7 +31,7 @@ namespace LiFFT {
             static constexpr bool isComplex = true;
             static constexpr bool isAoS = false;
             static constexpr bool ownsPointer = T_ownsPointer;
-            using Data = RealValues<T, ownsPointer>;
+            using Data = RealValues<T, ownsPointer, T_Allocator>;
             using Ptr = typename Data::Ptr;
             using Value = types::Complex<T>;
             using Ref = types::ComplexRef<T>;
@@ -39,6 +39,10 @@ namespace LiFFT {
             using IdentityAccessor = accessors::ArrayAccessor<>;
 
             ComplexSoAValues(){}
+            /**
+             * Takes the pointers which are freed with T_Allocator::free if this class owns them,
+             * so they must come from T_Allocator (e.g. not from new[] for the DefaultAllocator)
+             */
             ComplexSoAValues(Ptr realData, Ptr imagData, size_t numElements): m_real(realData, numElements), m_imag(imagData, numElements){}
 
             void
@@ -0,0 +1,606 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/accessors/ArrayAccessor.hpp"
+#include "libLiFFT/policies/Copy.hpp"
+#include "libLiFFT/policies/GetExtents.hpp"
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include "libLiFFT/traits/IdentityAccessor.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/traits/IsStrided.hpp"
+#include "libLiFFT/types/Complex.hpp"
+#include "libLiFFT/types/Vec.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * Codec used for the blocks of a \ref CompressedVolume
+     */
+    enum class CompressionCodec
+    {
+        /** Exact, the XOR of consecutive values is stored without its leading zero bytes */
+        Lossless,
+        /** Values are quantized to multiples of 2 * errorBound and the differences stored without leading zero bytes */
+        ErrorBounded
+    };
+
+    /**
+     * Options for a \ref CompressedVolume
+     */
+    struct CompressionOptions
+    {
+        CompressionCodec codec = CompressionCodec::Lossless;
+        /** Maximum absolute error per value for the ErrorBounded codec (plus the rounding to the precision) */
+        double errorBound = 0;
+        /** Number of elements per block */
+        size_t blockSize = size_t(1) << 16;
+        /** Number of decompressed blocks kept for element access */
+        size_t cacheSize = 8;
+        /** Number of threads used for (de)compression, 0 for all hardware threads */
+        unsigned numThreads = 0;
+    };
+
+    namespace detail {
+
+        /**
+         * Returns the number of bytes required to store the value (without leading zero bytes)
+         */
+        inline unsigned
+        getNumSignificantBytes(uint64_t value)
+        {
+#if defined(__GNUC__)
+            return value ? (64 - __builtin_clzll(value) + 7) / 8 : 0;
+#else
+            unsigned numBytes = 0;
+            for(; value; value >>= 8)
+                ++numBytes;
+            return numBytes;
+#endif
+        }
+
+        /**
+         * Appends the words to out: A nibble per word with its number of significant bytes followed by these bytes
+         */
+        inline void
+        encodeWords(const uint64_t* words, size_t numWords, std::vector<uint8_t>& out)
+        {
+            const size_t headerPos = out.size();
+            out.resize(headerPos + (numWords + 1) / 2 + numWords * sizeof(uint64_t));
+            uint8_t* header = &out[headerPos];
+            std::memset(header, 0, (numWords + 1) / 2);
+            uint8_t* payload = header + (numWords + 1) / 2;
+            for(size_t i = 0; i < numWords; ++i)
+            {
+                uint64_t word = words[i];
+                const unsigned numBytes = getNumSignificantBytes(word);
+                header[i / 2] |= numBytes << (4 * (i & 1));
+                for(unsigned j = 0; j < numBytes; ++j, word >>= 8)
+                    *payload++ = static_cast<uint8_t>(word);
+            }
+            out.resize(payload - out.data());
+        }
+
+        /**
+         * Reverts encodeWords, returns the position after the encoded data
+         */
+        inline const uint8_t*
+        decodeWords(const uint8_t* in, size_t numWords, uint64_t* words)
+        {
+            const uint8_t* header = in;
+            const uint8_t* payload = header + (numWords + 1) / 2;
+            for(size_t i = 0; i < numWords; ++i)
+            {
+                const unsigned numBytes = (header[i / 2] >> (4 * (i & 1))) & 0xF;
+                uint64_t word = 0;
+                for(unsigned j = 0; j < numBytes; ++j)
+                    word |= uint64_t(*payload++) << (8 * j);
+                words[i] = word;
+            }
+            return payload;
+        }
+
+        template< typename T >
+        struct FloatBits;
+
+        template<>
+        struct FloatBits<float>
+        {
+            using type = uint32_t;
+        };
+
+        template<>
+        struct FloatBits<double>
+        {
+            using type = uint64_t;
+        };
+
+        /**
+         * Codec byte of blocks stored uncompressed
+         */
+        constexpr uint8_t rawBlockCodec = 0xFF;
+
+        /**
+         * Compresses blocks of scalars with the given codec
+         * Each block starts with a byte identifying the codec used, blocks that cannot be quantized
+         * (infinite values or too large for the error bound) are stored lossless and blocks
+         * that do not get smaller (e.g. noise) are stored uncompressed
+         */
+        template< typename T_Precision >
+        struct BlockCodec
+        {
+            using Precision = T_Precision;
+            using Bits = typename FloatBits<Precision>::type;
+
+            static void
+            compress(const Precision* values, size_t numValues, const CompressionOptions& options, std::vector<uint8_t>& out)
+            {
+                encode(values, numValues, options, out);
+                const size_t rawSize = numValues * sizeof(Precision);
+                if(out.size() >= 1 + rawSize)
+                {
+                    out.resize(1 + rawSize);
+                    out[0] = rawBlockCodec;
+                    std::memcpy(&out[1], values, rawSize);
+                }
+            }
+
+            static void
+            decompress(const std::vector<uint8_t>& in, size_t numValues, const CompressionOptions& options, Precision* values)
+            {
+                if(in[0] == rawBlockCodec)
+                {
+                    std::memcpy(values, &in[1], numValues * sizeof(Precision));
+                    return;
+                }
+                std::vector<uint64_t> words(numValues);
+                decodeWords(in.data() + 1, numValues, words.data());
+                if(in[0] == static_cast<uint8_t>(CompressionCodec::ErrorBounded))
+                {
+                    const double step = 2 * options.errorBound;
+                    uint64_t quantized = 0;
+                    for(size_t i = 0; i < numValues; ++i)
+                    {
+                        const uint64_t diff = (words[i] >> 1) ^ (~(words[i] & 1) + 1);
+                        quantized += diff;
+                        values[i] = static_cast<Precision>(static_cast<int64_t>(quantized) * step);
+                    }
+                }else
+                {
+                    Bits prev = 0;
+                    for(size_t i = 0; i < numValues; ++i)
+                    {
+                        prev ^= static_cast<Bits>(words[i]);
+                        std::memcpy(&values[i], &prev, sizeof(prev));
+                    }
+                }
+            }
+
+        private:
+            static void
+            encode(const Precision* values, size_t numValues, const CompressionOptions& options, std::vector<uint8_t>& out)
+            {
+                std::vector<uint64_t> words(numValues);
+                out.clear();
+                if(options.codec == CompressionCodec::ErrorBounded && options.errorBound > 0)
+                {
+                    const double step = 2 * options.errorBound;
+                    int64_t prev = 0;
+                    bool isValid = true;
+                    for(size_t i = 0; i < numValues && isValid; ++i)
+                    {
+                        const double scaled = values[i] / step;
+                        isValid = std::isfinite(scaled) && std::abs(scaled) < 1e18;
+                        const int64_t quantized = isValid ? std::llround(scaled) : 0;
+                        const uint64_t diff = static_cast<uint64_t>(quantized) - static_cast<uint64_t>(prev);
+                        // Zigzag encoding: small negative differences get few significant bytes
+                        words[i] = (diff << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(diff) >> 63);
+                        prev = quantized;
+                    }
+                    if(isValid)
+                    {
+                        out.push_back(static_cast<uint8_t>(CompressionCodec::ErrorBounded));
+                        encodeWords(words.data(), numValues, out);
+                        return;
+                    }
+                }
+                Bits prev = 0;
+                for(size_t i = 0; i < numValues; ++i)
+                {
+                    Bits bits;
+                    std::memcpy(&bits, &values[i], sizeof(bits));
+                    words[i] = bits ^ prev;
+                    prev = bits;
+                }
+                out.push_back(static_cast<uint8_t>(CompressionCodec::Lossless));
+                encodeWords(words.data(), numValues, out);
+            }
+        };
+
+    }  // namespace detail
+
+    /**
+     * A volume held in memory as independently compressed blocks
+     * Suited for data that is mostly smooth or mostly zero which is kept between pipeline stages.
+     *
+     * The data is set with \ref assign and read either element-wise (blocks are decompressed on demand
+     * and kept in a small LRU cache) or in parallel with \ref materialize, e.g. slab-wise into the input of a FFT.
+     * Element access is not thread-safe, assign and materialize are.
+     *
+     * \tparam T_numDims Number of dimensions
+     * \tparam T_Precision float or double
+     * \tparam T_isComplex Whether the values are complex [false]
+     */
+    template< unsigned T_numDims, typename T_Precision, bool T_isComplex = false >
+    class CompressedVolume
+    {
+    public:
+        static constexpr unsigned numDims = T_numDims;
+        using Precision = T_Precision;
+        static constexpr bool isComplex = T_isComplex;
+        using Value = std::conditional_t< isComplex, types::Complex<Precision>, Precision >;
+        using IdxType = types::Vec< numDims, size_t >;
+        using IdentityAccessor = accessors::ArrayAccessor<true>;
+
+    private:
+        using Codec = detail::BlockCodec<Precision>;
+        static constexpr size_t scalarsPerValue = isComplex ? 2 : 1;
+        using Block = std::vector<Precision>;
+        using BlockPtr = std::shared_ptr<const Block>;
+
+        struct CacheEntry
+        {
+            size_t idx;
+            uint64_t lastUse;
+            BlockPtr block;
+        };
+
+        IdxType m_extents;
+        size_t m_numElements;
+        CompressionOptions m_options;
+        std::vector< std::vector<uint8_t> > m_blocks;
+
+        mutable std::mutex m_mutex;
+        mutable std::vector<CacheEntry> m_cache;
+        mutable uint64_t m_useCounter = 0;
+        /** Block of the last element access, avoids the cache lookup */
+        mutable BlockPtr m_lastBlock;
+        mutable size_t m_lastBlockIdx = 0;
+
+        static void
+        increment(IdxType& idx, const IdxType& extents)
+        {
+            for(unsigned i = numDims; i-- > 0;)
+            {
+                if(++idx[i] < extents[i])
+                    return;
+                idx[i] = 0;
+            }
+        }
+
+        static IdxType
+        unflatten(size_t flatIdx, const IdxType& extents)
+        {
+            IdxType idx;
+            for(unsigned i = numDims; i-- > 0;)
+            {
+                idx[i] = flatIdx % extents[i];
+                flatIdx /= extents[i];
+            }
+            return idx;
+        }
+
+        static void
+        toScalars(const Precision& value, Precision* out)
+        {
+            out[0] = value;
+        }
+
+        static void
+        toScalars(const types::Complex<Precision>& value, Precision* out)
+        {
+            out[0] = value.real;
+            out[1] = value.imag;
+        }
+
+        static Value
+        fromScalars(const Precision* in, std::false_type)
+        {
+            return in[0];
+        }
+
+        static Value
+        fromScalars(const Precision* in, std::true_type)
+        {
+            return Value(in[0], in[1]);
+        }
+
+        size_t
+        getBlockBegin(size_t blockIdx) const
+        {
+            return blockIdx * m_options.blockSize;
+        }
+
+        size_t
+        getBlockNumElements(size_t blockIdx) const
+        {
+            return std::min(m_options.blockSize, m_numElements - getBlockBegin(blockIdx));
+        }
+
+        void
+        decompress(size_t blockIdx, Block& block) const
+        {
+            block.resize(getBlockNumElements(blockIdx) * scalarsPerValue);
+            Codec::decompress(m_blocks[blockIdx], block.size(), m_options, block.data());
+        }
+
+        /**
+         * Calls func(blockIdx) for the blocks in [first, last) in parallel and rethrows the first error
+         */
+        template< class T_Func >
+        void
+        forEachBlock(size_t first, size_t last, T_Func&& func) const
+        {
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            policies::parallelFor<1>(last - first, m_options.numThreads, 1, [&](size_t begin, size_t end)
+            {
+                try
+                {
+                    for(size_t i = begin; i < end; ++i)
+                        func(first + i);
+                }catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if(!error)
+                        error = std::current_exception();
+                }
+            });
+            if(error)
+                std::rethrow_exception(error);
+        }
+
+        template< class T_Data >
+        void
+        checkExtents(const T_Data& data, size_t numPlanes) const
+        {
+            static_assert(traits::NumDims<T_Data>::value == numDims, "Wrong number of dimensions");
+            policies::GetExtents< T_Data > extents(data);
+            for(unsigned i = 0; i < numDims; ++i)
+            {
+                if(extents[i] != (i == 0 ? numPlanes : m_extents[i]))
+                    throw std::runtime_error("Extents do not match the compressed volume");
+            }
+        }
+
+    public:
+        /**
+         * Creates an empty (all zero) volume
+         *
+         * @param extents Extents of the volume
+         * @param options Compression options
+         */
+        template< class T_Extents >
+        explicit CompressedVolume(const T_Extents& extents, const CompressionOptions& options = CompressionOptions()):
+            m_options(options)
+        {
+            if(!m_options.blockSize)
+                throw std::runtime_error("Block size must not be 0");
+            if(m_options.codec == CompressionCodec::ErrorBounded && !(m_options.errorBound > 0))
+                throw std::runtime_error("Error bound must be positive");
+            m_numElements = 1;
+            for(unsigned i = 0; i < numDims; ++i)
+            {
+                m_extents[i] = extents[i];
+                m_numElements *= m_extents[i];
+            }
+            const size_t numBlocks = (m_numElements + m_options.blockSize - 1) / m_options.blockSize;
+            if(!numBlocks)
+                return;
+            // All full blocks compress to the same data
+            const Block zeros(getBlockNumElements(0) * scalarsPerValue, Precision(0));
+            std::vector<uint8_t> compressed;
+            Codec::compress(zeros.data(), zeros.size(), m_options, compressed);
+            m_blocks.resize(numBlocks, compressed);
+            Codec::compress(zeros.data(), getBlockNumElements(numBlocks - 1) * scalarsPerValue, m_options, m_blocks.back());
+        }
+
+        /**
+         * Compresses the data of a container with the same extents
+         *
+         * @param src    Source data
+         * @param srcAcc Accessor for the source [IdentityAccessor of T_Src]
+         */
+        template< class T_Src, class T_SrcAccessor = traits::IdentityAccessor_t<T_Src> >
+        void
+        assign(const T_Src& src, const T_SrcAccessor& srcAcc = T_SrcAccessor())
+        {
+            checkExtents(src, m_extents[0]);
+            clearCache();
+            forEachBlock(0, m_blocks.size(), [this, &src, &srcAcc](size_t blockIdx)
+            {
+                const size_t numElements = getBlockNumElements(blockIdx);
+                Block block(numElements * scalarsPerValue);
+                IdxType idx = unflatten(getBlockBegin(blockIdx), m_extents);
+                for(size_t i = 0; i < numElements; ++i, increment(idx, m_extents))
+                    toScalars(Value(srcAcc(idx, src)), &block[i * scalarsPerValue]);
+                std::vector<uint8_t> compressed;
+                Codec::compress(block.data(), block.size(), m_options, compressed);
+                compressed.shrink_to_fit();
+                m_blocks[blockIdx].swap(compressed);
+            });
+        }
+
+        /**
+         * Decompresses a slab of planes (indices of the first dimension) into a container in parallel
+         *
+         * @param dst        Destination with extents [numPlanes, extents[1], ...]
+         * @param firstPlane First plane of the slab [0]
+         * @param numPlanes  Number of planes, 0 for all planes from firstPlane [0]
+         * @param dstAcc     Accessor for the destination [IdentityAccessor of T_Dst]
+         */
+        template< class T_Dst, class T_DstAccessor = traits::IdentityAccessor_t<T_Dst> >
+        void
+        materialize(T_Dst& dst, size_t firstPlane = 0, size_t numPlanes = 0, const T_DstAccessor& dstAcc = T_DstAccessor()) const
+        {
+            if(!numPlanes)
+                numPlanes = m_extents[0] - std::min(firstPlane, m_extents[0]);
+            if(firstPlane + numPlanes > m_extents[0])
+                throw std::runtime_error("Slab exceeds the compressed volume");
+            checkExtents(dst, numPlanes);
+            const size_t planeSize = m_numElements / std::max<size_t>(m_extents[0], 1);
+            const size_t begin = firstPlane * planeSize;
+            const size_t end = begin + numPlanes * planeSize;
+            if(begin == end)
+                return;
+            IdxType dstExtents = m_extents;
+            dstExtents[0] = numPlanes;
+            forEachBlock(begin / m_options.blockSize, (end - 1) / m_options.blockSize + 1,
+                    [this, &dst, &dstAcc, &dstExtents, begin, end](size_t blockIdx)
+            {
+                Block block;
+                decompress(blockIdx, block);
+                const size_t blockBegin = getBlockBegin(blockIdx);
+                const size_t first = std::max(begin, blockBegin);
+                const size_t last = std::min(end, blockBegin + getBlockNumElements(blockIdx));
+                policies::detail::WriteAccessorWrapper< T_DstAccessor > writer(dstAcc);
+                IdxType idx = unflatten(first - begin, dstExtents);
+                for(size_t i = first; i < last; ++i, increment(idx, dstExtents))
+                    writer.write(idx, dst, fromScalars(&block[(i - blockBegin) * scalarsPerValue], std::integral_constant<bool, isComplex>()));
+            });
+        }
+
+        /**
+         * Returns a decompressed block, using the cache
+         */
+        BlockPtr
+        getBlock(size_t blockIdx) const
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for(CacheEntry& entry: m_cache)
+            {
+                if(entry.idx == blockIdx)
+                {
+                    entry.lastUse = ++m_useCounter;
+                    return entry.block;
+                }
+            }
+            lock.unlock();
+            std::shared_ptr<Block> block = std::make_shared<Block>();
+            decompress(blockIdx, *block);
+            lock.lock();
+            if(!m_options.cacheSize)
+                return block;
+            if(m_cache.size() >= m_options.cacheSize)
+            {
+                auto lru = std::min_element(m_cache.begin(), m_cache.end(),
+                        [](const CacheEntry& lhs, const CacheEntry& rhs){ return lhs.lastUse < rhs.lastUse; });
+                m_cache.erase(lru);
+            }
+            m_cache.push_back(CacheEntry{blockIdx, ++m_useCounter, block});
+            return block;
+        }
+
+        void
+        clearCache()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cache.clear();
+            m_lastBlock.reset();
+        }
+
+        template< typename T_Idx >
+        Value
+        operator()(const T_Idx& idx) const
+        {
+            size_t flatIdx = 0;
+            for(unsigned i = 0; i < numDims; ++i)
+                flatIdx = flatIdx * m_extents[i] + idx[i];
+            const size_t blockIdx = flatIdx / m_options.blockSize;
+            if(!m_lastBlock || m_lastBlockIdx != blockIdx)
+            {
+                m_lastBlock = getBlock(blockIdx);
+                m_lastBlockIdx = blockIdx;
+            }
+            return fromScalars(&(*m_lastBlock)[(flatIdx - getBlockBegin(blockIdx)) * scalarsPerValue], std::integral_constant<bool, isComplex>());
+        }
+
+        const IdxType&
+        getExtents() const
+        {
+            return m_extents;
+        }
+
+        const CompressionOptions&
+        getOptions() const
+        {
+            return m_options;
+        }
+
+        size_t
+        getNumBlocks() const
+        {
+            return m_blocks.size();
+        }
+
+        /**
+         * Returns the size of the uncompressed data in bytes
+         */
+        size_t
+        getMemSize() const
+        {
+            return m_numElements * sizeof(Value);
+        }
+
+        /**
+         * Returns the size of the compressed blocks in bytes
+         */
+        size_t
+        getCompressedSize() const
+        {
+            size_t size = 0;
+            for(const std::vector<uint8_t>& block: m_blocks)
+                size += block.size();
+            return size;
+        }
+    };
+
+}  // namespace mem
+
+namespace traits {
+
+    template< unsigned T_numDims, typename T_Precision, bool T_isComplex >
+    struct IntegralTypeImpl< mem::CompressedVolume< T_numDims, T_Precision, T_isComplex > >
+    {
+        using type = T_Precision;
+    };
+
+    template< unsigned T_numDims, typename T_Precision, bool T_isComplex >
+    struct IsStrided< mem::CompressedVolume< T_numDims, T_Precision, T_isComplex > >: std::integral_constant< bool, false >{};
+
+}  // namespace traits
+}  // namespace LiFFT
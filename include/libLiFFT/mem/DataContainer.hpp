@@ -20,6 +20,7 @@
 #include "libLiFFT/traits/IsComplex.hpp"
 #include "libLiFFT/traits/IsAoS.hpp"
 #include "libLiFFT/types/Vec.hpp"
+#include "libLiFFT/types/StaticExtents.hpp"
 #include "libLiFFT/accessors/DataContainerAccessor.hpp"
 #include "libLiFFT/policies/GetExtents.hpp"
 #include "libLiFFT/policies/GetNumElements.hpp"
@@ -276,17 +277,95 @@ namespace LiFFT {
             IdxType m_strides;
         };
 
+        /**
+         * Container whose extents are known at compile time
+         * Index calculations and size checks can then be resolved by the compiler
+         *
+         * \tparam T_Memory Memory type
+         * \tparam T_Extents types::StaticExtents describing the extents
+         * \tparam T_BaseAccessor Accessor for the memory
+         */
+        template< class T_Memory, class T_Extents, class T_BaseAccessor = traits::IdentityAccessor_t<T_Memory> >
+        struct StaticDataContainer: DataContainer< T_Extents::numDims, T_Memory, T_BaseAccessor, true, false >
+        {
+            static_assert(types::IsStaticExtents<T_Extents>::value, "Extents must be known at compile time");
+            using Parent = DataContainer< T_Extents::numDims, T_Memory, T_BaseAccessor, true, false >;
+            using StaticExtents = T_Extents;
+            using Memory = typename Parent::Memory;
+            using IdentityAccessor = typename Parent::IdentityAccessor;
+            static constexpr unsigned numDims = Parent::numDims;
+
+            /**
+             * Creates the container and allocates the memory
+             */
+            StaticDataContainer(): Parent(StaticExtents()){}
+
+            /**
+             * Creates the container using the given memory which must be big enough
+             */
+            explicit StaticDataContainer(const Memory& data): Parent(data, StaticExtents()){}
+            explicit StaticDataContainer(Memory&& data): Parent(std::move(data), StaticExtents()){}
+
+            template< typename T_Idx >
+            std::result_of_t< IdentityAccessor(T_Idx&, StaticDataContainer&) >
+            operator()(T_Idx&& idx)
+            {
+                assert(policies::checkSizes(idx, StaticExtents()));
+                return IdentityAccessor()(idx, *this);
+            }
+
+            template< typename T_Idx >
+            std::result_of_t< IdentityAccessor(T_Idx&, const StaticDataContainer&) >
+            operator()(T_Idx&& idx) const
+            {
+                assert(policies::checkSizes(idx, StaticExtents()));
+                return IdentityAccessor()(idx, *this);
+            }
+
+            static constexpr StaticExtents
+            getExtents()
+            {
+                return StaticExtents();
+            }
+        };
+
         /**
          * A container storing real data with automatic memory management
+         * The allocator can be used to control the placement of the memory (e.g. NumaAllocator)
          */
-        template< unsigned T_numDims, typename T_Precision, bool T_isStrided = false >
-        using RealContainer = DataContainer< T_numDims, RealValues<T_Precision>, traits::IdentityAccessor_t< RealValues<T_Precision> >, true, false >;
+        template< unsigned T_numDims, typename T_Precision, bool T_isStrided = false, class T_Allocator = DefaultAllocator >
+        using RealContainer = DataContainer<
+                                  T_numDims,
+                                  RealValues<T_Precision, true, T_Allocator>,
+                                  traits::IdentityAccessor_t< RealValues<T_Precision, true, T_Allocator> >,
+                                  true,
+                                  false
+                              >;
 
         /**
          * A container storing complex data with automatic memory management
+         * The allocator can be used to control the placement of the memory (e.g. NumaAllocator)
+         */
+        template< unsigned T_numDims, typename T_Precision, bool T_isStrided = false, class T_Allocator = DefaultAllocator >
+        using ComplexContainer = DataContainer<
+                                     T_numDims,
+                                     ComplexAoSValues<T_Precision, true, T_Allocator>,
+                                     traits::IdentityAccessor_t< ComplexAoSValues<T_Precision, true, T_Allocator> >,
+                                     true,
+                                     false
+                                 >;
+
+        /**
+         * A container storing real data with extents known at compile time
          */
-        template< unsigned T_numDims, typename T_Precision, bool T_isStrided = false >
-        using ComplexContainer = DataContainer< T_numDims, ComplexAoSValues<T_Precision>, traits::IdentityAccessor_t< ComplexAoSValues<T_Precision> >, true, false >;
+        template< typename T_Precision, unsigned... T_extents >
+        using StaticRealContainer = StaticDataContainer< RealValues<T_Precision>, types::StaticExtents< T_extents... > >;
+
+        /**
+         * A container storing complex data with extents known at compile time
+         */
+        template< typename T_Precision, unsigned... T_extents >
+        using StaticComplexContainer = StaticDataContainer< ComplexAoSValues<T_Precision>, types::StaticExtents< T_extents... > >;
 
     }  // namespace mem
 
@@ -302,6 +381,9 @@ namespace LiFFT {
         struct IsAoS< mem::DataContainer<T_numDims, T_Memory, T_BaseAccessor, T_isFlatMemory> >:
             IsAoS< typename mem::DataContainer<T_numDims, T_Memory, T_BaseAccessor, T_isFlatMemory>::Memory >{};
 
+        template< class T_Memory, class T_Extents, class T_BaseAccessor >
+        struct IsAoS< mem::StaticDataContainer<T_Memory, T_Extents, T_BaseAccessor> >: IsAoS< T_Memory >{};
+
     }  // namespace traits
 
 }  // namespace LiFFT
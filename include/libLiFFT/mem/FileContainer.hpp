@@ -49,6 +49,8 @@ namespace LiFFT {
 
         /**
          * A container that can load a file to an internal (contiguous) memory
+         * Raw binary and NumPy volumes can be used without loading via \ref MappedVolume
+         * Use \ref PrefetchFileContainer to load the next files of a sequence in the background
          *
          * \tparam T_FileHandler File class. Must support open(string), isOpen(), close(), and a specialization for GetExtents
          * \tparam T_FileAccessor Either an Array- or StreamAccessor that should provide an operator([index,] TFileHandler&) which
@@ -0,0 +1,523 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/RealValues.hpp"
+#include "libLiFFT/accessors/ArrayAccessor.hpp"
+#include "libLiFFT/policies/Copy.hpp"
+#include "libLiFFT/policies/GetExtents.hpp"
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include "libLiFFT/traits/IdentityAccessor.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/traits/IsBinaryCompatible.hpp"
+#include "libLiFFT/traits/IsStrided.hpp"
+#include "libLiFFT/types/Range.hpp"
+#include "libLiFFT/types/SliceView.hpp"
+#include "libLiFFT/types/Vec.hpp"
+#include "libLiFFT/types/View.hpp"
+#include "libLiFFT/void_t.hpp"
+#include "libLiFFT/c++14_types.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace LiFFT {
+namespace mem {
+
+    namespace detail {
+
+        /**
+         * Opens the image for reading a region of it and returns the offsets of the region in the opened image
+         * This default loads the whole image and checks its extents
+         */
+        template< class T_Image, typename T_SFINAE = void >
+        struct OpenImageRegion
+        {
+            static types::Vec<2>
+            open(T_Image& img, const std::string& filePath, const types::Vec<2>& offsets, const types::Vec<2>& /*extents*/,
+                    const types::Vec<2>& imageExtents)
+            {
+                img.open(filePath);
+                policies::GetExtents< T_Image > imgExtents(img);
+                if(imgExtents[0] != imageExtents[0] || imgExtents[1] != imageExtents[1])
+                    throw std::runtime_error("Image '" + filePath + "' has different extents than the first image of the stack");
+                return offsets;
+            }
+        };
+
+        /**
+         * Images supporting openRegion(filePath, x, y, w, h, loadData), getFileWidth/Height() and load() only decode the region
+         * Slices are already decoded in parallel, so the image itself uses only 1 thread (setNumThreads)
+         */
+        template< class T_Image >
+        struct OpenImageRegion<
+            T_Image,
+            void_t<
+                decltype(std::declval<T_Image&>().openRegion(std::string(), 0u, 0u, 0u, 0u)),
+                decltype(std::declval<T_Image&>().getFileWidth()),
+                decltype(std::declval<T_Image&>().getFileHeight()),
+                decltype(std::declval<T_Image&>().load()),
+                decltype(std::declval<T_Image&>().setNumThreads(1u))
+            >
+        >
+        {
+            static types::Vec<2>
+            open(T_Image& img, const std::string& filePath, const types::Vec<2>& offsets, const types::Vec<2>& extents,
+                    const types::Vec<2>& imageExtents)
+            {
+                img.setNumThreads(1);
+                img.openRegion(filePath, offsets[1], offsets[0], extents[1], extents[0], false);
+                if(img.getFileHeight() != imageExtents[0] || img.getFileWidth() != imageExtents[1])
+                    throw std::runtime_error("Image '" + filePath + "' has different extents than the first image of the stack");
+                img.load();
+                return types::Vec<2>(0u, 0u);
+            }
+        };
+
+        /**
+         * Images supporting readRegionTo(filePath, x, y, w, h, dst, rowStride) can decode a region directly into memory
+         * of type T_Value if it is binary compatible to their pixels and the accessor does not transform the pixels
+         */
+        template< class T_Image, class T_ImageAccessor, typename T_Value, typename T_SFINAE = void >
+        struct CanReadRegionTo: std::false_type{};
+
+        template< class T_Image, class T_ImageAccessor, typename T_Value >
+        struct CanReadRegionTo<
+            T_Image,
+            T_ImageAccessor,
+            T_Value,
+            void_t<
+                decltype(std::declval<T_Image&>().readRegionTo(std::string(), 0u, 0u, 0u, 0u, std::declval<typename T_Image::Pixel*>(), size_t(0))),
+                decltype(std::declval<T_Image&>().getFileWidth()),
+                decltype(std::declval<T_Image&>().getFileHeight()),
+                decltype(std::declval<T_Image&>().setNumThreads(1u))
+            >
+        >: std::integral_constant<
+            bool,
+            std::is_same< T_ImageAccessor, traits::IdentityAccessor_t<T_Image> >::value &&
+            traits::IsBinaryCompatible< typename T_Image::Pixel, T_Value >::value
+        >{};
+
+        /**
+         * Provides the contiguous memory of a container, that is the pointer to the element at index 0 for
+         * unstrided containers with flat memory accessed with their identity accessor (Value is void otherwise)
+         */
+        template< class T_Data, class T_Accessor, typename T_SFINAE = void >
+        struct ContiguousMemory
+        {
+            using Value = void;
+        };
+
+        template< class T_Data, class T_Accessor >
+        struct ContiguousMemory<
+            T_Data,
+            T_Accessor,
+            std::enable_if_t<
+                T_Data::isFlatMemory &&
+                !traits::IsStrided<T_Data>::value &&
+                std::is_same< T_Accessor, traits::IdentityAccessor_t<T_Data> >::value &&
+                std::is_pointer< decltype(std::declval<T_Data&>().getData()) >::value
+            >
+        >
+        {
+            using Value = std::remove_pointer_t< decltype(std::declval<T_Data&>().getData()) >;
+
+            static Value*
+            get(T_Data& data)
+            {
+                return data.getData();
+            }
+        };
+
+    }  // namespace detail
+
+    /**
+     * Presents a stack of 2D images (one file per slice) as a read-only 3D volume with extents
+     * [numImages, height, width] (optionally restricted to a region of each image)
+     *
+     * Slices are decoded when they are first accessed and kept in a LRU cache. Use \ref materialize
+     * to decode all slices in parallel into a container (e.g. the input of a 3D FFT).
+     * Element access is not thread-safe, materialize and prefetch are.
+     *
+     * \tparam T_Image 2D image type. Must be default constructible and support open(string) and GetExtents
+     * \tparam T_ImageAccessor Accessor used to read a pixel from the image [IdentityAccessor of the image]
+     * \tparam T_Precision Type of the values [float]
+     */
+    template<
+        class T_Image,
+        class T_ImageAccessor = traits::IdentityAccessor_t< T_Image >,
+        typename T_Precision = float
+    >
+    class ImageStackContainer
+    {
+    public:
+        using Image = T_Image;
+        using ImageAccessor = T_ImageAccessor;
+        using Precision = T_Precision;
+        static constexpr unsigned numDims = 3;
+        static constexpr bool isComplex = false;
+        using IdxType = types::Vec< numDims, size_t >;
+        using IdentityAccessor = accessors::ArrayAccessor<true>;
+        /** A decoded slice */
+        using Slice = DataContainer< 2, RealValues<Precision> >;
+        using SlicePtr = std::shared_ptr< const Slice >;
+
+    private:
+        using Extents2D = types::Vec<2>;
+
+        struct CacheEntry
+        {
+            size_t idx;
+            uint64_t lastUse;
+            SlicePtr slice;
+        };
+
+        std::vector<std::string> m_filePaths;
+        /** Extents of the images in the files */
+        Extents2D m_imageExtents;
+        /** Offset of the region in each image */
+        Extents2D m_offsets;
+        IdxType m_extents;
+        size_t m_cacheSize;
+        unsigned m_numThreads;
+
+        mutable std::mutex m_mutex;
+        mutable std::vector<CacheEntry> m_cache;
+        mutable uint64_t m_useCounter = 0;
+        /** Slice of the last element access, avoids the cache lookup */
+        mutable SlicePtr m_lastSlice;
+        mutable size_t m_lastSliceIdx = 0;
+
+        /**
+         * Returns the slice if it is in the cache (and marks it as used) or nullptr
+         */
+        SlicePtr
+        findInCache(size_t idx) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(CacheEntry& entry: m_cache)
+            {
+                if(entry.idx == idx)
+                {
+                    entry.lastUse = ++m_useCounter;
+                    return entry.slice;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Decodes a slice (the region of the image) into dst
+         */
+        template< class T_Dst >
+        void
+        decode(size_t idx, T_Dst& dst) const
+        {
+            Image img;
+            const Extents2D regionExtents(static_cast<unsigned>(m_extents[1]), static_cast<unsigned>(m_extents[2]));
+            const Extents2D offsets = detail::OpenImageRegion< Image >::open(img, m_filePaths[idx], m_offsets, regionExtents, m_imageExtents);
+            auto view = types::makeView(img, types::makeRange(offsets, regionExtents), ImageAccessor());
+            policies::copy(view, dst);
+        }
+
+        /**
+         * Decodes a slice directly into contiguous memory with the extents of a slice,
+         * which avoids the image buffer and the copy from it
+         */
+        template< typename T_Value >
+        void
+        decodeTo(size_t idx, T_Value* dst) const
+        {
+            Image img;
+            img.setNumThreads(1);
+            img.readRegionTo(m_filePaths[idx], m_offsets[1], m_offsets[0], static_cast<unsigned>(m_extents[2]), static_cast<unsigned>(m_extents[1]),
+                    reinterpret_cast<typename Image::Pixel*>(dst), m_extents[2]);
+            if(img.getFileHeight() != m_imageExtents[0] || img.getFileWidth() != m_imageExtents[1])
+                throw std::runtime_error("Image '" + m_filePaths[idx] + "' has different extents than the first image of the stack");
+        }
+
+        /**
+         * Decodes slice idx into slice dstIdx of the (2D or 3D) destination,
+         * directly if the image and the destination memory support it
+         */
+        template< class T_Dst, class T_DstAccessor >
+        void
+        decodeSlice(size_t idx, T_Dst& dst, const T_DstAccessor& dstAcc, size_t dstIdx) const
+        {
+            using Value = typename detail::ContiguousMemory< T_Dst, T_DstAccessor >::Value;
+            decodeSlice(idx, dst, dstAcc, dstIdx, detail::CanReadRegionTo< Image, ImageAccessor, Value >());
+        }
+
+        template< class T_Dst, class T_DstAccessor >
+        void
+        decodeSlice(size_t idx, T_Dst& dst, const T_DstAccessor& /*dstAcc*/, size_t dstIdx, std::true_type) const
+        {
+            decodeTo(idx, detail::ContiguousMemory< T_Dst, T_DstAccessor >::get(dst) + dstIdx * m_extents[1] * m_extents[2]);
+        }
+
+        template< class T_Dst, class T_DstAccessor >
+        void
+        decodeSlice(size_t idx, T_Dst& dst, const T_DstAccessor& dstAcc, size_t dstIdx, std::false_type) const
+        {
+            copySlice(idx, dst, dstAcc, dstIdx, std::integral_constant< bool, traits::NumDims<T_Dst>::value == numDims >());
+        }
+
+        template< class T_Dst, class T_DstAccessor >
+        void
+        copySlice(size_t idx, T_Dst& dst, const T_DstAccessor& dstAcc, size_t dstIdx, std::true_type) const
+        {
+            auto dstSlice = types::makeSliceView<0>(dst, types::makeRange(types::Vec<numDims>(static_cast<unsigned>(dstIdx), 0u, 0u)), dstAcc);
+            decode(idx, dstSlice);
+        }
+
+        template< class T_Dst, class T_DstAccessor >
+        void
+        copySlice(size_t idx, T_Dst& dst, const T_DstAccessor& /*dstAcc*/, size_t /*dstIdx*/, std::false_type) const
+        {
+            decode(idx, dst);
+        }
+
+        /**
+         * Calls func(idx) for each slice in [first, first + count) in parallel and rethrows the first error
+         */
+        template< class T_Func >
+        void
+        forEachSlice(size_t first, size_t count, T_Func&& func) const
+        {
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            policies::parallelFor<1>(count, m_numThreads, 1, [&](size_t begin, size_t end)
+            {
+                try
+                {
+                    for(size_t i = begin; i < end; ++i)
+                        func(first + i);
+                }catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if(!error)
+                        error = std::current_exception();
+                }
+            });
+            if(error)
+                std::rethrow_exception(error);
+        }
+
+    public:
+        /**
+         * Creates the stack from a list of files, the first file is opened to get the extents
+         *
+         * @param filePaths  Files in the order of the slices
+         * @param cacheSize  Maximum number of decoded slices kept in memory [8]
+         * @param numThreads Number of threads used to decode slices in parallel, 0 for all hardware threads [0]
+         */
+        explicit ImageStackContainer(const std::vector<std::string>& filePaths, size_t cacheSize = 8, unsigned numThreads = 0):
+            m_filePaths(filePaths), m_cacheSize(cacheSize), m_numThreads(numThreads)
+        {
+            if(m_filePaths.empty())
+                throw std::runtime_error("Image stack must contain at least 1 file");
+            Image img;
+            img.open(m_filePaths.front());
+            policies::GetExtents< Image > imgExtents(img);
+            m_imageExtents = Extents2D(imgExtents[0], imgExtents[1]);
+            m_offsets = Extents2D(0u, 0u);
+            m_extents = IdxType(m_filePaths.size(), m_imageExtents[0], m_imageExtents[1]);
+        }
+
+        /**
+         * Creates the stack from files named by a printf pattern
+         *
+         * @param pattern    printf pattern with one integer conversion, e.g. "data%04i.tif"
+         * @param firstIdx   Index of the first file
+         * @param lastIdx    Index of the last file (inclusive)
+         * @param cacheSize  Maximum number of decoded slices kept in memory [8]
+         * @param numThreads Number of threads used to decode slices in parallel, 0 for all hardware threads [0]
+         */
+        ImageStackContainer(const std::string& pattern, int firstIdx, int lastIdx, size_t cacheSize = 8, unsigned numThreads = 0):
+            ImageStackContainer(getFilePaths(pattern, firstIdx, lastIdx), cacheSize, numThreads)
+        {}
+
+        /**
+         * Returns the file paths for a printf pattern with one integer conversion
+         */
+        static std::vector<std::string>
+        getFilePaths(const std::string& pattern, int firstIdx, int lastIdx)
+        {
+            std::vector<std::string> filePaths;
+            for(int i = firstIdx; i <= lastIdx; ++i)
+            {
+                int len = std::snprintf(nullptr, 0, pattern.c_str(), i);
+                if(len < 0)
+                    throw std::runtime_error("Invalid file pattern '" + pattern + "'");
+                std::vector<char> filePath(len + 1);
+                std::snprintf(filePath.data(), filePath.size(), pattern.c_str(), i);
+                filePaths.emplace_back(filePath.data());
+            }
+            return filePaths;
+        }
+
+        /**
+         * Restricts the stack to a region of each image
+         *
+         * @param offsets Offsets of the region in index order (row, column)
+         * @param extents Extents of the region in index order (rows, columns)
+         */
+        void
+        setRegion(const Extents2D& offsets, const Extents2D& extents)
+        {
+            for(unsigned i = 0; i < 2; ++i)
+            {
+                if(offsets[i] >= m_imageExtents[i] || extents[i] > m_imageExtents[i] - offsets[i] || !extents[i])
+                    throw std::runtime_error("Region exceeds the image extents");
+            }
+            clearCache();
+            m_offsets = offsets;
+            m_extents[1] = extents[0];
+            m_extents[2] = extents[1];
+        }
+
+        const IdxType&
+        getExtents() const
+        {
+            return m_extents;
+        }
+
+        const std::vector<std::string>&
+        getFilePaths() const
+        {
+            return m_filePaths;
+        }
+
+        /**
+         * Returns a decoded slice, decoding it if it is not in the cache
+         */
+        SlicePtr
+        getSlice(size_t idx) const
+        {
+            SlicePtr cached = findInCache(idx);
+            if(cached)
+                return cached;
+            std::shared_ptr<Slice> slice = std::make_shared<Slice>(Extents2D(static_cast<unsigned>(m_extents[1]), static_cast<unsigned>(m_extents[2])));
+            decodeSlice(idx, *slice, traits::IdentityAccessor_t<Slice>(), 0);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(const CacheEntry& entry: m_cache)
+            {
+                // Decoded concurrently by another thread
+                if(entry.idx == idx)
+                    return entry.slice;
+            }
+            if(!m_cacheSize)
+                return slice;
+            if(m_cache.size() >= m_cacheSize)
+            {
+                auto lru = std::min_element(m_cache.begin(), m_cache.end(),
+                        [](const CacheEntry& lhs, const CacheEntry& rhs){ return lhs.lastUse < rhs.lastUse; });
+                m_cache.erase(lru);
+            }
+            m_cache.push_back(CacheEntry{idx, ++m_useCounter, slice});
+            return slice;
+        }
+
+        /**
+         * Decodes slices in parallel into the cache (only the last cacheSize slices are kept)
+         *
+         * @param first Index of the first slice
+         * @param count Number of slices
+         */
+        void
+        prefetch(size_t first, size_t count) const
+        {
+            if(first + count > m_extents[0])
+                throw std::runtime_error("Slices out of range");
+            forEachSlice(first, count, [this](size_t idx){ getSlice(idx); });
+        }
+
+        /**
+         * Decodes all slices in parallel directly into a 3D container bypassing the cache
+         * Images supporting it are decoded straight into the memory of unstrided containers (e.g. the FFT input)
+         *
+         * @param dst    Destination with the same extents as this
+         * @param dstAcc Accessor for the destination [IdentityAccessor of T_Dst]
+         */
+        template< class T_Dst, class T_DstAccessor = traits::IdentityAccessor_t<T_Dst> >
+        void
+        materialize(T_Dst& dst, const T_DstAccessor& dstAcc = T_DstAccessor()) const
+        {
+            static_assert(traits::NumDims<T_Dst>::value == numDims, "Destination must be 3D");
+            policies::GetExtents< T_Dst > dstExtents(dst);
+            for(unsigned i = 0; i < numDims; ++i)
+            {
+                if(dstExtents[i] != m_extents[i])
+                    throw std::runtime_error("Destination extents do not match the image stack");
+            }
+            forEachSlice(0, m_extents[0], [this, &dst, &dstAcc](size_t idx)
+            {
+                SlicePtr cached = findInCache(idx);
+                if(cached)
+                {
+                    auto dstSlice = types::makeSliceView<0>(dst, types::makeRange(types::Vec<numDims>(static_cast<unsigned>(idx), 0u, 0u)), dstAcc);
+                    policies::copy(*cached, dstSlice);
+                }else
+                    decodeSlice(idx, dst, dstAcc, idx);
+            });
+        }
+
+        /**
+         * Removes all decoded slices from the cache
+         */
+        void
+        clearCache()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cache.clear();
+            m_lastSlice.reset();
+        }
+
+        template< typename T_Idx >
+        Precision
+        operator()(const T_Idx& idx) const
+        {
+            if(!m_lastSlice || m_lastSliceIdx != idx[0])
+            {
+                m_lastSlice = getSlice(idx[0]);
+                m_lastSliceIdx = idx[0];
+            }
+            return (*m_lastSlice)(types::Vec<2, size_t>(idx[1], idx[2]));
+        }
+    };
+
+}  // namespace mem
+
+namespace traits {
+
+    template< class T_Image, class T_ImageAccessor, typename T_Precision >
+    struct IntegralTypeImpl< mem::ImageStackContainer< T_Image, T_ImageAccessor, T_Precision > >
+    {
+        using type = T_Precision;
+    };
+
+    template< class T_Image, class T_ImageAccessor, typename T_Precision >
+    struct IsStrided< mem::ImageStackContainer< T_Image, T_ImageAccessor, T_Precision > >: std::integral_constant< bool, false >{};
+
+}  // namespace traits
+}  // namespace LiFFT
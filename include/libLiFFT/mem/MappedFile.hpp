@@ -0,0 +1,264 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/ignore_unused.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#if defined(__unix__)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * How a mapped range is going to be accessed, passed to the kernel to tune read-ahead
+     */
+    enum class AccessHint
+    {
+        /** No special treatment */
+        Normal,
+        /** Read front to back, aggressive read-ahead and early reclaim of read pages */
+        Sequential,
+        /** The range is needed soon, reading starts in the background right away */
+        WillNeed,
+        /** Random access, read-ahead is disabled */
+        Random
+    };
+
+    /**
+     * A file mapped into memory
+     * Read-only files are mapped copy-on-write: The memory may be modified (e.g. by an inplace FFT)
+     * but the changes are never written to the file. Writable files are shared mappings where
+     * all changes end up in the file.
+     */
+    class MappedFile
+    {
+        char* m_data = nullptr;
+        size_t m_size = 0;
+        bool m_isWritable = false;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+#if defined(__unix__)
+        static std::string
+        getError(const std::string& msg, const std::string& filePath)
+        {
+            return msg + " '" + filePath + "': " + std::strerror(errno);
+        }
+
+        void
+        map(int fd, const std::string& filePath, size_t size, bool isWritable)
+        {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, isWritable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+            const std::string error = ptr == MAP_FAILED ? getError("Could not map", filePath) : "";
+            ::close(fd);
+            if(ptr == MAP_FAILED)
+                throw std::runtime_error(error);
+            m_data = static_cast<char*>(ptr);
+            m_size = size;
+            m_isWritable = isWritable;
+        }
+#endif
+
+    public:
+        MappedFile() = default;
+
+        /**
+         * Maps an existing file
+         *
+         * @param filePath   Path to the file
+         * @param isWritable Whether changes are written to the file
+         */
+        explicit MappedFile(const std::string& filePath, bool isWritable = false)
+        {
+            open(filePath, isWritable);
+        }
+
+        MappedFile(MappedFile&& obj): m_data(obj.m_data), m_size(obj.m_size), m_isWritable(obj.m_isWritable)
+        {
+            obj.m_data = nullptr;
+            obj.m_size = 0;
+        }
+
+        MappedFile&
+        operator=(MappedFile&& obj)
+        {
+            if(this != &obj)
+            {
+                close();
+                std::swap(m_data, obj.m_data);
+                std::swap(m_size, obj.m_size);
+                m_isWritable = obj.m_isWritable;
+            }
+            return *this;
+        }
+
+        ~MappedFile()
+        {
+            close();
+        }
+
+        /**
+         * Maps an existing file
+         *
+         * @param filePath   Path to the file
+         * @param isWritable Whether changes are written to the file
+         */
+        void
+        open(const std::string& filePath, bool isWritable = false)
+        {
+            close();
+#if defined(__unix__)
+            int fd = ::open(filePath.c_str(), isWritable ? O_RDWR : O_RDONLY);
+            if(fd < 0)
+                throw std::runtime_error(getError("Could not open", filePath));
+            struct stat fileStat;
+            if(fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot map empty or unreadable file '" + filePath + "'");
+            }
+            map(fd, filePath, static_cast<size_t>(fileStat.st_size), isWritable);
+#else
+            throw std::runtime_error("Memory mapped files are not supported on this platform");
+#endif
+        }
+
+        /**
+         * Creates (or truncates) a file with the given size and maps it writable
+         *
+         * @param filePath Path to the file
+         * @param size     Size of the file in bytes
+         */
+        void
+        create(const std::string& filePath, size_t size)
+        {
+            close();
+            if(!size)
+                throw std::runtime_error("Cannot map empty file '" + filePath + "'");
+#if defined(__unix__)
+            int fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if(fd < 0)
+                throw std::runtime_error(getError("Could not create", filePath));
+            if(ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                const std::string error = getError("Could not resize", filePath);
+                ::close(fd);
+                throw std::runtime_error(error);
+            }
+            map(fd, filePath, size, true);
+#else
+            throw std::runtime_error("Memory mapped files are not supported on this platform");
+#endif
+        }
+
+        /**
+         * Unmaps the file, changes to writable files are written back by the OS
+         */
+        void
+        close()
+        {
+            if(!m_data)
+                return;
+#if defined(__unix__)
+            munmap(m_data, m_size);
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        /**
+         * Passes a hint about the access pattern to the kernel
+         *
+         * @param hint   Access pattern
+         * @param offset Start of the range in bytes [0]
+         * @param size   Size of the range in bytes, 0 for the rest of the file [0]
+         */
+        void
+        advise(AccessHint hint, size_t offset = 0, size_t size = 0) const
+        {
+#if defined(__unix__)
+            if(!m_data || offset >= m_size)
+                return;
+            if(!size || offset + size > m_size)
+                size = m_size - offset;
+            // madvise needs page aligned addresses
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            const size_t alignedOffset = offset / pageSize * pageSize;
+            int advice = MADV_NORMAL;
+            if(hint == AccessHint::Sequential)
+                advice = MADV_SEQUENTIAL;
+            else if(hint == AccessHint::WillNeed)
+                advice = MADV_WILLNEED;
+            else if(hint == AccessHint::Random)
+                advice = MADV_RANDOM;
+            // Only a hint, failures do not matter
+            madvise(m_data + alignedOffset, size + offset - alignedOffset, advice);
+#else
+            ignore_unused(hint, offset, size);
+#endif
+        }
+
+        /**
+         * Writes all changes to the file and waits for completion (no-op for read-only files)
+         */
+        void
+        flush()
+        {
+#if defined(__unix__)
+            if(m_data && m_isWritable && msync(m_data, m_size, MS_SYNC) != 0)
+                throw std::runtime_error(std::string("Could not write mapped file: ") + std::strerror(errno));
+#endif
+        }
+
+        bool
+        isOpen() const
+        {
+            return m_data != nullptr;
+        }
+
+        bool
+        isWritable() const
+        {
+            return m_isWritable;
+        }
+
+        char*
+        getData() const
+        {
+            return m_data;
+        }
+
+        size_t
+        getSize() const
+        {
+            return m_size;
+        }
+    };
+
+}  // namespace mem
+}  // namespace LiFFT
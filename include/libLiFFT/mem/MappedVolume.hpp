@@ -0,0 +1,358 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/mem/MappedFile.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/RealValues.hpp"
+#include "libLiFFT/mem/ComplexAoSValues.hpp"
+#include "libLiFFT/traits/IsAoS.hpp"
+#include "libLiFFT/types/Vec.hpp"
+#include "libLiFFT/c++14_types.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace LiFFT {
+namespace mem {
+
+    namespace detail {
+
+        /**
+         * Header of a NumPy .npy file (format version 1.0-3.0)
+         */
+        struct NpyHeader
+        {
+            /** Type description, e.g. '<f4' */
+            std::string descr;
+            bool isFortranOrder = false;
+            std::vector<size_t> shape;
+            /** Offset of the data from the start of the file in bytes */
+            size_t dataOffset = 0;
+        };
+
+        constexpr char npyMagic[] = "\x93NUMPY";
+        constexpr size_t npyMagicLen = 6;
+        /** NumPy aligns the data to this, which also suits vectorized code */
+        constexpr size_t npyAlignment = 64;
+
+        inline bool
+        isLittleEndian()
+        {
+            const uint16_t value = 1;
+            char firstByte;
+            std::memcpy(&firstByte, &value, 1);
+            return firstByte == 1;
+        }
+
+        /**
+         * Returns the value of the given key in the header dictionary (without the key and whitespace)
+         */
+        inline std::string
+        getNpyValue(const std::string& dict, const std::string& key)
+        {
+            size_t pos = dict.find("'" + key + "'");
+            if(pos == std::string::npos)
+                throw std::runtime_error("Missing key '" + key + "' in npy header");
+            pos = dict.find(':', pos);
+            if(pos == std::string::npos)
+                throw std::runtime_error("Invalid npy header");
+            pos = dict.find_first_not_of(' ', pos + 1);
+            if(pos == std::string::npos)
+                throw std::runtime_error("Invalid npy header");
+            size_t end;
+            if(dict[pos] == '(')
+                end = dict.find(')', pos) + 1;
+            else if(dict[pos] == '\'')
+                end = dict.find('\'', pos + 1) + 1;
+            else
+                end = dict.find_first_of(",}", pos);
+            if(end == std::string::npos || end == 0)
+                throw std::runtime_error("Invalid npy header");
+            return dict.substr(pos, end - pos);
+        }
+
+        /**
+         * Parses the header at the start of a npy file
+         *
+         * @param data Start of the file
+         * @param size Size of the file in bytes
+         */
+        inline NpyHeader
+        parseNpyHeader(const char* data, size_t size)
+        {
+            if(size < npyMagicLen + 4 || std::memcmp(data, npyMagic, npyMagicLen) != 0)
+                throw std::runtime_error("Not a npy file");
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            const unsigned version = bytes[npyMagicLen];
+            size_t headerLen, headerStart;
+            if(version == 1)
+            {
+                headerLen = bytes[8] | (size_t(bytes[9]) << 8);
+                headerStart = 10;
+            }else if(version == 2 || version == 3)
+            {
+                if(size < 12)
+                    throw std::runtime_error("Not a npy file");
+                headerLen = bytes[8] | (size_t(bytes[9]) << 8) | (size_t(bytes[10]) << 16) | (size_t(bytes[11]) << 24);
+                headerStart = 12;
+            }else
+                throw std::runtime_error("Unsupported npy version " + std::to_string(version));
+            if(headerStart + headerLen > size)
+                throw std::runtime_error("Truncated npy header");
+            const std::string dict(data + headerStart, headerLen);
+
+            NpyHeader header;
+            header.dataOffset = headerStart + headerLen;
+            const std::string descr = getNpyValue(dict, "descr");
+            header.descr = descr.substr(1, descr.size() - 2);
+            header.isFortranOrder = getNpyValue(dict, "fortran_order") == "True";
+            const std::string shape = getNpyValue(dict, "shape");
+            for(size_t pos = 1; pos < shape.size(); )
+            {
+                pos = shape.find_first_of("0123456789", pos);
+                if(pos == std::string::npos)
+                    break;
+                size_t end;
+                header.shape.push_back(std::stoull(shape.substr(pos), &end));
+                pos += end;
+            }
+            return header;
+        }
+
+        /**
+         * Creates a npy (version 1.0) header whose size keeps the data aligned
+         */
+        inline std::string
+        makeNpyHeader(const std::string& descr, const std::vector<size_t>& shape)
+        {
+            std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (";
+            for(size_t extent: shape)
+                dict += std::to_string(extent) + ", ";
+            if(shape.size() > 1)
+                dict.erase(dict.size() - 2);
+            else if(shape.size() == 1)
+                dict.erase(dict.size() - 1);
+            dict += "), }";
+            // Pad with spaces and terminate with a newline
+            const size_t preambleLen = npyMagicLen + 4;
+            const size_t totalLen = (preambleLen + dict.size() + 1 + npyAlignment - 1) / npyAlignment * npyAlignment;
+            const size_t headerLen = totalLen - preambleLen;
+            if(headerLen > 0xFFFF)
+                throw std::runtime_error("npy header too long");
+            dict.resize(headerLen - 1, ' ');
+            dict += '\n';
+            std::string header(npyMagic, npyMagicLen);
+            header += char(1);
+            header += char(0);
+            header += char(headerLen & 0xFF);
+            header += char(headerLen >> 8);
+            return header + dict;
+        }
+
+        /**
+         * Returns the npy type description for the given value type in native byte order
+         */
+        template< typename T_Precision, bool T_isComplex >
+        std::string
+        getNpyDescr()
+        {
+            static_assert(std::is_floating_point<T_Precision>::value, "Only floating point types are supported");
+            const char order = isLittleEndian() ? '<' : '>';
+            return order + std::string(T_isComplex ? "c" : "f") + std::to_string(sizeof(T_Precision) * (T_isComplex ? 2 : 1));
+        }
+
+    }  // namespace detail
+
+    /**
+     * A volume that resides in a memory mapped file (raw binary or NumPy .npy)
+     * This is a DataContainer that uses the mapped memory directly, so no data is copied on loading
+     * and the file can be passed to the FFT without internal memory. Pages are read on first access.
+     * Files opened read-only are mapped copy-on-write, changes to them are lost on destruction.
+     * Writable files are updated in place, so an output volume needs no separate write pass
+     *
+     * \tparam T_numDims Number of dimensions
+     * \tparam T_Precision Floating point type (float or double)
+     * \tparam T_isComplex Whether the values are complex (interleaved real and imaginary parts)
+     */
+    template< unsigned T_numDims, typename T_Precision, bool T_isComplex = false >
+    class MappedVolume: public DataContainer<
+                                   T_numDims,
+                                   std::conditional_t< T_isComplex, ComplexAoSValues<T_Precision, false>, RealValues<T_Precision, false> >
+                               >
+    {
+    public:
+        using Parent = DataContainer<
+                           T_numDims,
+                           std::conditional_t< T_isComplex, ComplexAoSValues<T_Precision, false>, RealValues<T_Precision, false> >
+                       >;
+        using Memory = typename Parent::Memory;
+        using Value = typename Memory::Value;
+        using IdxType = typename Parent::IdxType;
+        using Precision = T_Precision;
+        static constexpr unsigned numDims = T_numDims;
+
+    private:
+        MappedFile m_file;
+        size_t m_dataOffset = 0;
+        bool m_isFortranOrder = false;
+
+        template< class T_Extents >
+        static size_t
+        getNumElements(const T_Extents& extents)
+        {
+            size_t numElements = 1;
+            for(unsigned i = 0; i < numDims; ++i)
+                numElements *= extents[i];
+            return numElements;
+        }
+
+        template< class T_Extents >
+        MappedVolume(MappedFile&& file, size_t dataOffset, const T_Extents& extents, AccessHint hint):
+            Parent(Memory(reinterpret_cast<Value*>(file.getData() + dataOffset), getNumElements(extents)), extents),
+            m_file(std::move(file)), m_dataOffset(dataOffset)
+        {
+            if(dataOffset % alignof(Value))
+                throw std::runtime_error("Offset of the data is not aligned for the value type");
+            if(dataOffset + getNumElements(extents) * sizeof(Value) > m_file.getSize())
+                throw std::runtime_error("File is too small for the given extents");
+            advise(hint);
+        }
+
+    public:
+        MappedVolume() = default;
+        MappedVolume(MappedVolume&&) = default;
+        MappedVolume& operator=(MappedVolume&&) = default;
+
+        /**
+         * Maps a raw binary file with values in native byte order and row-major layout
+         *
+         * @param filePath   Path to the file
+         * @param extents    Extents of the volume
+         * @param dataOffset Offset of the first value in bytes (e.g. to skip a header) [0]
+         * @param isWritable Whether changes are written to the file [false]
+         * @param hint       How the data is going to be accessed [Sequential]
+         */
+        template< class T_Extents >
+        static MappedVolume
+        openRaw(const std::string& filePath, const T_Extents& extents, size_t dataOffset = 0, bool isWritable = false, AccessHint hint = AccessHint::Sequential)
+        {
+            return MappedVolume(MappedFile(filePath, isWritable), dataOffset, extents, hint);
+        }
+
+        /**
+         * Creates a raw binary file for the given extents and maps it writable
+         */
+        template< class T_Extents >
+        static MappedVolume
+        createRaw(const std::string& filePath, const T_Extents& extents, AccessHint hint = AccessHint::Sequential)
+        {
+            MappedFile file;
+            file.create(filePath, getNumElements(extents) * sizeof(Value));
+            return MappedVolume(std::move(file), 0, extents, hint);
+        }
+
+        /**
+         * Maps a NumPy .npy file, the type and number of dimensions must match
+         * Files in Fortran order are exposed with reversed extents (that is transposed) as this is the only zero-copy view
+         *
+         * @param filePath   Path to the file
+         * @param isWritable Whether changes are written to the file [false]
+         * @param hint       How the data is going to be accessed [Sequential]
+         */
+        static MappedVolume
+        openNpy(const std::string& filePath, bool isWritable = false, AccessHint hint = AccessHint::Sequential)
+        {
+            MappedFile file(filePath, isWritable);
+            const detail::NpyHeader header = detail::parseNpyHeader(file.getData(), file.getSize());
+            const std::string expectedDescr = detail::getNpyDescr<Precision, T_isComplex>();
+            // '=' also denotes native byte order
+            if(header.descr != expectedDescr && header.descr != "=" + expectedDescr.substr(1))
+                throw std::runtime_error("Type mismatch in '" + filePath + "': Expected " + expectedDescr + ", got " + header.descr);
+            if(header.shape.size() != numDims)
+                throw std::runtime_error("Wrong number of dimensions in '" + filePath + "': " + std::to_string(header.shape.size()));
+            IdxType extents;
+            for(unsigned i = 0; i < numDims; ++i)
+                extents[i] = header.shape[header.isFortranOrder ? numDims - 1 - i : i];
+            MappedVolume result(std::move(file), header.dataOffset, extents, hint);
+            result.m_isFortranOrder = header.isFortranOrder;
+            return result;
+        }
+
+        /**
+         * Creates a NumPy .npy file for the given extents and maps it writable
+         */
+        template< class T_Extents >
+        static MappedVolume
+        createNpy(const std::string& filePath, const T_Extents& extents, AccessHint hint = AccessHint::Sequential)
+        {
+            std::vector<size_t> shape(numDims);
+            for(unsigned i = 0; i < numDims; ++i)
+                shape[i] = extents[i];
+            const std::string header = detail::makeNpyHeader(detail::getNpyDescr<Precision, T_isComplex>(), shape);
+            MappedFile file;
+            file.create(filePath, header.size() + getNumElements(extents) * sizeof(Value));
+            std::memcpy(file.getData(), header.data(), header.size());
+            return MappedVolume(std::move(file), header.size(), extents, hint);
+        }
+
+        /**
+         * Passes a hint about the access pattern of the data to the kernel
+         */
+        void
+        advise(AccessHint hint) const
+        {
+            m_file.advise(hint, m_dataOffset, this->getMemSize());
+        }
+
+        /**
+         * Writes all changes to the file (only for writable files)
+         */
+        void
+        flush()
+        {
+            m_file.flush();
+        }
+
+        /**
+         * Returns true if the file is in Fortran (column-major) order, the extents are reversed then
+         */
+        bool
+        isFortranOrder() const
+        {
+            return m_isFortranOrder;
+        }
+
+        bool
+        isWritable() const
+        {
+            return m_file.isWritable();
+        }
+    };
+
+}  // namespace mem
+
+namespace traits {
+
+    template< unsigned T_numDims, typename T_Precision, bool T_isComplex >
+    struct IsAoS< mem::MappedVolume< T_numDims, T_Precision, T_isComplex > >: std::true_type{};
+
+}  // namespace traits
+}  // namespace LiFFT
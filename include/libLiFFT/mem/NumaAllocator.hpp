@@ -0,0 +1,484 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#ifdef __linux__
+#   include <linux/mempolicy.h>
+#   include <sched.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+namespace LiFFT {
+namespace mem {
+
+    /**
+     * Where the pages of a buffer are placed on NUMA systems
+     */
+    enum class NumaPolicy
+    {
+        /** Pages are placed on the node of the thread that touches them first (OS default, nothing is touched on allocation) */
+        FirstTouch,
+        /**
+         * Pages are touched on allocation by all threads with the same partitioning policies::parallelFor uses.
+         * Consecutive chunks go to the online nodes in order, the touching threads are pinned to the CPUs of their node
+         */
+        ParallelFirstTouch,
+        /** Pages are interleaved round-robin over all nodes */
+        Interleave,
+        /** Pages are bound to one node */
+        Bind
+    };
+
+    /**
+     * Whether huge pages (2MiB) are used to back a buffer
+     */
+    enum class HugePages
+    {
+        /** Regular pages only */
+        None,
+        /** Transparent huge pages requested via madvise, the buffer is aligned to the huge page size */
+        Transparent,
+        /** Pages from the hugetlb pool (MAP_HUGETLB), allocation fails if the pool is too small */
+        Explicit
+    };
+
+    namespace detail {
+
+        constexpr size_t hugePageSize = size_t(2) << 20;
+        /**
+         * Offset of the data in the mapping, space for the header and keeps the data SIMD aligned
+         */
+        constexpr size_t mappingDataOffset = 64;
+        /**
+         * Minimum number of elements a thread touches on allocation.
+         * Large buffers are split exactly like in the parallel loops (parallelFor using all threads)
+         */
+        constexpr size_t minFirstTouchElementsPerThread = 1 << 16;
+
+        struct MappingHeader
+        {
+            void* base;
+            size_t size;
+        };
+        static_assert(sizeof(MappingHeader) <= mappingDataOffset, "Header does not fit");
+
+        inline size_t
+        roundUp(size_t value, size_t multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        /**
+         * Parses a list as used in sysfs for nodes and CPUs (e.g. "0-3,5") into the sorted ids
+         */
+        inline std::vector<unsigned>
+        parseIdList(const std::string& list)
+        {
+            std::vector<unsigned> result;
+            std::istringstream stream(list);
+            std::string range;
+            while(std::getline(stream, range, ','))
+            {
+                if(range.empty())
+                    continue;
+                size_t pos = range.find('-');
+                unsigned first = std::stoul(range.substr(0, pos));
+                unsigned last = pos == std::string::npos ? first : std::stoul(range.substr(pos + 1));
+                for(unsigned id = first; id <= last; ++id)
+                    result.push_back(id);
+            }
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            return result;
+        }
+
+#ifdef __linux__
+
+        inline size_t
+        getPageSize()
+        {
+            long pageSize = sysconf(_SC_PAGESIZE);
+            return pageSize > 0 ? static_cast<size_t>(pageSize) : 4096;
+        }
+
+        /**
+         * Maps anonymous memory for numBytes and returns the pointer to the (64 byte aligned) data
+         * The mapping is described by a header in front of the data
+         */
+        inline void*
+        mapMemory(size_t numBytes, HugePages hugePages)
+        {
+            const size_t pageSize = getPageSize();
+            const size_t neededSize = numBytes + mappingDataOffset;
+            char* start;
+            size_t size;
+            if(hugePages == HugePages::Explicit)
+            {
+                size = roundUp(neededSize, hugePageSize);
+                void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if(ptr == MAP_FAILED)
+                    throw std::runtime_error("Could not allocate " + std::to_string(size) + " bytes of huge pages: " + std::strerror(errno));
+                start = static_cast<char*>(ptr);
+            }else
+            {
+                // Transparent huge pages can only be used for 2MiB aligned ranges: Map more and cut off the slack
+                const bool useTHP = hugePages == HugePages::Transparent && neededSize >= hugePageSize;
+                const size_t alignment = useTHP ? hugePageSize : pageSize;
+                size = roundUp(neededSize, pageSize);
+                const size_t mapSize = size + alignment - pageSize;
+                void* ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(ptr == MAP_FAILED)
+                    throw std::bad_alloc();
+                char* mapStart = static_cast<char*>(ptr);
+                start = reinterpret_cast<char*>(roundUp(reinterpret_cast<std::uintptr_t>(mapStart), alignment));
+                if(start != mapStart)
+                    munmap(mapStart, start - mapStart);
+                if(mapStart + mapSize != start + size)
+                    munmap(start + size, mapStart + mapSize - (start + size));
+                if(useTHP)
+                    madvise(start, size, MADV_HUGEPAGE);
+            }
+            MappingHeader* header = reinterpret_cast<MappingHeader*>(start);
+            header->base = start;
+            header->size = size;
+            return start + mappingDataOffset;
+        }
+
+        inline const MappingHeader&
+        getMappingHeader(const void* data)
+        {
+            return *reinterpret_cast<const MappingHeader*>(static_cast<const char*>(data) - mappingDataOffset);
+        }
+
+        inline void
+        unmapMemory(void* data)
+        {
+            MappingHeader header = getMappingHeader(data);
+            munmap(header.base, header.size);
+        }
+
+        /**
+         * Reads an id list (see \ref parseIdList) from a sysfs file, returns an empty list if it cannot be read
+         */
+        inline std::vector<unsigned>
+        readIdList(const std::string& filePath)
+        {
+            std::ifstream file(filePath);
+            std::string list;
+            if(!(file >> list))
+                return std::vector<unsigned>();
+            return parseIdList(list);
+        }
+
+        /**
+         * Returns the ids of the online NUMA nodes, which need not be contiguous
+         */
+        inline std::vector<unsigned>
+        getOnlineNumaNodes()
+        {
+            std::vector<unsigned> nodes = readIdList("/sys/devices/system/node/online");
+            if(nodes.empty())
+                nodes.push_back(0);
+            return nodes;
+        }
+
+        /**
+         * Returns the number of NUMA node ids (highest online node + 1)
+         */
+        inline unsigned
+        getNumNumaNodes()
+        {
+            return getOnlineNumaNodes().back() + 1;
+        }
+
+        /**
+         * Restricts the calling thread to the CPUs of a NUMA node while it exists and restores the previous affinity
+         * Does nothing if the node has no CPUs the thread may run on or the affinity cannot be changed
+         */
+        class NodeAffinityGuard
+        {
+            cpu_set_t m_oldSet;
+            bool m_isSet = false;
+
+        public:
+            explicit NodeAffinityGuard(unsigned node)
+            {
+                if(sched_getaffinity(0, sizeof(m_oldSet), &m_oldSet) != 0)
+                    return;
+                cpu_set_t nodeSet;
+                CPU_ZERO(&nodeSet);
+                for(unsigned cpu: readIdList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))
+                {
+                    if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &m_oldSet))
+                        CPU_SET(cpu, &nodeSet);
+                }
+                m_isSet = CPU_COUNT(&nodeSet) > 0 && sched_setaffinity(0, sizeof(nodeSet), &nodeSet) == 0;
+            }
+
+            ~NodeAffinityGuard()
+            {
+                if(m_isSet)
+                    sched_setaffinity(0, sizeof(m_oldSet), &m_oldSet);
+            }
+
+            NodeAffinityGuard(const NodeAffinityGuard&) = delete;
+            NodeAffinityGuard& operator=(const NodeAffinityGuard&) = delete;
+        };
+
+        /**
+         * Sets the NUMA policy for the mapping containing data, must be called before the pages are touched
+         */
+        inline void
+        bindMemory(void* data, NumaPolicy policy, int node)
+        {
+            if(policy != NumaPolicy::Interleave && policy != NumaPolicy::Bind)
+                return;
+            const std::vector<unsigned> onlineNodes = getOnlineNumaNodes();
+            constexpr unsigned bitsPerMask = sizeof(unsigned long) * 8;
+            std::vector<unsigned long> nodeMask((onlineNodes.back() + bitsPerMask) / bitsPerMask, 0);
+            if(policy == NumaPolicy::Bind)
+            {
+                if(node < 0 || !std::binary_search(onlineNodes.begin(), onlineNodes.end(), static_cast<unsigned>(node)))
+                    throw std::runtime_error("Invalid NUMA node " + std::to_string(node));
+                nodeMask[node / bitsPerMask] |= 1ul << (node % bitsPerMask);
+            }else
+            {
+                // Offline nodes (holes in the node ids) must not be in the mask, mbind fails with EINVAL otherwise
+                for(unsigned i: onlineNodes)
+                    nodeMask[i / bitsPerMask] |= 1ul << (i % bitsPerMask);
+            }
+            const MappingHeader& header = getMappingHeader(data);
+            const int mode = policy == NumaPolicy::Bind ? MPOL_BIND : MPOL_INTERLEAVE;
+            // The kernel only reads maxnode - 1 bits of the mask
+            const unsigned long maxNode = nodeMask.size() * bitsPerMask + 1;
+            long res = syscall(SYS_mbind, header.base, header.size, mode, nodeMask.data(), maxNode, 0);
+            // ENOSYS: Kernel without NUMA support, there is nothing to place
+            if(res != 0 && errno != ENOSYS)
+                throw std::runtime_error(std::string("Setting the NUMA policy failed: ") + std::strerror(errno));
+        }
+
+#else
+
+        inline void*
+        mapMemory(size_t numBytes, HugePages /*hugePages*/)
+        {
+            return static_cast<char*>(::operator new(numBytes + mappingDataOffset)) + mappingDataOffset;
+        }
+
+        inline void
+        unmapMemory(void* data)
+        {
+            ::operator delete(static_cast<char*>(data) - mappingDataOffset);
+        }
+
+        inline std::vector<unsigned>
+        getOnlineNumaNodes()
+        {
+            return std::vector<unsigned>(1, 0);
+        }
+
+        inline unsigned
+        getNumNumaNodes()
+        {
+            return 1;
+        }
+
+        class NodeAffinityGuard
+        {
+        public:
+            explicit NodeAffinityGuard(unsigned /*node*/){}
+        };
+
+        inline void
+        bindMemory(void* /*data*/, NumaPolicy /*policy*/, int /*node*/){}
+
+#endif
+
+    }  // namespace detail
+
+    /**
+     * Allocator for large buffers that controls the NUMA placement and huge page backing of the memory
+     * Memory is mapped directly from the OS (Linux, elsewhere it falls back to the default heap)
+     * and is 64 byte aligned.
+     *
+     * \tparam T_numaPolicy Placement of the pages [ParallelFirstTouch]
+     * \tparam T_hugePages Usage of huge pages [Transparent]
+     * \tparam T_node Node to bind the memory to, only used for NumaPolicy::Bind
+     */
+    template<
+        NumaPolicy T_numaPolicy = NumaPolicy::ParallelFirstTouch,
+        HugePages T_hugePages = HugePages::Transparent,
+        int T_node = 0
+    >
+    struct NumaAllocator
+    {
+        static constexpr size_t alignment = detail::mappingDataOffset;
+        static constexpr NumaPolicy numaPolicy = T_numaPolicy;
+        static constexpr HugePages hugePages = T_hugePages;
+
+        template< typename T >
+        static T*
+        allocate(size_t numElements)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Values are not destroyed on free");
+            void* data = detail::mapMemory(numElements * sizeof(T), hugePages);
+            try{
+                detail::bindMemory(data, numaPolicy, T_node);
+            }catch(...){
+                detail::unmapMemory(data);
+                throw;
+            }
+            T* result = static_cast<T*>(data);
+            if(numaPolicy == NumaPolicy::FirstTouch)
+            {
+                for(size_t i = 0; i < numElements; ++i)
+                    ::new(static_cast<void*>(result + i)) T;
+            }else
+            {
+                // Touch every page from the thread that will later work on it (memory is zero anyway).
+                // The chunks are distributed over the nodes in order, each thread is pinned to its node while touching
+                // so the pages do not end up on whatever node the scheduler happens to run it on
+                const std::vector<unsigned> nodes = detail::getOnlineNumaNodes();
+                policies::parallelFor(numElements, 0, detail::minFirstTouchElementsPerThread, [result, numElements, &nodes](size_t begin, size_t end){
+                    std::unique_ptr<detail::NodeAffinityGuard> affinity;
+                    if(nodes.size() > 1)
+                        affinity.reset(new detail::NodeAffinityGuard(nodes[begin * nodes.size() / numElements]));
+                    std::memset(static_cast<void*>(result + begin), 0, (end - begin) * sizeof(T));
+                    for(size_t i = begin; i < end; ++i)
+                        ::new(static_cast<void*>(result + i)) T;
+                });
+            }
+            return result;
+        }
+
+        template< typename T >
+        static void
+        free(T* ptr)
+        {
+            if(ptr)
+                detail::unmapMemory(ptr);
+        }
+    };
+
+    /**
+     * Placement of a memory range
+     */
+    struct Placement
+    {
+        /** Number of pages on each NUMA node */
+        std::vector<size_t> pagesPerNode;
+        /** Number of pages that are not backed by physical memory (not touched yet) */
+        size_t numNotPresent = 0;
+        /** Number of pages whose placement cannot be queried (kernel without NUMA support) */
+        size_t numUnknown = 0;
+        /** Bytes backed by huge pages in the mappings containing the range */
+        size_t hugePageBytes = 0;
+    };
+
+    /**
+     * Queries where the pages of the given memory range currently reside
+     *
+     * @param ptr      Start of the range
+     * @param numBytes Size of the range in bytes
+     * @return Placement of the pages. On systems where this cannot be queried, all pages count as unknown
+     */
+    inline Placement
+    getPlacement(const void* ptr, size_t numBytes)
+    {
+        Placement result;
+        result.pagesPerNode.assign(detail::getNumNumaNodes(), 0);
+#ifdef __linux__
+        const size_t pageSize = detail::getPageSize();
+        const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(ptr) / pageSize * pageSize;
+        const std::uintptr_t end = detail::roundUp(reinterpret_cast<std::uintptr_t>(ptr) + numBytes, pageSize);
+        constexpr size_t batchSize = 4096;
+        std::vector<void*> pages;
+        std::vector<int> status(batchSize);
+        pages.reserve(batchSize);
+        for(std::uintptr_t batch = begin; batch < end; batch += batchSize * pageSize)
+        {
+            pages.clear();
+            for(std::uintptr_t page = batch; page < end && pages.size() < batchSize; page += pageSize)
+                pages.push_back(reinterpret_cast<void*>(page));
+            // move_pages without target nodes only reports the current node of each page
+            if(syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+            {
+                // ENOSYS: Kernel without NUMA support, neither the node nor the presence is known
+                if(errno != ENOSYS)
+                    throw std::runtime_error(std::string("Querying the page placement failed: ") + std::strerror(errno));
+                result.numUnknown += pages.size();
+                continue;
+            }
+            for(size_t i = 0; i < pages.size(); ++i)
+            {
+                if(status[i] < 0)
+                    ++result.numNotPresent;
+                else
+                {
+                    if(static_cast<size_t>(status[i]) >= result.pagesPerNode.size())
+                        result.pagesPerNode.resize(status[i] + 1, 0);
+                    ++result.pagesPerNode[status[i]];
+                }
+            }
+        }
+        // Huge pages are only reported per mapping in smaps
+        std::ifstream smaps("/proc/self/smaps");
+        std::string line;
+        bool inRange = false;
+        while(std::getline(smaps, line))
+        {
+            std::uintptr_t mapBegin, mapEnd;
+            char dash;
+            std::istringstream lineStream(line);
+            if(line.find(':') == std::string::npos || line.find('-') < line.find(':'))
+            {
+                if(lineStream >> std::hex >> mapBegin >> dash >> mapEnd && dash == '-')
+                    inRange = mapBegin < end && mapEnd > begin;
+                continue;
+            }
+            if(!inRange)
+                continue;
+            std::string key;
+            size_t kiloBytes;
+            if((lineStream >> key >> kiloBytes) &&
+                    (key == "AnonHugePages:" || key == "Private_Hugetlb:" || key == "Shared_Hugetlb:"))
+                result.hugePageBytes += kiloBytes * 1024;
+        }
+#else
+        result.numUnknown = (numBytes + 4095) / 4096;
+#endif
+        return result;
+    }
+
+}  // namespace mem
+}  // namespace LiFFT
@@ -90,7 +90,7 @@ namespace mem {
         operator()(T_Index&& idx)
         {
             assert(policies::checkSizes(idx, this->getExtents()));
-            unsigned flatIdx = policies::flattenIdx(idx, *this);
+            size_t flatIdx = policies::flattenIdx(idx, *this);
             return this->m_data[flatIdx];
         }
 
@@ -99,7 +99,7 @@ namespace mem {
         operator()(T_Index&& idx) const
         {
             assert(policies::checkSizes(idx, this->getExtents()));
-            unsigned flatIdx = policies::flattenIdx(idx, *this);
+            size_t flatIdx = policies::flattenIdx(idx, *this);
             return this->m_data[flatIdx];
         }
 
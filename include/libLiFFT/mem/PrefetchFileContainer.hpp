@@ -0,0 +1,406 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/mem/FileContainer.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LiFFT {
+    namespace mem {
+
+        /**
+         * A FileContainer for processing a sequence of files that opens and loads the next files on
+         * a background thread while the current one is processed
+         *
+         * Each prefetched file is loaded into its own buffer and copied to the current buffer on \ref setFilePath.
+         * The memory returned by getAllocatedMemory only changes if the extents change or the file path is cleared,
+         * so FFT wrappers and plans created for the container stay valid for a sequence of files with equal extents.
+         * Buffers are reused if the extents do not change, so there are at most prefetchDepth + 1 buffers.
+         *
+         * \tparam T_FileHandler File class. Must support open(string), isOpen(), close(), and a specialization for GetExtents.
+         *          A new instance is used for each file, so different files can be read concurrently
+         * \tparam T_FileAccessor Either an Array- or StreamAccessor that should provide an operator([index,] TFileHandler&) which
+         *          gets an element from the file
+         * \tparam T_Accuracy The internal datatype used (float or double) [float]
+         * \tparam T_isComplex Whether the values are complex [false]
+         * \tparam T_numDims number of dimensions [Number of dimensions supported by the FileHandler]
+         */
+        template<
+            typename T_FileHandler,
+            typename T_FileAccessor,
+            typename T_Accuracy = float,
+            bool T_isComplex = false,
+            unsigned T_numDims = traits::NumDims< T_FileHandler >::value
+        >
+        class PrefetchFileContainer
+        {
+        public:
+            using FileHandler = T_FileHandler;
+            using FileAccessor = T_FileAccessor;
+            using Accuracy = T_Accuracy;
+            static constexpr bool isComplex = T_isComplex;
+            static constexpr unsigned numDims = T_numDims;
+
+            using IdentityAccessor = FileContainerAccessor;
+            friend IdentityAccessor;
+        private:
+            using DataAccessor = accessors::DataContainerAccessor<>;
+            using CopyPolicy = policies::Copy< FileAccessor, DataAccessor >;
+            using ArrayType = std::conditional_t< isComplex, ComplexAoSValues<Accuracy>, RealValues<Accuracy> >;
+            using ElementType = typename ArrayType::Value;
+            using Ptr = ElementType*;
+
+            using Data = DataContainer< numDims, ArrayType >;
+            using ExtentsVec = decltype(std::declval<Data>().getExtents());
+
+            enum class State
+            {
+                Queued,
+                Loading,
+                Ready
+            };
+
+            /**
+             * A buffer with the (to be) loaded file
+             */
+            struct Slot
+            {
+                std::string filePath;
+                Data data;
+                State state = State::Queued;
+                std::exception_ptr error;
+            };
+            using SlotPtr = std::unique_ptr<Slot>;
+
+            Data m_data;
+            std::string m_filePath;
+            unsigned m_prefetchDepth;
+            std::vector<std::string> m_sequence;
+            /** Index of the next file of the sequence to prefetch */
+            size_t m_nextInSequence = 0;
+            /** Prefetched files in the order they are expected to be used */
+            std::deque<SlotPtr> m_queue;
+            /** Unused buffers kept for reuse */
+            std::vector<SlotPtr> m_freeSlots;
+            std::mutex m_mutex;
+            std::condition_variable m_cond;
+            bool m_stop = false;
+            std::thread m_worker;
+
+            PrefetchFileContainer(const PrefetchFileContainer&) = delete;
+            PrefetchFileContainer& operator=(const PrefetchFileContainer&) = delete;
+
+            /**
+             * Opens the file and copies its contents to data, reusing its memory if the extents match
+             */
+            static void
+            load(const std::string& filePath, Data& data)
+            {
+                FileHandler fileHandler;
+                fileHandler.open(filePath);
+                if(!fileHandler.isOpen())
+                    throw std::runtime_error("Could not open '" + filePath + "'");
+                policies::GetExtents< FileHandler > fileExtents(fileHandler);
+                typename Data::IdxType extents;
+                bool isSameSize = data.getData() != nullptr;
+                for(unsigned i=0; i<numDims; ++i)
+                {
+                    extents[i] = fileExtents[i];
+                    isSameSize &= data.getExtents()[i] == extents[i];
+                }
+                if(!isSameSize)
+                    data.allocData(extents);
+                CopyPolicy()(fileHandler, data);
+                fileHandler.close();
+            }
+
+            /**
+             * Copies the data to the current buffer if the extents match, returns false otherwise
+             */
+            bool
+            copyData(Data& data)
+            {
+                if(!m_data.getData())
+                    return false;
+                for(unsigned i=0; i<numDims; ++i)
+                {
+                    if(m_data.getExtents()[i] != data.getExtents()[i])
+                        return false;
+                }
+                std::memcpy(m_data.getData(), data.getData(), data.getMemSize());
+                return true;
+            }
+
+            void
+            run()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while(true)
+                {
+                    Slot* slot = nullptr;
+                    m_cond.wait(lock, [this, &slot]
+                    {
+                        auto it = std::find_if(m_queue.begin(), m_queue.end(), [](const SlotPtr& s){ return s->state == State::Queued; });
+                        slot = it != m_queue.end() ? it->get() : nullptr;
+                        return m_stop || slot;
+                    });
+                    if(m_stop)
+                        return;
+                    slot->state = State::Loading;
+                    lock.unlock();
+                    try
+                    {
+                        load(slot->filePath, slot->data);
+                    }catch(...)
+                    {
+                        slot->error = std::current_exception();
+                    }
+                    lock.lock();
+                    slot->state = State::Ready;
+                    m_cond.notify_all();
+                }
+            }
+
+            /**
+             * Adds a file to the prefetch queue, the mutex must be locked
+             */
+            void
+            enqueue(const std::string& filePath)
+            {
+                SlotPtr slot;
+                if(m_freeSlots.empty())
+                    slot.reset(new Slot);
+                else
+                {
+                    slot = std::move(m_freeSlots.back());
+                    m_freeSlots.pop_back();
+                }
+                slot->filePath = filePath;
+                slot->state = State::Queued;
+                slot->error = nullptr;
+                m_queue.push_back(std::move(slot));
+                m_cond.notify_all();
+            }
+
+            /**
+             * Removes the first file from the queue after it is no longer in use by the worker
+             */
+            SlotPtr
+            popFront(std::unique_lock<std::mutex>& lock)
+            {
+                m_cond.wait(lock, [this]{ return m_queue.front()->state != State::Loading; });
+                SlotPtr slot = std::move(m_queue.front());
+                m_queue.pop_front();
+                return slot;
+            }
+
+            /**
+             * Fills the queue with the files following the current one in the sequence, the mutex must be locked
+             */
+            void
+            prefetchSequence()
+            {
+                for(; m_nextInSequence < m_sequence.size() && m_queue.size() < m_prefetchDepth; ++m_nextInSequence)
+                {
+                    const std::string& filePath = m_sequence[m_nextInSequence];
+                    if(std::none_of(m_queue.begin(), m_queue.end(), [&filePath](const SlotPtr& s){ return s->filePath == filePath; }))
+                        enqueue(filePath);
+                }
+            }
+
+        public:
+            /**
+             * @param prefetchDepth Maximum number of files loaded in advance, 0 disables prefetching [1]
+             */
+            explicit PrefetchFileContainer(unsigned prefetchDepth = 1): m_prefetchDepth(prefetchDepth)
+            {
+                if(m_prefetchDepth)
+                    m_worker = std::thread(&PrefetchFileContainer::run, this);
+            }
+
+            /**
+             * Creates the container and starts prefetching the first files of the sequence
+             *
+             * @param sequence      Files in the order they will be passed to setFilePath
+             * @param prefetchDepth Maximum number of files loaded in advance, 0 disables prefetching [1]
+             */
+            explicit PrefetchFileContainer(const std::vector<std::string>& sequence, unsigned prefetchDepth = 1):
+                PrefetchFileContainer(prefetchDepth)
+            {
+                setSequence(sequence);
+            }
+
+            ~PrefetchFileContainer()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_cond.notify_all();
+                if(m_worker.joinable())
+                    m_worker.join();
+            }
+
+            /**
+             * Sets the files that will be processed in this order
+             * Whenever a file of the sequence is set, the following prefetchDepth files are loaded in the background
+             */
+            void
+            setSequence(const std::vector<std::string>& sequence)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_sequence = sequence;
+                auto it = std::find(m_sequence.begin(), m_sequence.end(), m_filePath);
+                m_nextInSequence = it == m_sequence.end() ? 0 : it - m_sequence.begin() + 1;
+                prefetchSequence();
+            }
+
+            /**
+             * Starts loading a file in the background that will be passed to setFilePath later
+             * Files are expected to be used in the order they were prefetched
+             *
+             * @return False if the prefetch queue is full
+             */
+            bool
+            prefetch(const std::string& filePath)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(m_queue.size() >= m_prefetchDepth)
+                    return false;
+                enqueue(filePath);
+                return true;
+            }
+
+            /**
+             * Sets the current file
+             * If it was prefetched, this waits till it is loaded and copies it, otherwise it is loaded now.
+             * Prefetched files before it are discarded.
+             * The current buffer is kept if the extents do not change, its contents are undefined after an error.
+             */
+            void
+            setFilePath(const std::string& filePath)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while(!m_queue.empty() && m_queue.front()->filePath != filePath)
+                    m_freeSlots.push_back(popFront(lock));
+                SlotPtr slot;
+                if(!m_queue.empty())
+                {
+                    m_cond.wait(lock, [this]{ return m_queue.front()->state == State::Ready; });
+                    slot = popFront(lock);
+                }
+                m_filePath = filePath;
+                if(!m_sequence.empty())
+                {
+                    auto it = std::find(m_sequence.begin(), m_sequence.end(), filePath);
+                    if(it != m_sequence.end())
+                        m_nextInSequence = std::max<size_t>(m_nextInSequence, it - m_sequence.begin() + 1);
+                }
+                const bool isPrefetched = slot != nullptr;
+                std::exception_ptr error;
+                if(isPrefetched)
+                {
+                    error = slot->error;
+                    if(!error && !copyData(slot->data))
+                        std::swap(m_data, slot->data);
+                    m_freeSlots.push_back(std::move(slot));
+                }
+                prefetchSequence();
+                lock.unlock();
+
+                if(error)
+                    std::rethrow_exception(error);
+                if(filePath.empty())
+                    m_data.freeData();
+                else if(!isPrefetched)
+                    load(filePath, m_data);
+            }
+
+            const std::string&
+            getFilePath() const
+            {
+                return m_filePath;
+            }
+
+            unsigned
+            getPrefetchDepth() const
+            {
+                return m_prefetchDepth;
+            }
+
+            const ExtentsVec&
+            getExtents() const
+            {
+                return m_data.getExtents();
+            }
+
+            Ptr
+            getAllocatedMemory()
+            {
+                return m_data.getData();
+            }
+
+            size_t
+            getMemSize() const
+            {
+                return m_data.getMemSize();
+            }
+
+            Data&
+            getData()
+            {
+                return m_data;
+            }
+
+            /**
+             * The data is loaded by setFilePath, this only reloads the current file if forceReload is set
+             */
+            void
+            loadData(bool forceReload = false)
+            {
+                if(forceReload && !m_filePath.empty())
+                    load(m_filePath, m_data);
+            }
+        };
+
+    }  // namespace mem
+
+    namespace traits {
+
+        template<
+            typename T_FileHandler,
+            typename T_FileReaderPolicy,
+            typename T_Accuracy,
+            bool T_isComplex,
+            unsigned T_numDims
+        >
+        struct IsStrided< mem::PrefetchFileContainer< T_FileHandler, T_FileReaderPolicy, T_Accuracy, T_isComplex, T_numDims > >
+        : std::integral_constant< bool, false>{};
+
+    }  // namespace traits
+
+}  // namespace LiFFT
@@ -22,11 +22,11 @@
 namespace LiFFT {
 namespace mem {
 
-    template< typename T, bool T_ownsPointer = true >
-    class RealValues: public detail::AoSValues< types::Real<T>, T_ownsPointer >
+    template< typename T, bool T_ownsPointer = true, class T_Allocator = DefaultAllocator >
+    class RealValues: public detail::AoSValues< types::Real<T>, T_ownsPointer, T_Allocator >
     {
     public:
-        using Parent = detail::AoSValues< types::Real<T>, T_ownsPointer >;
+        using Parent = detail::AoSValues< types::Real<T>, T_ownsPointer, T_Allocator >;
 
         using Parent::Parent;
     };
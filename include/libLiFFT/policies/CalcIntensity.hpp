@@ -57,11 +57,11 @@ namespace policies {
         {
             template< typename T_Data >
             auto
-            operator()(const T_Data& data, unsigned idx)
-            -> typename traits::IntegralType< std::result_of_t< T_Accessor(unsigned, const T_Data&) > >::type
+            operator()(const T_Data& data, size_t idx)
+            -> typename traits::IntegralType< std::result_of_t< T_Accessor(size_t, const T_Data&) > >::type
             {
                 T_Accessor accessor;
-                CalcIntensityImpl< std::result_of_t< T_Accessor(unsigned, const T_Data&) > > intensity;
+                CalcIntensityImpl< std::result_of_t< T_Accessor(size_t, const T_Data&) > > intensity;
                 return intensity(accessor(idx, data));
             }
         };
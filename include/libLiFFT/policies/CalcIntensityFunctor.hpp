@@ -17,6 +17,8 @@
 #pragma once
 
 #include "libLiFFT/traits/IsComplex.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/policies/IntensityKernels.hpp"
 
 namespace LiFFT {
 namespace policies {
@@ -46,6 +48,41 @@ namespace policies {
         {
             return val*val;
         }
+
+        /**
+         * Bulk version for contiguous real values: out[i] = in[i]^2
+         * Uses the vectorized kernels and optionally multiple threads (0 = all hardware threads)
+         */
+        template< typename T, typename = std::enable_if_t< !LiFFT::traits::IsComplex<T>::value > >
+        void
+        operator()(const T* in, T* out, size_t numEl, unsigned numThreads = 1) const
+        {
+            intensity::calculateReal(in, out, numEl, numThreads);
+        }
+
+        /**
+         * Bulk version for contiguous interleaved complex values: out[i] = |in[i]|^2
+         * Uses the vectorized kernels and optionally multiple threads (0 = all hardware threads)
+         */
+        template< typename T, typename = std::enable_if_t< LiFFT::traits::IsComplex<T>::value > >
+        void
+        operator()(const T* in, traits::IntegralType_t<T>* out, size_t numEl, unsigned numThreads = 1) const
+        {
+            using Precision = traits::IntegralType_t<T>;
+            static_assert(sizeof(T) == 2 * sizeof(Precision), "Complex type must consist of real and imaginary part only");
+            intensity::calculateAoS(reinterpret_cast<const Precision*>(in), out, numEl, numThreads);
+        }
+
+        /**
+         * Bulk version for complex values stored as separate real and imaginary arrays
+         * Uses the vectorized kernels and optionally multiple threads (0 = all hardware threads)
+         */
+        template< typename T >
+        void
+        operator()(const T* inReal, const T* inImag, T* out, size_t numEl, unsigned numThreads = 1) const
+        {
+            intensity::calculateSoA(inReal, inImag, out, numEl, numThreads);
+        }
     };
 
 }  // namespace policies
@@ -18,6 +18,7 @@
 
 #include "libLiFFT/traits/NumDims.hpp"
 #include "libLiFFT/traits/AccessorTraits.hpp"
+#include "libLiFFT/types/StaticExtents.hpp"
 #include "libLiFFT/policies/Loop.hpp"
 #include "libLiFFT/c++14_types.hpp"
 
@@ -25,60 +26,67 @@ namespace LiFFT {
 namespace policies {
     namespace detail {
 
+        /**
+         * Handler for the copy loop, keeps running offsets into src and dst for accessors that support flat offsets
+         */
+        template< class T_Src, class T_SrcAccessor, class T_Dst, class T_DstAccessor >
         struct CopyHandler
         {
+            RunningOffset< const T_Src, T_SrcAccessor > m_offsetSrc;
+            RunningOffset< T_Dst, T_DstAccessor > m_offsetDst;
+
+            CopyHandler(const T_Src& src, const T_Dst& dst): m_offsetSrc(src), m_offsetDst(dst){}
+
             template<
                 unsigned T_curDim,
                 class T_Index,
-                class T_Src,
-                class T_SrcAccessor,
-                class T_Dst,
-                class T_DstAccessor
+                class T_AccSrc,
+                class T_AccDst
                 >
             void
-            handleInnerLoop(const T_Index& idx, const T_Src& src, T_SrcAccessor&& accSrc, T_Dst& dst, T_DstAccessor&& accDst)
+            handleInnerLoop(const T_Index& idx, const T_Src& src, T_AccSrc&& accSrc, T_Dst& dst, T_AccDst&& accDst)
             {
                 if(idx[T_curDim] > 0){
                     accSrc.readDelimiter(src, T_curDim);
                     accDst.writeDelimiter(dst, T_curDim);
                 }
-                accDst.write(idx, dst, accSrc.read(idx, src));
+                m_offsetSrc.template update<T_curDim>(idx);
+                m_offsetDst.template update<T_curDim>(idx);
+                accDst.write(m_offsetDst.get(idx), dst, accSrc.read(m_offsetSrc.get(idx), src));
             }
 
             template<
                 unsigned T_curDim,
                 unsigned T_endDim,
                 class T_Index,
-                class T_Src,
-                class T_SrcAccessor,
-                class T_Dst,
-                class T_DstAccessor
+                class T_AccSrc,
+                class T_AccDst
                 >
             void
-            handleLoopPre(const T_Index& idx, const T_Src& src, T_SrcAccessor&& accSrc, T_Dst& dst, T_DstAccessor&& accDst)
+            handleLoopPre(const T_Index& idx, const T_Src& src, T_AccSrc&& accSrc, T_Dst& dst, T_AccDst&& accDst)
             {
                 if(idx[T_curDim] > 0){
                     accSrc.readDelimiter(src, T_curDim);
                     accDst.writeDelimiter(dst, T_curDim);
                 }
+                m_offsetSrc.template update<T_curDim>(idx);
+                m_offsetDst.template update<T_curDim>(idx);
             }
 
             template<
                 unsigned T_curDim,
                 unsigned T_endDim,
                 class T_Index,
-                class T_Src,
-                class T_SrcAccessor,
-                class T_Dst,
-                class T_DstAccessor
+                class T_AccSrc,
+                class T_AccDst
                 >
             void
             handleLoopPost(
                 T_Index const & /*idx*/,
                 T_Src const & /*src*/,
-                T_SrcAccessor && /*accSrc*/,
+                T_AccSrc && /*accSrc*/,
                 T_Dst const & /*dst*/,
-                T_DstAccessor && /*accDst*/ )
+                T_AccDst && /*accDst*/ )
             {}
         };
 
@@ -224,8 +232,18 @@ namespace policies {
         template<class dummy>
         struct ExtentsCheck<true, dummy>
         {
+            /**
+             * Extents known at compile time need no runtime check
+             */
             template< class T_Src, class T_Dst >
-            static void
+            static std::enable_if_t< traits::HasStaticExtents<T_Src>::value && traits::HasStaticExtents<T_Dst>::value >
+            check(const T_Src& /*src*/, const T_Dst& /*dst*/)
+            {
+                static_assert(std::is_same< typename T_Src::StaticExtents, typename T_Dst::StaticExtents >::value, "Extents mismatch");
+            }
+
+            template< class T_Src, class T_Dst >
+            static std::enable_if_t< !traits::HasStaticExtents<T_Src>::value || !traits::HasStaticExtents<T_Dst>::value >
             check(const T_Src& src, const T_Dst& dst)
             {
                 GetExtents<T_Src> extSrc(src);
@@ -261,7 +279,8 @@ namespace policies {
             static_assert(DelimiterDimOk<T_DstAccessor, numDimsDst, dstIsStream>::value,
                     "Destination accessor does not provide enough delimiters");
 
-            loop(src, detail::CopyHandler(), m_accSrc, dst, m_accDst);
+            detail::CopyHandler< PlainSrc, T_SrcAccessor, T_Dst, T_DstAccessor > handler(src, dst);
+            loop(src, handler, m_accSrc, dst, m_accDst);
         }
     };
 
@@ -34,7 +34,7 @@ namespace policies {
 
         GetExtentsImpl(const Data& data): m_data(data){}
 
-        unsigned operator[](unsigned dimIdx) const
+        size_t operator[](unsigned dimIdx) const
         {
             return m_data.extents[dimIdx];
         }
@@ -49,7 +49,7 @@ namespace policies {
         static constexpr unsigned numDims = traits::NumDims<Data>::value;
         GetExtentsImpl(const Data& data): m_data(data){}
 
-        unsigned operator[](unsigned dimIdx) const
+        size_t operator[](unsigned dimIdx) const
         {
             return m_data.getExtents()[dimIdx];
         }
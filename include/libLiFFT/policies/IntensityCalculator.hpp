@@ -17,120 +17,115 @@
 #pragma once
 
 #include "libLiFFT/traits/IsComplex.hpp"
+#include "libLiFFT/traits/IsAoS.hpp"
+#include "libLiFFT/traits/IsStrided.hpp"
 #include "libLiFFT/traits/NumDims.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/traits/IdentityAccessor.hpp"
 #include "libLiFFT/types/Vec.hpp"
 #include "libLiFFT/policies/SafePtrCast.hpp"
-#include "libLiFFT/testLib/IntensityLibrary.hpp"
-#include <boost/array.hpp>
+#include "libLiFFT/policies/GetNumElements.hpp"
+#include "libLiFFT/policies/IntensityKernels.hpp"
 
 namespace LiFFT {
 namespace policies {
 
-    template< class T_Input, class T_Accessor = typename T_Input::Accessor >
+    /**
+     * Calculates the intensity of a contiguous (non-strided) container in one pass
+     * by calling the vectorized kernels in \ref intensity
+     *
+     * \tparam T_Input Container type
+     * \tparam T_Accessor Accessor used to get a reference to the first element
+     */
+    template< class T_Input, class T_Accessor = traits::IdentityAccessor_t<T_Input> >
     class IntensityCalculator
     {
     public:
         using Input = T_Input;
-        using Output = typename traits::IntegralType<Input>::type*;
-        using Extents = GetExtents<Input>;
-        using ExtentsPtr = GetExtentsRawPtr<Input>;
         static constexpr bool isComplex = traits::IsComplex<Input>::value;
         static constexpr unsigned numDims = traits::NumDims<Input>::value;
         static_assert(numDims >= 1, "Need >= 1 dimension");
         static constexpr bool isAoS = traits::IsAoS<Input>::value;
+        static_assert(!traits::IsStrided<Input>::value, "Strided data is not supported");
 
     private:
-        template< unsigned T_numDims, bool T_isComplex, bool T_isAoS, class DUMMY = void >
+        using Idx = types::Vec< numDims, size_t >;
+
+    public:
+        using Precision = traits::IntegralType_t< std::result_of_t< T_Accessor(const Idx&, Input&) > >;
+        using Output = Precision*;
+
+    private:
+
+        template< bool T_isComplex, bool T_isAoS, class DUMMY = void >
         struct ExecutionPolicy;
 
-        // Real 1D
-        template< bool T_isAoS >
-        struct ExecutionPolicy< 1, false, T_isAoS >
+        // Real
+        template< bool T_isAoS, class DUMMY >
+        struct ExecutionPolicy< false, T_isAoS, DUMMY >
         {
             T_Accessor m_acc;
-            void operator()(Input& input, Output output){
-                LibFoo::calculateR1D(
-                        safe_ptr_cast<Output>(&m_acc(LiFFT::types::Vec<1>::all(0), input)),
-                        output,
-                        Extents(input)[0]);
-            }
-        };
+            unsigned m_numThreads = 1;
 
-        // Real ND
-        template< unsigned T_numDims, bool T_isAoS >
-        struct ExecutionPolicy< T_numDims, false, T_isAoS >
-        {
-            T_Accessor m_acc;
             void operator()(Input& input, Output output){
-                ExtentsPtr extents(input);
-                LibFoo::calculateRND(safe_ptr_cast<Output>(&m_acc(LiFFT::types::Vec<T_numDims>::all(0), input)),
-                        output, T_numDims, extents());
+                intensity::calculateReal(
+                        safe_ptr_cast<Output>(&m_acc(Idx::all(0), input)),
+                        output,
+                        getNumElements(input),
+                        m_numThreads);
             }
         };
 
-        // Complex 1D
+        // Complex(AoS)
         template< class DUMMY >
-        struct ExecutionPolicy< 1, true, true, DUMMY >
+        struct ExecutionPolicy< true, true, DUMMY >
         {
             T_Accessor m_acc;
-            void operator()(Input& input, Output output){
-                LibFoo::calculateC1D(
-                        safe_ptr_cast<Output>(&m_acc(LiFFT::types::Vec<1>::all(0), input)),
-                        output,
-                        Extents(input)[0]);
-            }
-        };
+            unsigned m_numThreads = 1;
 
-        // Complex ND
-        template< unsigned T_numDims, class DUMMY >
-        struct ExecutionPolicy< T_numDims, true, true, DUMMY >
-        {
-            T_Accessor m_acc;
             void operator()(Input& input, Output output){
-                ExtentsPtr extents(input);
-                LibFoo::calculateCND(safe_ptr_cast<Output>(&m_acc(LiFFT::types::Vec<T_numDims>::all(0), input)),
-                        output, T_numDims, extents());
+                intensity::calculateAoS(
+                        safe_ptr_cast<Output>(&m_acc(Idx::all(0), input).real),
+                        output,
+                        getNumElements(input),
+                        m_numThreads);
             }
         };
 
-        // Complex(SoA) 1D
+        // Complex(SoA)
         template< class DUMMY >
-        struct ExecutionPolicy< 1, true, false, DUMMY >
+        struct ExecutionPolicy< true, false, DUMMY >
         {
             T_Accessor m_acc;
-            void operator()(Input& input, Output output){
-                auto ptr = m_acc(LiFFT::types::Vec<1>::all(0), input);
-                LibFoo::calculateC1D(safe_ptr_cast<Output>(&ptr.real),
-                        safe_ptr_cast<Output>(&ptr.imag),
-                        output,
-                        Extents(input)[0]);
-            }
-        };
+            unsigned m_numThreads = 1;
 
-        // Complex(SoA) ND
-        template< unsigned T_numDims, class DUMMY >
-        struct ExecutionPolicy< T_numDims, true, false, DUMMY >
-        {
-            T_Accessor m_acc;
             void operator()(Input& input, Output output){
-                ExtentsPtr extents(input);
-                auto ptr = m_acc(LiFFT::types::Vec<T_numDims>::all(0), input);
-                LibFoo::calculateCND(safe_ptr_cast<Output>(&ptr.real),
-                        safe_ptr_cast<Output>(&ptr.imag),
+                auto ref = m_acc(Idx::all(0), input);
+                intensity::calculateSoA(
+                        safe_ptr_cast<Output>(&ref.real),
+                        safe_ptr_cast<Output>(&ref.imag),
                         output,
-                        T_numDims,
-                        extents());
+                        getNumElements(input),
+                        m_numThreads);
             }
         };
 
     public:
-        using type = ExecutionPolicy< numDims, isComplex, isAoS >;
+        using type = ExecutionPolicy< isComplex, isAoS >;
     };
 
+    /**
+     * Calculates the intensity (|x|^2) of all elements in input and stores them contiguously in output
+     *
+     * @param input      Contiguous container (real, complex AoS or complex SoA)
+     * @param output     Pointer to at least getNumElements(input) values
+     * @param numThreads Number of threads to use, 0 for all hardware threads [1]
+     */
     template< class T_Input, class Output >
     void
-    useIntensityCalculator(T_Input& input, Output output){
+    useIntensityCalculator(T_Input& input, Output output, unsigned numThreads = 1){
         typename IntensityCalculator<T_Input>::type calculator;
+        calculator.m_numThreads = numThreads;
         calculator(input, output);
     }
 
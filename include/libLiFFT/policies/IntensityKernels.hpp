@@ -0,0 +1,431 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/CpuFeatures.hpp"
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace LiFFT {
+namespace policies {
+namespace intensity {
+
+    /**
+     * Minimum number of elements a thread should work on, below that threading overhead dominates
+     */
+    constexpr size_t minElementsPerThread = 1 << 16;
+
+    namespace detail {
+
+        /**
+         * Scalar kernels used for non-float/double types and for the tails of the vectorized ones
+         */
+        template< typename T >
+        struct ScalarKernel
+        {
+            static void
+            real(const T* in, T* out, size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    out[i] = in[i] * in[i];
+            }
+
+            static void
+            aos(const T* in, T* out, size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    out[i] = in[2*i] * in[2*i] + in[2*i+1] * in[2*i+1];
+            }
+
+            static void
+            soa(const T* inReal, const T* inImag, T* out, size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    out[i] = inReal[i] * inReal[i] + inImag[i] * inImag[i];
+            }
+        };
+
+#if defined(LiFFT_X86_DISPATCH)
+
+        /**
+         * AVX-512 and AVX2 kernels for float and double, only called if the CPU supports them
+         * All kernels calculate out[i] = |in[i]|^2 for i in [begin, end)
+         */
+        template< typename T >
+        struct Avx512Kernel;
+
+        template< typename T >
+        struct Avx2Kernel;
+
+        template<>
+        struct Avx512Kernel<float>
+        {
+            LiFFT_TARGET("avx512f")
+            static void
+            real(const float* in, float* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 16 <= end; i += 16)
+                {
+                    __m512 v = _mm512_loadu_ps(in + i);
+                    _mm512_storeu_ps(out + i, _mm512_mul_ps(v, v));
+                }
+                ScalarKernel<float>::real(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx512f")
+            static void
+            aos(const float* in, float* out, size_t begin, size_t end)
+            {
+                const __m512i idxReal = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+                const __m512i idxImag = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+                size_t i = begin;
+                for(; i + 16 <= end; i += 16)
+                {
+                    __m512 lo = _mm512_loadu_ps(in + 2*i);
+                    __m512 hi = _mm512_loadu_ps(in + 2*i + 16);
+                    __m512 re = _mm512_permutex2var_ps(lo, idxReal, hi);
+                    __m512 im = _mm512_permutex2var_ps(lo, idxImag, hi);
+                    _mm512_storeu_ps(out + i, _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im)));
+                }
+                ScalarKernel<float>::aos(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx512f")
+            static void
+            soa(const float* inReal, const float* inImag, float* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 16 <= end; i += 16)
+                {
+                    __m512 re = _mm512_loadu_ps(inReal + i);
+                    __m512 im = _mm512_loadu_ps(inImag + i);
+                    _mm512_storeu_ps(out + i, _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im)));
+                }
+                ScalarKernel<float>::soa(inReal, inImag, out, i, end);
+            }
+        };
+
+        template<>
+        struct Avx512Kernel<double>
+        {
+            LiFFT_TARGET("avx512f")
+            static void
+            real(const double* in, double* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m512d v = _mm512_loadu_pd(in + i);
+                    _mm512_storeu_pd(out + i, _mm512_mul_pd(v, v));
+                }
+                ScalarKernel<double>::real(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx512f")
+            static void
+            aos(const double* in, double* out, size_t begin, size_t end)
+            {
+                const __m512i idxReal = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+                const __m512i idxImag = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m512d lo = _mm512_loadu_pd(in + 2*i);
+                    __m512d hi = _mm512_loadu_pd(in + 2*i + 8);
+                    __m512d re = _mm512_permutex2var_pd(lo, idxReal, hi);
+                    __m512d im = _mm512_permutex2var_pd(lo, idxImag, hi);
+                    _mm512_storeu_pd(out + i, _mm512_fmadd_pd(re, re, _mm512_mul_pd(im, im)));
+                }
+                ScalarKernel<double>::aos(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx512f")
+            static void
+            soa(const double* inReal, const double* inImag, double* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m512d re = _mm512_loadu_pd(inReal + i);
+                    __m512d im = _mm512_loadu_pd(inImag + i);
+                    _mm512_storeu_pd(out + i, _mm512_fmadd_pd(re, re, _mm512_mul_pd(im, im)));
+                }
+                ScalarKernel<double>::soa(inReal, inImag, out, i, end);
+            }
+        };
+
+
+        template<>
+        struct Avx2Kernel<float>
+        {
+            LiFFT_TARGET("avx2")
+            static void
+            real(const float* in, float* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m256 v = _mm256_loadu_ps(in + i);
+                    _mm256_storeu_ps(out + i, _mm256_mul_ps(v, v));
+                }
+                ScalarKernel<float>::real(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx2")
+            static void
+            aos(const float* in, float* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m256 lo = _mm256_loadu_ps(in + 2*i);
+                    __m256 hi = _mm256_loadu_ps(in + 2*i + 8);
+                    lo = _mm256_mul_ps(lo, lo);
+                    hi = _mm256_mul_ps(hi, hi);
+                    // hadd works per 128 bit lane: (lo0, lo1, hi0, hi1) -> reorder lanes to (lo0, hi0, lo1, hi1)
+                    __m256 sum = _mm256_hadd_ps(lo, hi);
+                    sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), 0xD8));
+                    _mm256_storeu_ps(out + i, sum);
+                }
+                ScalarKernel<float>::aos(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx2")
+            static void
+            soa(const float* inReal, const float* inImag, float* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 8 <= end; i += 8)
+                {
+                    __m256 re = _mm256_loadu_ps(inReal + i);
+                    __m256 im = _mm256_loadu_ps(inImag + i);
+                    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)));
+                }
+                ScalarKernel<float>::soa(inReal, inImag, out, i, end);
+            }
+        };
+
+        template<>
+        struct Avx2Kernel<double>
+        {
+            LiFFT_TARGET("avx2")
+            static void
+            real(const double* in, double* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 4 <= end; i += 4)
+                {
+                    __m256d v = _mm256_loadu_pd(in + i);
+                    _mm256_storeu_pd(out + i, _mm256_mul_pd(v, v));
+                }
+                ScalarKernel<double>::real(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx2")
+            static void
+            aos(const double* in, double* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 4 <= end; i += 4)
+                {
+                    __m256d lo = _mm256_loadu_pd(in + 2*i);
+                    __m256d hi = _mm256_loadu_pd(in + 2*i + 4);
+                    lo = _mm256_mul_pd(lo, lo);
+                    hi = _mm256_mul_pd(hi, hi);
+                    // hadd yields (lo0, hi0, lo1, hi1) -> reorder to (lo0, lo1, hi0, hi1)
+                    __m256d sum = _mm256_hadd_pd(lo, hi);
+                    _mm256_storeu_pd(out + i, _mm256_permute4x64_pd(sum, 0xD8));
+                }
+                ScalarKernel<double>::aos(in, out, i, end);
+            }
+
+            LiFFT_TARGET("avx2")
+            static void
+            soa(const double* inReal, const double* inImag, double* out, size_t begin, size_t end)
+            {
+                size_t i = begin;
+                for(; i + 4 <= end; i += 4)
+                {
+                    __m256d re = _mm256_loadu_pd(inReal + i);
+                    __m256d im = _mm256_loadu_pd(inImag + i);
+                    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(re, re), _mm256_mul_pd(im, im)));
+                }
+                ScalarKernel<double>::soa(inReal, inImag, out, i, end);
+            }
+        };
+
+
+        /**
+         * Calls the widest kernels supported by the CPU
+         */
+        template< typename T >
+        struct DispatchKernel
+        {
+            static void
+            real(const T* in, T* out, size_t begin, size_t end)
+            {
+                const CpuFeatures& cpu = getCpuFeatures();
+                if(cpu.avx512f)
+                    Avx512Kernel<T>::real(in, out, begin, end);
+                else if(cpu.avx2)
+                    Avx2Kernel<T>::real(in, out, begin, end);
+                else
+                    ScalarKernel<T>::real(in, out, begin, end);
+            }
+
+            static void
+            aos(const T* in, T* out, size_t begin, size_t end)
+            {
+                const CpuFeatures& cpu = getCpuFeatures();
+                if(cpu.avx512f)
+                    Avx512Kernel<T>::aos(in, out, begin, end);
+                else if(cpu.avx2)
+                    Avx2Kernel<T>::aos(in, out, begin, end);
+                else
+                    ScalarKernel<T>::aos(in, out, begin, end);
+            }
+
+            static void
+            soa(const T* inReal, const T* inImag, T* out, size_t begin, size_t end)
+            {
+                const CpuFeatures& cpu = getCpuFeatures();
+                if(cpu.avx512f)
+                    Avx512Kernel<T>::soa(inReal, inImag, out, begin, end);
+                else if(cpu.avx2)
+                    Avx2Kernel<T>::soa(inReal, inImag, out, begin, end);
+                else
+                    ScalarKernel<T>::soa(inReal, inImag, out, begin, end);
+            }
+        };
+
+#endif
+
+        /**
+         * Kernels used by the intensity functions, the generic version falls back to the scalar implementation
+         */
+        template< typename T >
+        struct Kernel: ScalarKernel<T>{};
+
+#if defined(LiFFT_X86_DISPATCH)
+
+        template<>
+        struct Kernel<float>: DispatchKernel<float>{};
+
+        template<>
+        struct Kernel<double>: DispatchKernel<double>{};
+
+#endif
+
+        /**
+         * Returns the number of threads that can be used when the output may overlap an input
+         * An output starting at the same position as the input is fine for element wise kernels (isElementWise).
+         * Other overlaps with the output starting before the input only work when the elements are processed in order
+         * by a single thread. If the output starts behind the start of an overlapping input, values would be overwritten
+         * before they are read, which is rejected
+         *
+         * @param in            Start of the input
+         * @param inBytes       Size of the input in bytes
+         * @param out           Start of the output
+         * @param outBytes      Size of the output in bytes
+         * @param isElementWise Whether out[i] only depends on in[i]
+         * @param numThreads    Requested number of threads
+         */
+        inline unsigned
+        getSafeNumThreads(const void* in, size_t inBytes, const void* out, size_t outBytes, bool isElementWise, unsigned numThreads)
+        {
+            // Compare addresses as integers, relational operators on pointers to different arrays are unspecified
+            const std::uintptr_t inBegin = reinterpret_cast<std::uintptr_t>(in);
+            const std::uintptr_t outBegin = reinterpret_cast<std::uintptr_t>(out);
+            if(outBegin >= inBegin + inBytes || inBegin >= outBegin + outBytes)
+                return numThreads;
+            if(outBegin == inBegin && isElementWise)
+                return numThreads;
+            if(outBegin > inBegin)
+                throw std::invalid_argument("The intensity output must not start behind the start of an overlapping input");
+            return 1;
+        }
+
+    }  // namespace detail
+
+    /**
+     * Calculates the intensity (square) of contiguous real values
+     *
+     * @param in         Input values
+     * @param out        Output values. May be the same as in, other overlaps with in are only supported if out starts
+     *                   before in (processed by a single thread then), std::invalid_argument is thrown otherwise
+     * @param numEl      Number of elements
+     * @param numThreads Number of threads to use, 0 for all hardware threads [1]
+     */
+    template< typename T >
+    void
+    calculateReal(const T* in, T* out, size_t numEl, unsigned numThreads = 1)
+    {
+        numThreads = detail::getSafeNumThreads(in, numEl * sizeof(T), out, numEl * sizeof(T), true, numThreads);
+        parallelFor(numEl, numThreads, minElementsPerThread, [in, out](size_t begin, size_t end){
+            detail::Kernel<T>::real(in, out, begin, end);
+        });
+    }
+
+    /**
+     * Calculates the intensity (real^2 + imag^2) of contiguous interleaved complex values
+     *
+     * @param in         Input values (real and imaginary part interleaved, 2*numEl values)
+     * @param out        Output values (numEl values). May overlap in if it does not start behind in (e.g. in-place),
+     *                   std::invalid_argument is thrown otherwise. Overlapping ranges are processed by a single thread
+     * @param numEl      Number of complex elements
+     * @param numThreads Number of threads to use, 0 for all hardware threads [1]
+     */
+    template< typename T >
+    void
+    calculateAoS(const T* in, T* out, size_t numEl, unsigned numThreads = 1)
+    {
+        // Writing out[i] while another thread still reads in[2*i] is only safe if the buffers do not overlap
+        numThreads = detail::getSafeNumThreads(in, 2 * numEl * sizeof(T), out, numEl * sizeof(T), false, numThreads);
+        parallelFor(numEl, numThreads, minElementsPerThread, [in, out](size_t begin, size_t end){
+            detail::Kernel<T>::aos(in, out, begin, end);
+        });
+    }
+
+    /**
+     * Calculates the intensity (real^2 + imag^2) of contiguous complex values stored as separate arrays
+     *
+     * @param inReal     Real parts
+     * @param inImag     Imaginary parts
+     * @param out        Output values. May be the same as inReal or inImag, for other overlaps the same restrictions
+     *                   as for \ref calculateReal apply
+     * @param numEl      Number of elements
+     * @param numThreads Number of threads to use, 0 for all hardware threads [1]
+     */
+    template< typename T >
+    void
+    calculateSoA(const T* inReal, const T* inImag, T* out, size_t numEl, unsigned numThreads = 1)
+    {
+        const size_t numBytes = numEl * sizeof(T);
+        numThreads = detail::getSafeNumThreads(inReal, numBytes, out, numBytes, true, numThreads);
+        numThreads = detail::getSafeNumThreads(inImag, numBytes, out, numBytes, true, numThreads);
+        parallelFor(numEl, numThreads, minElementsPerThread, [inReal, inImag, out](size_t begin, size_t end){
+            detail::Kernel<T>::soa(inReal, inImag, out, begin, end);
+        });
+    }
+
+}  // namespace intensity
+}  // namespace policies
+}  // namespace LiFFT
@@ -17,7 +17,9 @@
 #pragma once
 
 #include "libLiFFT/traits/NumDims.hpp"
+#include "libLiFFT/traits/AccessorTraits.hpp"
 #include "libLiFFT/policies/GetExtents.hpp"
+#include "libLiFFT/policies/GetStrides.hpp"
 #include "libLiFFT/types/Vec.hpp"
 #include "libLiFFT/c++14_types.hpp"
 
@@ -77,6 +79,70 @@ namespace policies {
 
     }  // namespace detail
 
+    /**
+     * Keeps the flat offset (sum of idx[i]*strides[i]) of the current loop index into one operand
+     * A handler calls update<curDim>(idx) in every iteration of each dimension (outer to inner), so the offset
+     * is advanced by one add instead of flattening the full index on every access.
+     * get(idx) returns the offset if the accessor supports it (traits::IsFlatOffsetAccessor), otherwise the index itself
+     *
+     * \tparam T_Data     Type of the operand
+     * \tparam T_Accessor Accessor used for the operand
+     */
+    template<
+        class T_Data,
+        class T_Accessor,
+        bool T_isEnabled = traits::IsFlatOffsetAccessor< std::decay_t<T_Accessor>, std::remove_const_t<T_Data> >::value
+    >
+    struct RunningOffset
+    {
+        RunningOffset(const T_Data& /*data*/){}
+
+        template< unsigned T_curDim, class T_Index >
+        void
+        update(const T_Index& /*idx*/){}
+
+        template< class T_Index >
+        const T_Index&
+        get(const T_Index& idx) const
+        {
+            return idx;
+        }
+    };
+
+    template< class T_Data, class T_Accessor >
+    struct RunningOffset< T_Data, T_Accessor, true >
+    {
+        static constexpr unsigned numDims = traits::NumDims< std::remove_const_t<T_Data> >::value;
+
+        RunningOffset(const T_Data& data): m_offsets(types::Vec< numDims + 1, size_t >::all(0))
+        {
+            GetStrides< std::remove_const_t<T_Data> > strides(data);
+            for(unsigned i=0; i<numDims; ++i)
+                m_strides[i] = strides[i];
+        }
+
+        template< unsigned T_curDim, class T_Index >
+        void
+        update(const T_Index& idx)
+        {
+            // m_offsets[d+1] is the offset of idx[0..d], m_offsets[0] is always 0
+            if(idx[T_curDim] == 0)
+                m_offsets[T_curDim + 1] = m_offsets[T_curDim];
+            else
+                m_offsets[T_curDim + 1] += m_strides[T_curDim];
+        }
+
+        template< class T_Index >
+        size_t
+        get(const T_Index& /*idx*/) const
+        {
+            return m_offsets[numDims];
+        }
+    private:
+        types::Vec< numDims, size_t > m_strides;
+        types::Vec< numDims + 1, size_t > m_offsets;
+    };
+
     /**
      * Defines a loop over all dimensions of src
      * Expects a handler that is then called for each iteration. Specifically:
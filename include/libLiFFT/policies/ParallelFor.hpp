@@ -0,0 +1,78 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace LiFFT {
+namespace policies {
+
+    /**
+     * Returns the number of threads to use when the user requested numThreads (0 = all hardware threads)
+     */
+    inline unsigned
+    getNumThreads(unsigned numThreads)
+    {
+        if(numThreads)
+            return numThreads;
+        unsigned hwThreads = std::thread::hardware_concurrency();
+        return hwThreads ? hwThreads : 1;
+    }
+
+    /**
+     * Splits the range [0, numEl) into contiguous chunks and calls func(begin, end) for each chunk
+     * Chunks are processed concurrently by up to numThreads threads (the calling thread is one of them).
+     * Chunk boundaries are multiples of T_granularity so vectorized kernels only get a scalar tail in the last chunk
+     *
+     * \tparam T_granularity Chunk sizes (except the last one) are a multiple of this
+     * @param numEl      Number of elements
+     * @param numThreads Maximum number of threads to use, 0 for all hardware threads
+     * @param minChunk   Minimum number of elements per thread, below that fewer threads are used
+     * @param func       Functor called as func(size_t begin, size_t end)
+     */
+    template< size_t T_granularity = 64, class T_Func >
+    void
+    parallelFor(size_t numEl, unsigned numThreads, size_t minChunk, T_Func&& func)
+    {
+        if(!numEl)
+            return;
+        size_t maxThreads = std::max<size_t>(numEl / std::max<size_t>(minChunk, 1), 1);
+        size_t usedThreads = std::min<size_t>(getNumThreads(numThreads), maxThreads);
+        if(usedThreads <= 1)
+        {
+            func(size_t(0), numEl);
+            return;
+        }
+        size_t chunk = (numEl + usedThreads - 1) / usedThreads;
+        chunk = (chunk + T_granularity - 1) / T_granularity * T_granularity;
+        std::vector<std::thread> threads;
+        threads.reserve(usedThreads - 1);
+        size_t begin = chunk;
+        for(; begin < numEl; begin += chunk)
+        {
+            size_t end = std::min(begin + chunk, numEl);
+            threads.emplace_back([&func, begin, end](){ func(begin, end); });
+        }
+        func(size_t(0), std::min(chunk, numEl));
+        for(std::thread& t: threads)
+            t.join();
+    }
+
+}  // namespace policies
+}  // namespace LiFFT
@@ -20,16 +20,50 @@
 #include "libLiFFT/policies/GetStrides.hpp"
 #include "libLiFFT/traits/NumDims.hpp"
 #include "libLiFFT/traits/IsStrided.hpp"
+#include "libLiFFT/types/StaticExtents.hpp"
 #include "libLiFFT/c++14_types.hpp"
 #include <cassert>
 
 namespace LiFFT {
 namespace policies {
 
+    namespace detail {
+
+        /**
+         * Unrolled flattening of an index for extents known at compile time
+         */
+        template< class T_Extents, unsigned T_dim = T_Extents::numDims - 1 >
+        struct StaticFlattenIdx
+        {
+            template< class T_Index >
+            static size_t
+            get(const T_Index& idx)
+            {
+                return StaticFlattenIdx< T_Extents, T_dim - 1 >::get(idx) + idx[T_dim] * T_Extents::getStride(T_dim);
+            }
+        };
+
+        template< class T_Extents >
+        struct StaticFlattenIdx< T_Extents, 0 >
+        {
+            template< class T_Index >
+            static size_t
+            get(const T_Index& idx)
+            {
+                return idx[0] * T_Extents::getStride(0);
+            }
+        };
+
+    }  // namespace detail
+
     /**
      * Makes an index "flat", that is: vector indices are converted to an unsigned
      */
-    template< class T_Data, bool T_IsStrided = traits::IsStrided<T_Data>::value >
+    template<
+        class T_Data,
+        bool T_IsStrided = traits::IsStrided<T_Data>::value,
+        bool T_hasStaticExtents = traits::HasStaticExtents<T_Data>::value
+    >
     struct FlattenIdx
     {
         template< class T_Index >
@@ -53,18 +87,18 @@ namespace policies {
         }
     };
 
-    template< class T_Data >
-    struct FlattenIdx< T_Data, true>
+    template< class T_Data, bool T_hasStaticExtents >
+    struct FlattenIdx< T_Data, true, T_hasStaticExtents >
     {
         template< class T_Index >
-        std::enable_if_t< std::is_integral<T_Index>::value, size_t >
+        std::enable_if_t< std::is_integral<std::remove_reference_t<T_Index>>::value, size_t >
         operator()(T_Index&& idx, const T_Data& /*data*/) const
         {
             return idx;
         }
 
         template< class T_Index >
-        std::enable_if_t< !std::is_integral<T_Index>::value, size_t >
+        std::enable_if_t< !std::is_integral<std::remove_reference_t<T_Index>>::value, size_t >
         operator()(T_Index&& idx, const T_Data& data) const
         {
             static constexpr unsigned numDims = traits::NumDims<T_Data>::value;
@@ -80,6 +114,29 @@ namespace policies {
         }
     };
 
+    /**
+     * Specialization for unstrided data with extents known at compile time: Strides are constants
+     */
+    template< class T_Data >
+    struct FlattenIdx< T_Data, false, true >
+    {
+        template< class T_Index >
+        std::enable_if_t< std::is_integral<std::remove_reference_t<T_Index>>::value, size_t >
+        operator()(T_Index&& idx, const T_Data& /*data*/) const
+        {
+            return idx;
+        }
+
+        template< class T_Index >
+        std::enable_if_t< !std::is_integral<std::remove_reference_t<T_Index>>::value, size_t >
+        operator()(T_Index&& idx, const T_Data& /*data*/) const
+        {
+            using Extents = typename T_Data::StaticExtents;
+            assert(checkSizes(idx, Extents()));
+            return detail::StaticFlattenIdx< Extents >::get(idx);
+        }
+    };
+
     template< class T_Index, class T_Data >
     size_t
     flattenIdx(T_Index&& idx, const T_Data& data)
@@ -75,6 +75,14 @@ namespace traits {
                 "Only Accessors should be checked with this trait");
     };
 
+    /**
+     * Evaluates to true type if the accessor can be called with a precomputed flat offset (sum of idx[i]*strides[i])
+     * instead of a multidimensional index for the given data. Loops then keep running offsets
+     * (see policies::RunningOffset) instead of flattening the index on each access
+     */
+    template< class T_Accessor, typename T_Data >
+    struct IsFlatOffsetAccessor: std::false_type{};
+
     template<
         class T_Accessor,
         typename T_Data,
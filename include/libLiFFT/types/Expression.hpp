@@ -0,0 +1,754 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/types/Vec.hpp"
+#include "libLiFFT/types/Complex.hpp"
+#include "libLiFFT/traits/NumDims.hpp"
+#include "libLiFFT/traits/IsComplex.hpp"
+#include "libLiFFT/traits/IsStrided.hpp"
+#include "libLiFFT/traits/IntegralType.hpp"
+#include "libLiFFT/traits/IdentityAccessor.hpp"
+#include "libLiFFT/policies/GetExtents.hpp"
+#include "libLiFFT/policies/GetNumElements.hpp"
+#include "libLiFFT/policies/Copy.hpp"
+#include "libLiFFT/policies/ParallelFor.hpp"
+#include "libLiFFT/void_t.hpp"
+#include "libLiFFT/c++14_types.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace LiFFT {
+namespace types {
+
+    /**
+     * Lazy expressions over containers
+     *
+     * Expressions are built from containers (see \ref makeExpr) and combined with arithmetic operators
+     * and the functions conj, abs2, scale, shift and fftShift. Nothing is evaluated until the expression
+     * is assigned to a destination with \ref assign which runs the whole chain in a single (parallel) pass.
+     * If all containers involved are contiguous and accessed with their default accessors the pass runs over
+     * a flat index which the compiler can vectorize.
+     *
+     * Expressions are containers themselves (read-only) and can e.g. be used as FFT inputs.
+     */
+
+    namespace detail {
+
+        /**
+         * Converts a value as returned by an accessor to the value type used in expressions:
+         * Complex<Precision> for complex values, Precision for real values
+         */
+        struct ToExprValue
+        {
+            template< typename T, typename = std::enable_if_t< traits::IsComplex< std::decay_t<T> >::value > >
+            Complex< traits::IntegralType_t<T> >
+            operator()(const T& val) const
+            {
+                using Precision = traits::IntegralType_t<T>;
+                return Complex<Precision>(static_cast<Precision>(val.real), static_cast<Precision>(val.imag));
+            }
+
+            template< typename T, typename = std::enable_if_t< !traits::IsComplex< std::decay_t<T> >::value >, typename = void >
+            traits::IntegralType_t<T>
+            operator()(const T& val) const
+            {
+                return static_cast< traits::IntegralType_t<T> >(val);
+            }
+        };
+
+        template< typename T >
+        using ExprValue_t = std::result_of_t< ToExprValue(const T&) >;
+
+        struct Plus
+        {
+            template< typename T >
+            std::enable_if_t< std::is_arithmetic<T>::value, T >
+            operator()(T a, T b) const { return a + b; }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, const Complex<T>& b) const { return Complex<T>(a.real + b.real, a.imag + b.imag); }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, T b) const { return Complex<T>(a.real + b, T(a.imag)); }
+
+            template< typename T >
+            Complex<T>
+            operator()(T a, const Complex<T>& b) const { return Complex<T>(a + b.real, T(b.imag)); }
+        };
+
+        struct Minus
+        {
+            template< typename T >
+            std::enable_if_t< std::is_arithmetic<T>::value, T >
+            operator()(T a, T b) const { return a - b; }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, const Complex<T>& b) const { return Complex<T>(a.real - b.real, a.imag - b.imag); }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, T b) const { return Complex<T>(a.real - b, T(a.imag)); }
+
+            template< typename T >
+            Complex<T>
+            operator()(T a, const Complex<T>& b) const { return Complex<T>(a - b.real, -b.imag); }
+        };
+
+        struct Multiplies
+        {
+            template< typename T >
+            std::enable_if_t< std::is_arithmetic<T>::value, T >
+            operator()(T a, T b) const { return a * b; }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, const Complex<T>& b) const
+            {
+                return Complex<T>(a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real);
+            }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a, T b) const { return Complex<T>(a.real * b, a.imag * b); }
+
+            template< typename T >
+            Complex<T>
+            operator()(T a, const Complex<T>& b) const { return Complex<T>(a * b.real, a * b.imag); }
+        };
+
+        struct Conj
+        {
+            template< typename T >
+            std::enable_if_t< std::is_arithmetic<T>::value, T >
+            operator()(T a) const { return a; }
+
+            template< typename T >
+            Complex<T>
+            operator()(const Complex<T>& a) const { return Complex<T>(T(a.real), -a.imag); }
+        };
+
+        struct Abs2
+        {
+            template< typename T >
+            std::enable_if_t< std::is_arithmetic<T>::value, T >
+            operator()(T a) const { return a * a; }
+
+            template< typename T >
+            T
+            operator()(const Complex<T>& a) const { return a.real * a.real + a.imag * a.imag; }
+        };
+
+        /**
+         * Binds a scalar to one side of a binary functor
+         */
+        template< class T_Func, typename T_Scalar, bool T_scalarIsLeft >
+        struct BindScalar
+        {
+            T_Func m_func;
+            T_Scalar m_scalar;
+
+            explicit BindScalar(T_Scalar scalar): m_scalar(scalar){}
+
+            template< typename T, bool T_isLeft = T_scalarIsLeft >
+            std::enable_if_t< T_isLeft, std::result_of_t< const T_Func(T_Scalar, const T&) > >
+            operator()(const T& val) const { return m_func(m_scalar, val); }
+
+            template< typename T, bool T_isLeft = T_scalarIsLeft >
+            std::enable_if_t< !T_isLeft, std::result_of_t< const T_Func(const T&, T_Scalar) > >
+            operator()(const T& val) const { return m_func(val, m_scalar); }
+        };
+
+        /**
+         * Evaluates to true if the data can be read through a plain pointer with a flat index
+         * when accessed with the given accessor
+         */
+        template< class T_Data, class T_Accessor, typename T_SFINAE = void >
+        struct IsFlatAccessible: std::false_type{};
+
+        template< class T_Data, class T_Accessor >
+        struct IsFlatAccessible<
+            T_Data,
+            T_Accessor,
+            void_t< decltype(std::declval<T_Data&>().getData()), typename T_Data::Memory, typename T_Data::BaseAccessor >
+        >: std::integral_constant< bool,
+            std::is_pointer< decltype(std::declval<T_Data&>().getData()) >::value &&
+            T_Data::isFlatMemory && !T_Data::isStrided &&
+            std::is_same< T_Accessor, traits::IdentityAccessor_t<T_Data> >::value &&
+            std::is_same< typename T_Data::BaseAccessor, traits::IdentityAccessor_t<typename T_Data::Memory> >::value
+        >{};
+
+        /**
+         * Accessor for expressions used when they are treated as containers
+         */
+        struct ExprAccessor
+        {
+            template< class T_Index, class T_Expr >
+            auto
+            operator()(const T_Index& idx, const T_Expr& expr) const
+            -> decltype(expr(idx))
+            {
+                return expr(idx);
+            }
+        };
+
+        /**
+         * Base class of all expressions, provides the container interface
+         */
+        template< unsigned T_numDims, typename T_Value >
+        struct ExprBase
+        {
+            static constexpr unsigned numDims = T_numDims;
+            using Value = T_Value;
+            static constexpr bool isComplex = traits::IsComplex<Value>::value;
+            static constexpr bool isStrided = false;
+            using type = traits::IntegralType_t<Value>;
+            using Extents = Vec<numDims>;
+            using IdentityAccessor = ExprAccessor;
+        };
+
+        template< class T_Extents, class T_OtherExtents >
+        void
+        checkExtents(const T_Extents& extents, const T_OtherExtents& other)
+        {
+            static constexpr unsigned numDims = traits::NumDims<T_Extents>::value;
+            static_assert(numDims == traits::NumDims<T_OtherExtents>::value, "Dimension mismatch");
+            for(unsigned i = 0; i < numDims; ++i)
+                if(extents[i] != other[i])
+                    throw std::runtime_error("Dimension " + std::to_string(i) + ": Extents mismatch");
+        }
+
+        /**
+         * Returns offset mod extent in [0, extent), also for negative offsets
+         */
+        template< typename T_Offset >
+        std::enable_if_t< std::is_signed<T_Offset>::value, size_t >
+        wrapOffset(T_Offset offset, size_t extent)
+        {
+            const long long signedExtent = static_cast<long long>(extent);
+            const long long result = static_cast<long long>(offset) % signedExtent;
+            return static_cast<size_t>(result < 0 ? result + signedExtent : result);
+        }
+
+        template< typename T_Offset >
+        std::enable_if_t< !std::is_signed<T_Offset>::value, size_t >
+        wrapOffset(T_Offset offset, size_t extent)
+        {
+            return offset % extent;
+        }
+
+    }  // namespace detail
+
+    /**
+     * Evaluates to true if T is an expression
+     */
+    template< typename T, typename T_SFINAE = void >
+    struct IsExpression: std::false_type{};
+
+    template< typename T >
+    struct IsExpression< T, void_t< typename std::decay_t<T>::IsExpressionTag > >: std::true_type{};
+
+    /**
+     * Leaf of an expression: A container accessed via an accessor
+     */
+    template< class T_Data, class T_Accessor = traits::IdentityAccessor_t<T_Data> >
+    struct ExprTerminal: detail::ExprBase<
+                            traits::NumDims<std::remove_const_t<T_Data>>::value,
+                            detail::ExprValue_t< std::result_of_t< T_Accessor(const Vec<traits::NumDims<std::remove_const_t<T_Data>>::value>&, T_Data&) > >
+                         >
+    {
+        using IsExpressionTag = void;
+        using Data = T_Data;
+        using Accessor = T_Accessor;
+        using Parent = detail::ExprBase<
+                            traits::NumDims<std::remove_const_t<T_Data>>::value,
+                            detail::ExprValue_t< std::result_of_t< T_Accessor(const Vec<traits::NumDims<std::remove_const_t<T_Data>>::value>&, T_Data&) > >
+                        >;
+        using typename Parent::Value;
+        using typename Parent::Extents;
+        static constexpr unsigned numDims = Parent::numDims;
+        static constexpr bool isFlat = detail::IsFlatAccessible< Data, Accessor >::value;
+
+        ExprTerminal(Data& data, const Accessor& acc = Accessor()): m_data(&data), m_acc(acc), m_ptr(getPtr(data))
+        {
+            policies::GetExtents<Data> extents(data);
+            for(unsigned i = 0; i < numDims; ++i)
+                m_extents[i] = extents[i];
+        }
+
+        const Extents&
+        getExtents() const
+        {
+            return m_extents;
+        }
+
+        template< class T_Index >
+        Value
+        operator()(const T_Index& idx) const
+        {
+            return detail::ToExprValue()(m_acc(idx, *m_data));
+        }
+
+        Value
+        flat(size_t idx) const
+        {
+            return detail::ToExprValue()(m_ptr[idx]);
+        }
+
+        /**
+         * Returns true if data is read at shifted positions, i.e. this terminal refers to data and is part of a shift
+         */
+        bool
+        readsShifted(const void* data, bool isShifted = false) const
+        {
+            return isShifted && static_cast<const void*>(m_data) == data;
+        }
+
+    private:
+        template< class T, bool T_isFlat = isFlat >
+        static std::enable_if_t< T_isFlat, decltype(std::declval<T&>().getData()) >
+        getPtr(T& data)
+        {
+            return data.getData();
+        }
+
+        template< class T, bool T_isFlat = isFlat >
+        static std::enable_if_t< !T_isFlat, const Value* >
+        getPtr(T&)
+        {
+            return nullptr;
+        }
+
+        Data* m_data;
+        // Accessors are not required to have a const ()-operator
+        mutable Accessor m_acc;
+        decltype(getPtr(std::declval<Data&>())) m_ptr;
+        Extents m_extents;
+    };
+
+    /**
+     * Expression applying a functor to every value of another expression
+     */
+    template< class T_Expr, class T_Func >
+    struct ExprUnary: detail::ExprBase<
+                        T_Expr::numDims,
+                        std::result_of_t< const T_Func(typename T_Expr::Value) >
+                      >
+    {
+        using IsExpressionTag = void;
+        using Parent = detail::ExprBase< T_Expr::numDims, std::result_of_t< const T_Func(typename T_Expr::Value) > >;
+        using typename Parent::Value;
+        using typename Parent::Extents;
+        static constexpr bool isFlat = T_Expr::isFlat;
+
+        ExprUnary(const T_Expr& expr, const T_Func& func = T_Func()): m_expr(expr), m_func(func){}
+
+        const Extents&
+        getExtents() const
+        {
+            return m_expr.getExtents();
+        }
+
+        template< class T_Index >
+        Value
+        operator()(const T_Index& idx) const
+        {
+            return m_func(m_expr(idx));
+        }
+
+        Value
+        flat(size_t idx) const
+        {
+            return m_func(m_expr.flat(idx));
+        }
+
+        bool
+        readsShifted(const void* data, bool isShifted = false) const
+        {
+            return m_expr.readsShifted(data, isShifted);
+        }
+
+    private:
+        T_Expr m_expr;
+        T_Func m_func;
+    };
+
+    /**
+     * Expression combining the values of 2 expressions with the same extents
+     */
+    template< class T_Left, class T_Right, class T_Func >
+    struct ExprBinary: detail::ExprBase<
+                        T_Left::numDims,
+                        std::result_of_t< const T_Func(typename T_Left::Value, typename T_Right::Value) >
+                       >
+    {
+        using IsExpressionTag = void;
+        using Parent = detail::ExprBase<
+                            T_Left::numDims,
+                            std::result_of_t< const T_Func(typename T_Left::Value, typename T_Right::Value) >
+                        >;
+        using typename Parent::Value;
+        using typename Parent::Extents;
+        static constexpr bool isFlat = T_Left::isFlat && T_Right::isFlat;
+        static_assert(T_Left::numDims == T_Right::numDims, "Dimension mismatch");
+        static_assert(std::is_same< typename T_Left::type, typename T_Right::type >::value, "Precision mismatch");
+
+        ExprBinary(const T_Left& left, const T_Right& right, const T_Func& func = T_Func()): m_left(left), m_right(right), m_func(func)
+        {
+            detail::checkExtents(m_left.getExtents(), m_right.getExtents());
+        }
+
+        const Extents&
+        getExtents() const
+        {
+            return m_left.getExtents();
+        }
+
+        template< class T_Index >
+        Value
+        operator()(const T_Index& idx) const
+        {
+            return m_func(m_left(idx), m_right(idx));
+        }
+
+        Value
+        flat(size_t idx) const
+        {
+            return m_func(m_left.flat(idx), m_right.flat(idx));
+        }
+
+        bool
+        readsShifted(const void* data, bool isShifted = false) const
+        {
+            return m_left.readsShifted(data, isShifted) || m_right.readsShifted(data, isShifted);
+        }
+
+    private:
+        T_Left m_left;
+        T_Right m_right;
+        T_Func m_func;
+    };
+
+    /**
+     * Expression that cyclically shifts another expression:
+     * Element idx is the element (idx - offset) mod extents of the base expression
+     */
+    template< class T_Expr >
+    struct ExprShift: detail::ExprBase< T_Expr::numDims, typename T_Expr::Value >
+    {
+        using IsExpressionTag = void;
+        using Parent = detail::ExprBase< T_Expr::numDims, typename T_Expr::Value >;
+        using typename Parent::Value;
+        using typename Parent::Extents;
+        static constexpr unsigned numDims = Parent::numDims;
+        static constexpr bool isFlat = false;
+
+        template< class T_Offsets >
+        ExprShift(const T_Expr& expr, const T_Offsets& offsets): m_expr(expr)
+        {
+            const Extents& extents = m_expr.getExtents();
+            // Store the offset that has to be added to an index, so no subtraction/wrap-around of negatives is required
+            for(unsigned i = 0; i < numDims; ++i)
+                m_offsets[i] = extents[i] ? (extents[i] - detail::wrapOffset(offsets[i], extents[i])) % extents[i] : 0;
+        }
+
+        const Extents&
+        getExtents() const
+        {
+            return m_expr.getExtents();
+        }
+
+        template< class T_Index >
+        Value
+        operator()(const T_Index& idx) const
+        {
+            const Extents& extents = m_expr.getExtents();
+            Extents srcIdx;
+            for(unsigned i = 0; i < numDims; ++i)
+            {
+                size_t tmp = idx[i] + m_offsets[i];
+                srcIdx[i] = tmp >= extents[i] ? tmp - extents[i] : tmp;
+            }
+            return m_expr(srcIdx);
+        }
+
+        bool
+        readsShifted(const void* data, bool = false) const
+        {
+            return m_expr.readsShifted(data, true);
+        }
+
+    private:
+        T_Expr m_expr;
+        Extents m_offsets;
+    };
+
+    /**
+     * Creates an expression for a container accessed with its default accessor
+     */
+    template< class T_Data >
+    ExprTerminal< T_Data >
+    makeExpr(T_Data& data)
+    {
+        return ExprTerminal< T_Data >(data);
+    }
+
+    /**
+     * Creates an expression for a container accessed with the given accessor
+     */
+    template< class T_Data, class T_Accessor >
+    ExprTerminal< T_Data, T_Accessor >
+    makeExpr(T_Data& data, const T_Accessor& acc)
+    {
+        return ExprTerminal< T_Data, T_Accessor >(data, acc);
+    }
+
+    /**
+     * Returns the complex conjugate
+     */
+    template< class T_Expr, typename = std::enable_if_t< IsExpression<T_Expr>::value > >
+    ExprUnary< T_Expr, detail::Conj >
+    conj(const T_Expr& expr)
+    {
+        return ExprUnary< T_Expr, detail::Conj >(expr);
+    }
+
+    /**
+     * Returns the squared absolute value (intensity)
+     */
+    template< class T_Expr, typename = std::enable_if_t< IsExpression<T_Expr>::value > >
+    ExprUnary< T_Expr, detail::Abs2 >
+    abs2(const T_Expr& expr)
+    {
+        return ExprUnary< T_Expr, detail::Abs2 >(expr);
+    }
+
+    /**
+     * Returns the expression scaled by a constant factor
+     */
+    template< class T_Expr, typename = std::enable_if_t< IsExpression<T_Expr>::value > >
+    ExprUnary< T_Expr, detail::BindScalar< detail::Multiplies, typename T_Expr::type, false > >
+    scale(const T_Expr& expr, typename T_Expr::type factor)
+    {
+        using Func = detail::BindScalar< detail::Multiplies, typename T_Expr::type, false >;
+        return ExprUnary< T_Expr, Func >(expr, Func(factor));
+    }
+
+    /**
+     * Returns the expression cyclically shifted by the given offsets (element idx is taken from idx - offsets)
+     * Offsets may be negative (shift towards lower indices)
+     */
+    template< class T_Expr, class T_Offsets, typename = std::enable_if_t< IsExpression<T_Expr>::value > >
+    ExprShift< T_Expr >
+    shift(const T_Expr& expr, const T_Offsets& offsets)
+    {
+        return ExprShift< T_Expr >(expr, offsets);
+    }
+
+    /**
+     * Returns the expression shifted by half its extents (moves the zero frequency to the center)
+     * Same as accessing the data with the TransposeAccessor for even extents
+     */
+    template< class T_Expr, typename = std::enable_if_t< IsExpression<T_Expr>::value > >
+    ExprShift< T_Expr >
+    fftShift(const T_Expr& expr)
+    {
+        typename T_Expr::Extents offsets;
+        for(unsigned i = 0; i < T_Expr::numDims; ++i)
+            offsets[i] = expr.getExtents()[i] / 2;
+        return ExprShift< T_Expr >(expr, offsets);
+    }
+
+#define LIFFT_EXPR_BINARY_OP(OP, FUNC)                                                                                         \
+    template< class T_Left, class T_Right,                                                                                     \
+              typename = std::enable_if_t< IsExpression<T_Left>::value && IsExpression<T_Right>::value > >                    \
+    ExprBinary< T_Left, T_Right, detail::FUNC >                                                                                \
+    operator OP(const T_Left& left, const T_Right& right)                                                                      \
+    {                                                                                                                          \
+        return ExprBinary< T_Left, T_Right, detail::FUNC >(left, right);                                                       \
+    }                                                                                                                          \
+                                                                                                                               \
+    template< class T_Expr, typename T_Scalar,                                                                                 \
+              typename = std::enable_if_t< IsExpression<T_Expr>::value && std::is_arithmetic<T_Scalar>::value > >             \
+    ExprUnary< T_Expr, detail::BindScalar< detail::FUNC, typename T_Expr::type, false > >                                      \
+    operator OP(const T_Expr& expr, T_Scalar scalar)                                                                           \
+    {                                                                                                                          \
+        using Func = detail::BindScalar< detail::FUNC, typename T_Expr::type, false >;                                         \
+        return ExprUnary< T_Expr, Func >(expr, Func(static_cast<typename T_Expr::type>(scalar)));                              \
+    }                                                                                                                          \
+                                                                                                                               \
+    template< typename T_Scalar, class T_Expr,                                                                                 \
+              typename = std::enable_if_t< IsExpression<T_Expr>::value && std::is_arithmetic<T_Scalar>::value > >             \
+    ExprUnary< T_Expr, detail::BindScalar< detail::FUNC, typename T_Expr::type, true > >                                       \
+    operator OP(T_Scalar scalar, const T_Expr& expr)                                                                           \
+    {                                                                                                                          \
+        using Func = detail::BindScalar< detail::FUNC, typename T_Expr::type, true >;                                          \
+        return ExprUnary< T_Expr, Func >(expr, Func(static_cast<typename T_Expr::type>(scalar)));                              \
+    }
+
+    LIFFT_EXPR_BINARY_OP(+, Plus)
+    LIFFT_EXPR_BINARY_OP(-, Minus)
+    LIFFT_EXPR_BINARY_OP(*, Multiplies)
+
+#undef LIFFT_EXPR_BINARY_OP
+
+    namespace detail {
+
+        /**
+         * Minimum number of elements a thread should work on in \ref assign
+         */
+        constexpr size_t minExprElementsPerThread = 1 << 15;
+
+        template< bool T_isFlat >
+        struct AssignImpl
+        {
+            template< class T_Dst, class T_Expr, class T_DstAccessor >
+            static void
+            assign(T_Dst& dst, const T_Expr& expr, unsigned numThreads, const T_DstAccessor&)
+            {
+                auto* ptr = dst.getData();
+                const size_t numElements = policies::getNumElementsFromExtents(expr.getExtents());
+                policies::parallelFor(numElements, numThreads, minExprElementsPerThread, [ptr, &expr](size_t begin, size_t end){
+                    for(size_t i = begin; i < end; ++i)
+                        ptr[i] = expr.flat(i);
+                });
+            }
+        };
+
+        /**
+         * Calls func(idx, flatIdx) for all indices within extents using up to numThreads threads
+         * The work is split along the outermost dimension so each thread walks a contiguous part of the range.
+         * func is copied per thread
+         */
+        template< class T_Extents, class T_Func >
+        void
+        forEachIndex(const T_Extents& extents, unsigned numThreads, const T_Func& func)
+        {
+            static constexpr unsigned numDims = traits::NumDims<T_Extents>::value;
+            const size_t numElements = policies::getNumElementsFromExtents(extents);
+            if(!numElements)
+                return;
+            const size_t sliceSize = numElements / extents[0];
+            policies::parallelFor<1>(extents[0], numThreads, std::max<size_t>(minExprElementsPerThread / sliceSize, 1),
+                    [&](size_t begin, size_t end){
+                T_Func threadFunc(func);
+                T_Extents idx = T_Extents::all(0);
+                idx[0] = begin;
+                for(size_t i = begin * sliceSize; i < end * sliceSize; ++i)
+                {
+                    threadFunc(idx, i);
+                    // Increment the index with carry, last dimension varies fastest
+                    for(unsigned dim = numDims - 1; ++idx[dim] == extents[dim] && dim > 0; --dim)
+                        idx[dim] = 0;
+                }
+            });
+        }
+
+        /**
+         * Writes values provided by getValue(idx, flatIdx) to dst via the accessor
+         */
+        template< class T_Dst, class T_DstAccessor, class T_GetValue >
+        struct WriteFunc
+        {
+            WriteFunc(T_Dst& dst, const T_DstAccessor& acc, const T_GetValue& getValue): m_dst(dst), m_acc(acc), m_getValue(getValue){}
+
+            template< class T_Index >
+            void
+            operator()(const T_Index& idx, size_t flatIdx)
+            {
+                m_acc.write(idx, m_dst, m_getValue(idx, flatIdx));
+            }
+
+        private:
+            T_Dst& m_dst;
+            policies::detail::WriteAccessorWrapper<T_DstAccessor> m_acc;
+            T_GetValue m_getValue;
+        };
+
+        template< class T_Dst, class T_DstAccessor, class T_GetValue >
+        WriteFunc< T_Dst, T_DstAccessor, T_GetValue >
+        makeWriteFunc(T_Dst& dst, const T_DstAccessor& acc, const T_GetValue& getValue)
+        {
+            return WriteFunc< T_Dst, T_DstAccessor, T_GetValue >(dst, acc, getValue);
+        }
+
+        template<>
+        struct AssignImpl<false>
+        {
+            template< class T_Dst, class T_Expr, class T_DstAccessor >
+            static void
+            assign(T_Dst& dst, const T_Expr& expr, unsigned numThreads, const T_DstAccessor& accDst)
+            {
+                using Extents = typename T_Expr::Extents;
+                forEachIndex(expr.getExtents(), numThreads,
+                        makeWriteFunc(dst, accDst, [&expr](const Extents& idx, size_t){ return expr(idx); }));
+            }
+        };
+
+        /**
+         * Assignment for expressions that read dst at shifted positions:
+         * Other threads (and this one) would overwrite values before they are read, so the expression is evaluated
+         * into a temporary first which is then copied to dst
+         */
+        template< class T_Dst, class T_Expr, class T_DstAccessor >
+        void
+        assignViaTemporary(T_Dst& dst, const T_Expr& expr, unsigned numThreads, const T_DstAccessor& accDst)
+        {
+            using Extents = typename T_Expr::Extents;
+            const Extents& extents = expr.getExtents();
+            std::vector< typename T_Expr::Value > tmp(policies::getNumElementsFromExtents(extents));
+            auto* tmpPtr = tmp.data();
+            forEachIndex(extents, numThreads, [&expr, tmpPtr](const Extents& idx, size_t i){ tmpPtr[i] = expr(idx); });
+            forEachIndex(extents, numThreads,
+                    makeWriteFunc(dst, accDst, [tmpPtr](const Extents&, size_t i){ return tmpPtr[i]; }));
+        }
+
+    }  // namespace detail
+
+    /**
+     * Evaluates the expression and writes the result to dst in a single pass
+     * The work is split over up to numThreads threads. If dst and all containers in the expression are contiguous
+     * and use their default accessors, a flat (vectorizable) loop is used, otherwise an index based one.
+     * dst may be part of the expression: If it is read at shifted positions (e.g. `assign(a, fftShift(makeExpr(a)))`)
+     * the expression is evaluated into a temporary first. Aliasing is only detected for dst itself, not for other
+     * containers (e.g. views) sharing its memory, and accessors that read other elements than the written one must
+     * not be used on dst within the expression
+     *
+     * @param dst        Destination container, must have the same extents as the expression
+     * @param expr       Expression to evaluate
+     * @param numThreads Number of threads to use, 0 for all hardware threads [0]
+     * @param accDst     Accessor used to write to dst
+     */
+    template< class T_Dst, class T_Expr, class T_DstAccessor = traits::IdentityAccessor_t<T_Dst> >
+    std::enable_if_t< IsExpression<T_Expr>::value >
+    assign(T_Dst& dst, const T_Expr& expr, unsigned numThreads = 0, const T_DstAccessor& accDst = T_DstAccessor())
+    {
+        static_assert(traits::NumDims<T_Dst>::value == T_Expr::numDims, "Dimension mismatch");
+        policies::GetExtents<T_Dst> extents(dst);
+        detail::checkExtents(expr.getExtents(), extents);
+        static constexpr bool isFlat = T_Expr::isFlat && detail::IsFlatAccessible< T_Dst, T_DstAccessor >::value;
+        if(expr.readsShifted(&dst))
+            detail::assignViaTemporary(dst, expr, numThreads, accDst);
+        else
+            detail::AssignImpl< isFlat >::assign(dst, expr, numThreads, accDst);
+    }
+
+}  // namespace types
+}  // namespace LiFFT
@@ -0,0 +1,177 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libLiFFT/types/Vec.hpp"
+#include "libLiFFT/void_t.hpp"
+#include <cstddef>
+#include <type_traits>
+
+namespace LiFFT {
+namespace types {
+
+    namespace detail {
+
+        template< unsigned... T_extents >
+        struct StaticExtentsImpl;
+
+        template<>
+        struct StaticExtentsImpl<>
+        {
+            static constexpr size_t numElements = 1;
+
+            static constexpr unsigned
+            get(unsigned /*dim*/)
+            {
+                return 0;
+            }
+
+            static constexpr size_t
+            getStride(unsigned /*dim*/)
+            {
+                return 1;
+            }
+        };
+
+        template< unsigned T_first, unsigned... T_rest >
+        struct StaticExtentsImpl< T_first, T_rest... >
+        {
+            using Rest = StaticExtentsImpl< T_rest... >;
+            static constexpr size_t numElements = T_first * Rest::numElements;
+
+            static constexpr unsigned
+            get(unsigned dim)
+            {
+                return dim == 0 ? T_first : Rest::get(dim - 1);
+            }
+
+            static constexpr size_t
+            getStride(unsigned dim)
+            {
+                return dim == 0 ? Rest::numElements : Rest::getStride(dim - 1);
+            }
+        };
+
+    }  // namespace detail
+
+    /**
+     * Extents that are known at compile time
+     * Can be used like a Vec (e.g. as extents of a container) but all values and the derived strides are constexpr
+     * Row-Major order assumed, that is last dimension varies fastest
+     */
+    template< unsigned... T_extents >
+    struct StaticExtents
+    {
+        static constexpr unsigned numDims = sizeof...(T_extents);
+        static_assert(numDims > 0, "No dimensions");
+        using type = unsigned;
+        using Impl = detail::StaticExtentsImpl< T_extents... >;
+
+        /**
+         * Total number of elements
+         */
+        static constexpr size_t numElements = Impl::numElements;
+
+        static constexpr unsigned
+        get(unsigned dim)
+        {
+            return Impl::get(dim);
+        }
+
+        constexpr unsigned
+        operator[](unsigned dim) const
+        {
+            return get(dim);
+        }
+
+        /**
+         * Returns the stride (in elements) of the given dimension for contiguous data
+         */
+        static constexpr size_t
+        getStride(unsigned dim)
+        {
+            return Impl::getStride(dim);
+        }
+
+        /**
+         * Converts to a runtime vector
+         */
+        operator Vec< numDims >() const
+        {
+            return Vec< numDims >(T_extents...);
+        }
+    };
+
+    template< unsigned... T_extents >
+    constexpr size_t StaticExtents< T_extents... >::numElements;
+
+    /**
+     * Evaluates to true type if T is a StaticExtents type
+     */
+    template< typename T >
+    struct IsStaticExtents: std::false_type{};
+
+    template< unsigned... T_extents >
+    struct IsStaticExtents< StaticExtents< T_extents... > >: std::true_type{};
+
+    /**
+     * Replaces the extents of the last dimension
+     * type is the resulting StaticExtents type
+     */
+    template< class T_Extents, unsigned T_newLast >
+    struct ReplaceLastExtent;
+
+    template< unsigned T_last, unsigned T_newLast >
+    struct ReplaceLastExtent< StaticExtents< T_last >, T_newLast >
+    {
+        using type = StaticExtents< T_newLast >;
+    };
+
+    template< unsigned T_newLast, unsigned T_first, unsigned T_second, unsigned... T_rest >
+    struct ReplaceLastExtent< StaticExtents< T_first, T_second, T_rest... >, T_newLast >
+    {
+    private:
+        template< class T >
+        struct PushFront;
+
+        template< unsigned... T_values >
+        struct PushFront< StaticExtents< T_values... > >
+        {
+            using type = StaticExtents< T_first, T_values... >;
+        };
+    public:
+        using type = typename PushFront<
+                        typename ReplaceLastExtent< StaticExtents< T_second, T_rest... >, T_newLast >::type
+                     >::type;
+    };
+
+}  // namespace types
+
+namespace traits {
+
+    /**
+     * Evaluates to true type if the given container has extents known at compile time
+     * That is the case if it provides a StaticExtents typedef
+     */
+    template< typename T, typename T_SFINAE = void >
+    struct HasStaticExtents: std::false_type{};
+
+    template< typename T >
+    struct HasStaticExtents< T, void_t< typename T::StaticExtents > >: types::IsStaticExtents< typename T::StaticExtents >{};
+
+}  // namespace traits
+}  // namespace LiFFT
@@ -41,7 +41,7 @@ namespace LiFFT {
 
             static constexpr unsigned numDims = traits::NumDims<Base>::value;
 
-            SymmetricWrapper(Base& base, unsigned realSize): m_base(base), m_realSize(realSize){}
+            SymmetricWrapper(Base& base, size_t realSize): m_base(base), m_realSize(realSize){}
 
             template< typename T >
             static Complex<T>
@@ -112,13 +112,13 @@ namespace LiFFT {
         private:
             Base& m_base;
             BaseAccessor m_acc;
-            unsigned m_realSize;
+            size_t m_realSize;
             friend struct policies::GetExtentsImpl<SymmetricWrapper>;
         };
 
         template< class T_Base, class T_BaseAccessor = traits::IdentityAccessor_t<T_Base> >
         SymmetricWrapper< T_Base, T_BaseAccessor >
-        makeSymmetricWrapper(T_Base& base, unsigned realSize)
+        makeSymmetricWrapper(T_Base& base, size_t realSize)
         {
             return SymmetricWrapper< T_Base, T_BaseAccessor >(base, realSize);
         }
@@ -136,7 +136,7 @@ namespace LiFFT {
 
             GetExtentsImpl(const Data& data): m_data(data){}
 
-            unsigned operator[](unsigned dimIdx) const
+            size_t operator[](unsigned dimIdx) const
             {
                 if(dimIdx == numDims-1)
                     return m_data.m_realSize;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cassert>
+#include <stdexcept>
 #include <memory>
 #include "libLiFFT/c++14_types.hpp"
 
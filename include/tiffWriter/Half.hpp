@@ -0,0 +1,106 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace tiffWriter {
+
+    /**
+     * IEEE 754 half precision (16 bit) floating point value as stored in TIFF files with 16 bits per IEEEFP sample
+     * Only used for storage: It is converted from and to float (rounding to nearest even) for calculations
+     */
+    struct Half
+    {
+        uint16_t bits;
+
+        Half() = default;
+
+        Half(float value): bits(fromFloat(value)){}
+
+        operator float() const
+        {
+            return toFloat(bits);
+        }
+
+        static uint16_t
+        fromFloat(float value)
+        {
+            uint32_t x;
+            std::memcpy(&x, &value, sizeof(x));
+            const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+            const uint32_t absX = x & 0x7FFFFFFF;
+            // Inf and NaN (keeping the upper bits of the payload, quiet)
+            if(absX >= 0x7F800000)
+                return sign | 0x7C00 | (absX > 0x7F800000 ? 0x200 | ((absX >> 13) & 0x3FF) : 0);
+            // Values >= 65520 round to infinity
+            if(absX >= 0x477FF000)
+                return sign | 0x7C00;
+            uint32_t res, rem, halfway;
+            if(absX < 0x38800000)
+            {
+                // Subnormal (< 2^-14), values <= 2^-25 round to 0
+                if(absX < 0x33000000)
+                    return sign;
+                const uint32_t shift = 126 - (absX >> 23);
+                const uint32_t mantissa = (absX & 0x7FFFFF) | 0x800000;
+                res = mantissa >> shift;
+                rem = mantissa & ((1u << shift) - 1);
+                halfway = 1u << (shift - 1);
+            }else
+            {
+                // Rebias the exponent from 127 to 15, a carry of the rounding correctly increases the exponent
+                res = (absX - 0x38000000) >> 13;
+                rem = absX & 0x1FFF;
+                halfway = 0x1000;
+            }
+            if(rem > halfway || (rem == halfway && (res & 1)))
+                ++res;
+            return sign | static_cast<uint16_t>(res);
+        }
+
+        static float
+        toFloat(uint16_t value)
+        {
+            const uint32_t sign = uint32_t(value & 0x8000) << 16;
+            uint32_t exponent = (value >> 10) & 0x1F;
+            uint32_t mantissa = value & 0x3FF;
+            uint32_t x;
+            if(exponent == 0x1F)
+                x = sign | 0x7F800000 | (mantissa << 13);
+            else if(exponent)
+                x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            else if(mantissa)
+            {
+                // Subnormal: Normalize the mantissa
+                exponent = 113;
+                while(!(mantissa & 0x400))
+                {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                x = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+            }else
+                x = sign;
+            float res;
+            std::memcpy(&res, &x, sizeof(res));
+            return res;
+        }
+    };
+
+}  // namespace tiffWriter
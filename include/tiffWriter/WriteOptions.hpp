@@ -0,0 +1,127 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace tiffWriter{
+
+    enum class Compression
+    {
+        None,
+        LZW,
+        Deflate,
+        ZSTD
+    };
+
+    enum class Predictor
+    {
+        None,
+        Horizontal, // Differences of neighboring values (integer types)
+        FloatingPoint // Differences of the bytes of neighboring floating point values
+    };
+
+    enum class BigTiff
+    {
+        Auto, // BigTIFF if the data might not fit into a classic TIFF
+        Never,
+        Always
+    };
+
+    /**
+     * Layout and encoding of written TIFF files
+     */
+    struct WriteOptions
+    {
+        Compression compression = Compression::LZW;
+        /** Ignored for uncompressed files */
+        Predictor predictor = Predictor::None;
+        /** Compression level for Deflate (1-9) and ZSTD (1-22), 0 for the default level */
+        int level = 0;
+        /** Rows per strip, 0 chooses strips of about 256KiB. Ignored for tiles */
+        unsigned rowsPerStrip = 0;
+        /** Width and height of the tiles (multiple of 16), 0 writes strips */
+        unsigned tileSize = 0;
+        /** Threads used to encode compressed strips/tiles, 0 for all hardware threads */
+        unsigned numThreads = 0;
+        /** Whether to write a BigTIFF (64 bit offsets) which is required for files larger than 4GB */
+        BigTiff bigTiff = BigTiff::Auto;
+        /** Whether to store floating point pixels as 16 bit half floats (halves the size). Ignored for ARGB images */
+        bool halfFloat = false;
+        /**
+         * Number of 2x downsampled levels stored as SubIFDs of each image (pyramid) for viewers of large images,
+         * 0 writes only the full resolution. Pyramids are tiled (see \ref defaultPyramidTileSize)
+         */
+        unsigned numPyramidLevels = 0;
+
+        WriteOptions() = default;
+        WriteOptions(Compression comp, Predictor pred = Predictor::None):
+            compression(comp), predictor(pred){}
+    };
+
+    /** Tile size used for pyramids if WriteOptions::tileSize is 0 */
+    static constexpr unsigned defaultPyramidTileSize = 256;
+
+    /**
+     * Returns the options actually used for writing, i.e. with the tile size set for pyramids
+     */
+    inline WriteOptions
+    getLayoutOptions(const WriteOptions& options)
+    {
+        WriteOptions result = options;
+        if(result.numPyramidLevels && !result.tileSize)
+            result.tileSize = defaultPyramidTileSize;
+        return result;
+    }
+
+    /**
+     * Returns whether a file with the given amount of (uncompressed) image data is written as a BigTIFF
+     * Auto decides this from the uncompressed size as the compressed one is not known up front.
+     * Some room is left for the tags, offset tables and incompressible data.
+     * Pyramid levels add up to a third of the size of the full resolution image.
+     */
+    inline bool
+    isBigTiffRequired(const WriteOptions& options, uint64_t dataSize)
+    {
+        static constexpr uint64_t maxClassicTiffDataSize = 0xF0000000u;
+        if(options.numPyramidLevels)
+            dataSize += dataSize / 3;
+        if(options.bigTiff == BigTiff::Auto)
+            return dataSize > maxClassicTiffDataSize;
+        return options.bigTiff == BigTiff::Always;
+    }
+
+    /**
+     * Returns the compression with the given name (none, lzw, deflate, zstd)
+     */
+    inline Compression
+    getCompression(const std::string& name)
+    {
+        if(name == "none")
+            return Compression::None;
+        else if(name == "lzw")
+            return Compression::LZW;
+        else if(name == "deflate")
+            return Compression::Deflate;
+        else if(name == "zstd")
+            return Compression::ZSTD;
+        throw std::runtime_error("Unknown compression: " + name);
+    }
+
+}  // namespace tiffWriter
@@ -0,0 +1,65 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#pragma once
+
+#include "tiffWriter/WriteOptions.hpp"
+#include <boost/program_options.hpp>
+#include <string>
+
+namespace tiffWriter {
+
+    /**
+     * Command line arguments for the layout and encoding of written floating point TIFFs
+     * The values are stored in this instance, so it must outlive the parsing of the arguments
+     */
+    class WriteOptionsArgs
+    {
+        std::string m_compression;
+        bool m_halfFloat = false;
+        unsigned m_numPyramidLevels = 0;
+
+    public:
+        /**
+         * Adds the arguments (compression, half, pyramid) to the description
+         */
+        void
+        addTo(boost::program_options::options_description& desc)
+        {
+            namespace po = boost::program_options;
+            desc.add_options()
+                ("compression,c", po::value<std::string>(&m_compression)->default_value("deflate"), "Compression of the written files (none, lzw, deflate, zstd)")
+                ("half", po::bool_switch(&m_halfFloat), "Write 16 bit (half) floats instead of 32 bit floats")
+                ("pyramid", po::value<unsigned>(&m_numPyramidLevels)->default_value(0), "Number of 2x downsampled levels written as a tiled pyramid for viewers (0=none)")
+            ;
+        }
+
+        /**
+         * Returns the options from the parsed arguments
+         * Large strips with a floating point predictor compress well and are encoded in parallel
+         */
+        WriteOptions
+        getWriteOptions() const
+        {
+            WriteOptions options(getCompression(m_compression), Predictor::FloatingPoint);
+            options.halfFloat = m_halfFloat;
+            options.numPyramidLevels = m_numPyramidLevels;
+            return options;
+        }
+    };
+
+}  // namespace tiffWriter
@@ -16,11 +16,13 @@
  
 #pragma once
 
+#include <cstdint>
 #include <type_traits>
 #include <limits>
 #include <algorithm>
 #include <array>
 #include "libLiFFT/c++14_types.hpp"
+#include "tiffWriter/Half.hpp"
 
 namespace tiffWriter {
 
@@ -34,6 +36,9 @@ namespace tiffWriter {
     template< typename T>
     struct GetMaxVal< T, true >: std::integral_constant< int, 1 >{};
 
+    template<>
+    struct GetMaxVal< Half, false >: std::integral_constant< int, 1 >{};
+
     /**
      * Converts a single channel
      * FP -> FP: values are unchanged
@@ -144,6 +149,28 @@ namespace tiffWriter {
         }
     };
 
+    /**
+     * Half -> Any: Same as for floats
+     */
+    template< typename T_Dest, bool T_minIsBlack >
+    struct ConvertHalf: ConvertChannel< float, T_Dest, T_minIsBlack >
+    {
+        using Src = Half;
+        using Dest = T_Dest;
+
+        Dest
+        operator()(Half src)
+        {
+            return ConvertChannel< float, T_Dest, T_minIsBlack >::operator()(src);
+        }
+    };
+
+    template< typename T_Dest, bool T_minIsBlack >
+    struct ConvertChannel< Half, T_Dest, T_minIsBlack, false, true >: ConvertHalf< T_Dest, T_minIsBlack >{};
+
+    template< typename T_Dest, bool T_minIsBlack >
+    struct ConvertChannel< Half, T_Dest, T_minIsBlack, false, false >: ConvertHalf< T_Dest, T_minIsBlack >{};
+
     /**
      * Converts an (A)RGB value to mono using the weighted sum method
      */
@@ -22,6 +22,8 @@
 #include <boost/utility.hpp>
 #include "tiffWriter/ImageFormat.hpp"
 #include "tiffWriter/FormatTraits.hpp"
+#include "tiffWriter/WriteOptions.hpp"
+#include "libLiFFT/mem/MappedFile.hpp"
 #include <memory>
 
 namespace tiffWriter
@@ -60,29 +62,56 @@ namespace tiffWriter
         using ChannelType = typename PixelType<imgFormat>::ChannelType;
         using Ref = DataType&;
         using ConstRef = const DataType&;
+        /** Minimum size (in bytes) of the image data per thread for decoding or encoding in parallel */
+        static constexpr size_t minParallelSize = 1 << 20;
 
         std::string m_filepath;
         std::unique_ptr<TIFF, void(*)(TIFF*)> m_handle;
-        std::unique_ptr<DataType[], void(*)(DataType*)> m_data;
-        bool m_isReadable, m_isWriteable, m_dataWritten;
+        using DataPtr = std::unique_ptr<DataType[], void(*)(DataType*)>;
+        DataPtr m_data;
+        /** File whose pixel data m_data points to if it is memory mapped (see \ref mapData) */
+        LiFFT::mem::MappedFile m_mappedFile;
+        bool m_isReadable, m_isWriteable, m_dataWritten, m_isBigTiff;
         unsigned m_width, m_height;
+        /** Region of the file that is read, a width of 0 selects the whole image */
+        unsigned m_regionX, m_regionY, m_regionWidth, m_regionHeight;
+        /** Extents of the whole image in the file */
+        unsigned m_fileWidth, m_fileHeight;
+        /** Number of threads used to decode compressed files, 0 for all hardware threads */
+        unsigned m_numThreads;
+        /** Whether uncompressed files may be mapped instead of read (see \ref setMapping) */
+        bool m_useMapping;
         bool originIsAtTop;
         uint16 samplesPerPixel, bitsPerSample, tiffSampleFormat, photometric;
 
         void openHandle(const std::string& filePath, const char* mode);
+        void prepareWrite(const WriteOptions& options, uint64_t fileDataSize);
         void closeHandle();
+        void readExtents();
         void allocData();
+        bool mapData();
+        void releaseMapping(bool keepValues = false);
+        void readFormat();
         void loadData();
+        void loadData(DataType* dst, size_t rowStride);
+        void writeTags(const WriteOptions& options, bool saveAsARGB, unsigned width, unsigned height);
+        void writeData(const WriteOptions& options, bool saveAsARGB, const DataType* data, unsigned width, unsigned height);
+        void writeDirectory(const WriteOptions& options, bool saveAsARGB);
         template<typename T>
         void checkedWrite(uint16 tag, T value);
 
-        template< uint16_t T_numChannels, bool T_minIsBlack >
+        template< uint16_t T_numChannels, bool T_minIsBlack, class T_Reader >
         void
-        convert(char* tmp);
+        convert(const T_Reader& reader, DataType* dst, size_t rowStride);
+
+        static void freeBuffer(DataType* p){ Allocator().free(p); }
+        static void keepBuffer(DataType*){}
 
         Image(const Image&) = delete;
         Image& operator=(const Image&) = delete;
     public:
+        /** Type of a pixel in memory */
+        using Pixel = DataType;
 
         /**
          * Creates an invalid image using the standard allocator.
@@ -91,11 +120,17 @@ namespace tiffWriter
         Image():
             m_filepath(""),
             m_handle(nullptr, TIFFClose),
-            m_data(nullptr, [](DataType* p){ Allocator().free(p);}),
+            m_data(nullptr, &freeBuffer),
             m_isReadable(false),
             m_isWriteable(false),
             m_dataWritten(false),
-            m_width(0), m_height(0), originIsAtTop(true)
+            m_isBigTiff(false),
+            m_width(0), m_height(0),
+            m_regionX(0), m_regionY(0), m_regionWidth(0), m_regionHeight(0),
+            m_fileWidth(0), m_fileHeight(0),
+            m_numThreads(0),
+            m_useMapping(true),
+            originIsAtTop(true)
         {}
         Image(Image&&) = default;
         Image& operator=(Image&&) = default;
@@ -140,6 +175,37 @@ namespace tiffWriter
          */
         void open(const std::string& filePath, bool loadData = true);
 
+        /**
+         * Opens a rectangular region of the image at the given filePath for reading
+         * Only the strips or tiles intersecting the region are decoded. The image then has the
+         * extents of the region, which is also used for other pages (see \ref setPage)
+         * Implicitly closes an open image
+         *
+         * @param filePath Path to the image to load
+         * @param x Offset of the region in x-direction (column in the file)
+         * @param y Offset of the region in y-direction (row in the file)
+         * @param w Width of the region
+         * @param h Height of the region
+         * @param loadData True if the image data should be loaded or only its memory allocated.
+         */
+        void openRegion(const std::string& filePath, unsigned x, unsigned y, unsigned w, unsigned h, bool loadData = true);
+
+        /**
+         * Opens a rectangular region of the image at the given filePath and decodes it directly into dst
+         * (e.g. a slice of a volume) instead of the internal buffer, which is freed. So the pixels cannot be
+         * accessed through this image afterwards, but its extents can still be queried.
+         * Implicitly closes an open image
+         *
+         * @param filePath Path to the image to load
+         * @param x Offset of the region in x-direction (column in the file)
+         * @param y Offset of the region in y-direction (row in the file)
+         * @param w Width of the region
+         * @param h Height of the region
+         * @param dst Memory for the first pixel of the region
+         * @param rowStride Distance between the first pixels of 2 rows in dst in pixels (at least w)
+         */
+        void readRegionTo(const std::string& filePath, unsigned x, unsigned y, unsigned w, unsigned h, Pixel* dst, size_t rowStride);
+
         /**
          * Opens the image at the given filePath for writing
          * Overwrites or creates it
@@ -169,6 +235,15 @@ namespace tiffWriter
          */
         void load();
 
+        /**
+         * Decodes the image (or the opened region) directly into dst instead of the internal buffer
+         * Throws an exception if the image is not opened for reading
+         *
+         * @param dst Memory for the first pixel
+         * @param rowStride Distance between the first pixels of 2 rows in dst in pixels (at least the width)
+         */
+        void loadTo(Pixel* dst, size_t rowStride);
+
         /**
          * Saves the image data to file. This is NOT done in the destructor!
          * Throws an exception if the image is not opened for writing
@@ -176,7 +251,59 @@ namespace tiffWriter
          * @param compress Whether to compress the file or not
          * @param saveAsARGB Whether to save ARGB files as ARGB (true) or RGB only (ignored for monochromatic files)
          */
-        void save(bool compress = true, bool saveAsARGB = true);
+        void save(bool compress = true, bool saveAsARGB = true)
+        {
+            save(WriteOptions(compress ? Compression::LZW : Compression::None), saveAsARGB);
+        }
+
+        /**
+         * Saves the image data to file with the given layout and compression. This is NOT done in the destructor!
+         * Throws an exception if the image is not opened for writing
+         * Pyramid levels (see WriteOptions::numPyramidLevels) are computed from the image data and written as well
+         *
+         * @param options Layout and encoding of the file
+         * @param saveAsARGB Whether to save ARGB files as ARGB (true) or RGB only (ignored for monochromatic files)
+         */
+        void save(const WriteOptions& options, bool saveAsARGB = true);
+
+        /**
+         * Saves the image data as a page of a multi-page file and starts the next page
+         * Throws an exception if the image is not opened for writing
+         *
+         * @param page Index of the page (pages must be saved in order)
+         * @param numPages Total number of pages of the file
+         * @param compress Whether to compress the page or not
+         * @param saveAsARGB Whether to save ARGB files as ARGB (true) or RGB only (ignored for monochromatic files)
+         */
+        void savePage(unsigned page, unsigned numPages, bool compress = true, bool saveAsARGB = true)
+        {
+            savePage(page, numPages, WriteOptions(compress ? Compression::LZW : Compression::None), saveAsARGB);
+        }
+
+        /**
+         * Saves the image data as a page of a multi-page file with the given layout and compression
+         * and starts the next page
+         * Whether a BigTIFF is written is decided on the first page from the size of all pages
+         * The page number tag is left out for more than 65535 pages
+         */
+        void savePage(unsigned page, unsigned numPages, const WriteOptions& options, bool saveAsARGB = true);
+
+        /**
+         * Returns the number of pages (directories) of a file opened for reading
+         */
+        unsigned getNumPages() const
+        {
+            assert(m_isReadable);
+            return TIFFNumberOfDirectories(m_handle.get());
+        }
+
+        /**
+         * Switches to another page of a multi-page file opened for reading
+         *
+         * @param page Index of the page
+         * @param loadData True if the page data should be loaded or only its memory allocated
+         */
+        void setPage(unsigned page, bool loadData = true);
 
         /**
          * Saves the image data to file at the given path and opens it for writing
@@ -186,7 +313,15 @@ namespace tiffWriter
          * @param compress Whether to compress the file or not
          * @param saveAsARGB Whether to save ARGB files as ARGB (true) or RGB only (ignored for monochromatic files)
          */
-        void saveTo(const std::string& filePath, bool compress = true, bool saveAsARGB = true);
+        void saveTo(const std::string& filePath, bool compress = true, bool saveAsARGB = true)
+        {
+            saveTo(filePath, WriteOptions(compress ? Compression::LZW : Compression::None), saveAsARGB);
+        }
+
+        /**
+         * Saves the image data to file at the given path with the given layout and compression and opens it for writing
+         */
+        void saveTo(const std::string& filePath, const WriteOptions& options, bool saveAsARGB = true);
 
         /**
          * Returns whether the image is open and its data can be read
@@ -197,6 +332,47 @@ namespace tiffWriter
             return (m_handle != nullptr);
         }
 
+        /**
+         * Returns true if the file is opened for writing a BigTIFF (see WriteOptions::bigTiff)
+         */
+        bool isBigTiff() const
+        {
+            return m_isBigTiff;
+        }
+
+        /**
+         * Returns true if the pixel data is mapped from the file instead of read into memory
+         * This is done when loading uncompressed files whose strips are stored contiguously in the memory layout of
+         * the pixels (e.g. saved uncompressed by this class) and no previously allocated memory has to be reused.
+         * The mapping is copy-on-write: Changes are allowed but never written to the file.
+         * Pixels are only read from the file when first accessed, so if another process rewrites the file while it is
+         * mapped, pixels not accessed yet show the new content, and if it truncates the file, accessing them raises
+         * SIGBUS. Disable the mapping with \ref setMapping for files that may change while the image is open.
+         */
+        bool isMapped() const
+        {
+            return m_mappedFile.isOpen();
+        }
+
+        /**
+         * Sets whether uncompressed files may be mapped instead of read into memory (see \ref isMapped)
+         * Takes effect when the data is loaded next, so to never map a file, disable it before opening the file.
+         * Disabling it copies already mapped data into memory.
+         *
+         * @param enable True to allow mapping (default)
+         */
+        void setMapping(bool enable)
+        {
+            m_useMapping = enable;
+            if(!enable)
+                releaseMapping(true);
+        }
+
+        bool isMappingEnabled() const
+        {
+            return m_useMapping;
+        }
+
         unsigned getWidth() const
         {
             assert(isOpen() || m_data);
@@ -209,6 +385,49 @@ namespace tiffWriter
             return m_height;
         }
 
+        /**
+         * Sets the number of threads used to decode compressed files. Each thread uses its own file handle
+         * and decodes a part of the strips or tiles
+         *
+         * @param numThreads Number of threads, 0 for all hardware threads (default)
+         */
+        void setNumThreads(unsigned numThreads)
+        {
+            m_numThreads = numThreads;
+        }
+
+        unsigned getNumThreads() const
+        {
+            return m_numThreads;
+        }
+
+        /**
+         * Returns the width of the whole image in the file, which differs from \ref getWidth() if only a region is read
+         */
+        unsigned getFileWidth() const
+        {
+            assert(m_isReadable);
+            return m_fileWidth;
+        }
+
+        /**
+         * Returns the height of the whole image in the file, which differs from \ref getHeight() if only a region is read
+         */
+        unsigned getFileHeight() const
+        {
+            assert(m_isReadable);
+            return m_fileHeight;
+        }
+
+        /**
+         * Reads the extents of the (first page of the) image at filePath without allocating memory for its data
+         *
+         * @param filePath Path to the image
+         * @param width Set to the width of the image in the file
+         * @param height Set to the height of the image in the file
+         */
+        static void readFileExtents(const std::string& filePath, unsigned& width, unsigned& height);
+
         /**
          * Returns true, if the origin of the image is at the top (left)
          * False if it is at the bottom (left)
@@ -16,9 +16,19 @@
  
 #include "tiffWriter/exceptions.hpp"
 #include "tiffWriter/converters.hpp"
+#include "tiffWriter/rowConverters.hpp"
+#include "tiffWriter/pyramid.hpp"
 #include "tiffWriter/AllocatorWrapper.hpp"
 #include "tiffWriter/uvector.hpp"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace tiffWriter {
 
@@ -31,6 +41,20 @@ namespace tiffWriter {
         if(!m_handle)
             throw std::runtime_error("Could not open "+filePath);
         m_filepath = filePath;
+        m_isBigTiff = std::string(mode).find('8') != std::string::npos;
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::prepareWrite(const WriteOptions& options, uint64_t fileDataSize)
+    {
+        const bool needBigTiff = isBigTiffRequired(options, fileDataSize);
+        // If we already wrote to the image we need to reopen it to be able to modify the tags
+        // Before that the (still empty) file can be reopened in the required format
+        if(m_dataWritten || needBigTiff != m_isBigTiff){
+            openHandle(m_filepath, needBigTiff ? "w8" : "w");
+            m_isWriteable = true;
+        }
     }
 
     template< ImageFormat T_imgFormat, class T_Allocator >
@@ -52,18 +76,101 @@ namespace tiffWriter {
         closeHandle();
         openHandle(filePath, "r");
         m_isReadable = true;
+        m_regionX = m_regionY = m_regionWidth = m_regionHeight = 0;
+        readExtents();
+        if(bLoadData)
+            loadData();
+        else
+            allocData();
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::openRegion(const std::string& filePath, unsigned x, unsigned y, unsigned w, unsigned h, bool bLoadData)
+    {
+        if(!w || !h)
+            throw std::runtime_error("Region must not be empty");
+        closeHandle();
+        openHandle(filePath, "r");
+        m_isReadable = true;
+        m_regionX = x; m_regionY = y;
+        m_regionWidth = w; m_regionHeight = h;
+        readExtents();
+        if(bLoadData)
+            loadData();
+        else
+            allocData();
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::readRegionTo(const std::string& filePath, unsigned x, unsigned y, unsigned w, unsigned h,
+            Pixel* dst, size_t rowStride)
+    {
+        if(!w || !h)
+            throw std::runtime_error("Region must not be empty");
+        // The data is decoded into dst, so no buffer is kept
+        close();
+        openHandle(filePath, "r");
+        m_isReadable = true;
+        m_regionX = x; m_regionY = y;
+        m_regionWidth = w; m_regionHeight = h;
+        readExtents();
+        loadTo(dst, rowStride);
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::setPage(unsigned page, bool bLoadData)
+    {
+        if(!m_isReadable)
+            throw std::runtime_error("Cannot change the page of a file that is not opened for reading");
+        if(!TIFFSetDirectory(m_handle.get(), page))
+            throw std::runtime_error("Could not read page " + std::to_string(page) + " of " + m_filepath);
+        readExtents();
+        if(bLoadData)
+            loadData();
+        else
+            allocData();
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::readExtents()
+    {
         uint32 w, h;
         if(!TIFFGetField(m_handle.get(), TIFFTAG_IMAGEWIDTH, &w))
             throw InfoMissingException("Width");
         if(!TIFFGetField(m_handle.get(), TIFFTAG_IMAGELENGTH, &h))
             throw InfoMissingException("Height");
+        m_fileWidth = w; m_fileHeight = h;
+        if(m_regionWidth)
+        {
+            // Checked without adding to the offsets which could wrap around
+            if(m_regionX >= w || m_regionY >= h || m_regionWidth > w - m_regionX || m_regionHeight > h - m_regionY)
+                throw std::runtime_error("Region exceeds the image extents of " + m_filepath);
+            w = m_regionWidth;
+            h = m_regionHeight;
+        }
         if(w*h != m_width*m_height)
-            m_data.reset(); // Reset data only if we need a differently sized chunk
+        {
+            // Reset data only if we need a differently sized chunk
+            releaseMapping();
+            m_data.reset();
+        }
         m_width = w; m_height = h;
-        if(bLoadData)
-            loadData();
-        else
-            allocData();
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::readFileExtents(const std::string& filePath, unsigned& width, unsigned& height)
+    {
+        Image img;
+        img.openHandle(filePath, "r");
+        img.m_isReadable = true;
+        img.readExtents();
+        width = img.m_fileWidth;
+        height = img.m_fileHeight;
     }
 
     template< ImageFormat T_imgFormat, class T_Allocator >
@@ -74,6 +181,7 @@ namespace tiffWriter {
         openHandle(filePath, "w");
         m_isWriteable = true;
         m_width = w; m_height = h;
+        m_regionX = m_regionY = m_regionWidth = m_regionHeight = 0;
         originIsAtTop = bIsOriginAtTop;
         allocData();
     }
@@ -83,21 +191,207 @@ namespace tiffWriter {
     Image< T_imgFormat, T_Allocator >::close()
     {
         closeHandle();
+        releaseMapping();
         m_data.reset();
     }
 
-    template< typename T_Data, uint16_t T_inStride = 1, uint16_t T_outStride = 1 >
+    /**
+     * Reads the strips or tiles of the current directory that intersect a region of the image
+     * and passes the part of each row inside the region to a functor
+     */
+    class ChunkReader
+    {
+        TIFF* m_handle;
+        bool m_isTiled;
+        /** Extents of a strip or tile */
+        uint32 m_chunkWidth, m_chunkHeight;
+        /** Bytes of one row of a strip or tile */
+        size_t m_rowSize;
+        size_t m_bufferSize;
+
+    public:
+        explicit ChunkReader(TIFF* handle): m_handle(handle), m_isTiled(TIFFIsTiled(handle) != 0)
+        {
+            uint32 w, h;
+            if(!TIFFGetField(m_handle, TIFFTAG_IMAGEWIDTH, &w))
+                throw InfoMissingException("Width");
+            if(!TIFFGetField(m_handle, TIFFTAG_IMAGELENGTH, &h))
+                throw InfoMissingException("Height");
+            tmsize_t rowSize, bufferSize;
+            if(m_isTiled)
+            {
+                if(!TIFFGetField(m_handle, TIFFTAG_TILEWIDTH, &m_chunkWidth) || !m_chunkWidth)
+                    throw InfoMissingException("Tile width");
+                if(!TIFFGetField(m_handle, TIFFTAG_TILELENGTH, &m_chunkHeight) || !m_chunkHeight)
+                    throw InfoMissingException("Tile length");
+                rowSize = TIFFTileRowSize(m_handle);
+                bufferSize = TIFFTileSize(m_handle);
+            }else
+            {
+                m_chunkWidth = w;
+                if(!TIFFGetField(m_handle, TIFFTAG_ROWSPERSTRIP, &m_chunkHeight) || !m_chunkHeight || m_chunkHeight > h)
+                    m_chunkHeight = h;
+                rowSize = TIFFScanlineSize(m_handle);
+                bufferSize = TIFFStripSize(m_handle);
+            }
+            if(rowSize <= 0 || bufferSize <= 0)
+                throw FormatException("Invalid strip or tile size");
+            m_rowSize = rowSize;
+            m_bufferSize = bufferSize;
+        }
+
+        /**
+         * Returns the number of rows of a strip or tile
+         */
+        unsigned getChunkHeight() const
+        {
+            return m_chunkHeight;
+        }
+
+        /**
+         * Returns the size in bytes of the buffer required to decode one strip or tile
+         */
+        size_t getBufferSize() const
+        {
+            return m_bufferSize;
+        }
+
+        /**
+         * Decodes all strips or tiles intersecting the region
+         *
+         * @param x0 Offset of the region in x-direction
+         * @param y0 Offset of the region in y-direction
+         * @param w Width of the region
+         * @param h Height of the region
+         * @param bytesPerPixel Size of one pixel in the file
+         * @param buffer Memory of at least \ref getBufferSize() bytes
+         * @param func Functor called as func(srcRow, y, x, numPixels) with the position relative to the region
+         */
+        template< typename T_Func >
+        void
+        operator()(unsigned x0, unsigned y0, unsigned w, unsigned h, unsigned bytesPerPixel, char* buffer, T_Func&& func) const
+        {
+            const unsigned xEnd = x0 + w;
+            const unsigned yEnd = y0 + h;
+            for(unsigned chunkY = y0 - y0 % m_chunkHeight; chunkY < yEnd; chunkY += m_chunkHeight)
+            {
+                for(unsigned chunkX = x0 - x0 % m_chunkWidth; chunkX < xEnd; chunkX += m_chunkWidth)
+                {
+                    tmsize_t numRead;
+                    if(m_isTiled)
+                        numRead = TIFFReadEncodedTile(m_handle, TIFFComputeTile(m_handle, chunkX, chunkY, 0, 0), buffer, -1);
+                    else
+                        numRead = TIFFReadEncodedStrip(m_handle, TIFFComputeStrip(m_handle, chunkY, 0), buffer, -1);
+                    if(numRead < 0)
+                        throw std::runtime_error(m_isTiled ? "Failed reading tile" : "Failed reading strip");
+                    const unsigned xBegin = std::max(chunkX, x0);
+                    const unsigned numPixels = std::min(chunkX + m_chunkWidth, xEnd) - xBegin;
+                    const unsigned rowEnd = std::min(chunkY + m_chunkHeight, yEnd);
+                    for(unsigned y = std::max(chunkY, y0); y < rowEnd; ++y)
+                    {
+                        const char* src = buffer + (y - chunkY) * m_rowSize + (xBegin - chunkX) * bytesPerPixel;
+                        func(src, y - y0, xBegin - x0, numPixels);
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * Decodes a region of the current directory, optionally in parallel:
+     * The rows of strips or tiles are partitioned across threads, each with its own file handle and decode buffer
+     */
+    template< class T_Allocator >
+    struct RegionReader
+    {
+        TIFF* m_handle;
+        const std::string& m_filePath;
+        unsigned m_x0, m_y0, m_width, m_height;
+        unsigned m_numThreads;
+
+        RegionReader(TIFF* handle, const std::string& filePath, unsigned x0, unsigned y0, unsigned w, unsigned h, unsigned numThreads):
+            m_handle(handle), m_filePath(filePath), m_x0(x0), m_y0(y0), m_width(w), m_height(h), m_numThreads(numThreads){}
+
+        /**
+         * Calls func(srcRow, y, x, numPixels) for each row segment of the region (concurrently for different rows)
+         */
+        template< typename T_Func >
+        void
+        operator()(unsigned bytesPerPixel, T_Func&& func) const
+        {
+            const unsigned chunkHeight = ChunkReader(m_handle).getChunkHeight();
+            const unsigned firstChunk = m_y0 / chunkHeight;
+            const unsigned numChunks = (m_y0 + m_height - 1) / chunkHeight - firstChunk + 1;
+            const unsigned numThreads = std::max(1u, std::min(m_numThreads, numChunks));
+            // Reads the rows of the chunks [chunkBegin, chunkEnd)
+            auto readChunks = [&](TIFF* handle, unsigned chunkBegin, unsigned chunkEnd)
+            {
+                ChunkReader reader(handle);
+                ao::uvector< char, AllocatorWrapper<char, T_Allocator> > buffer(reader.getBufferSize());
+                const unsigned yBegin = std::max((firstChunk + chunkBegin) * chunkHeight, m_y0);
+                const unsigned yEnd = std::min((firstChunk + chunkEnd) * chunkHeight, m_y0 + m_height);
+                reader(m_x0, yBegin, m_width, yEnd - yBegin, bytesPerPixel, buffer.data(),
+                        [&](const char* src, unsigned y, unsigned x, unsigned numPixels)
+                        {
+                            func(src, y + yBegin - m_y0, x, numPixels);
+                        });
+            };
+            if(numThreads == 1)
+            {
+                readChunks(m_handle, 0, numChunks);
+                return;
+            }
+            const tdir_t directory = TIFFCurrentDirectory(m_handle);
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            std::vector<std::thread> threads;
+            for(unsigned i = 1; i < numThreads; ++i)
+            {
+                threads.emplace_back([&, i]
+                {
+                    try
+                    {
+                        std::unique_ptr<TIFF, void(*)(TIFF*)> handle(TIFFOpen(m_filePath.c_str(), "r"), TIFFClose);
+                        if(!handle)
+                            throw std::runtime_error("Could not open " + m_filePath);
+                        if(!TIFFSetDirectory(handle.get(), directory))
+                            throw std::runtime_error("Could not read page " + std::to_string(directory) + " of " + m_filePath);
+                        readChunks(handle.get(), numChunks * i / numThreads, numChunks * (i + 1) / numThreads);
+                    }catch(...)
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if(!error)
+                            error = std::current_exception();
+                    }
+                });
+            }
+            try
+            {
+                readChunks(m_handle, 0, numChunks / numThreads);
+            }catch(...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error)
+                    error = std::current_exception();
+            }
+            for(std::thread& thread: threads)
+                thread.join();
+            if(error)
+                std::rethrow_exception(error);
+        }
+    };
+
+    template< typename T_Data, class T_Reader, uint16_t T_inStride = 1, uint16_t T_outStride = 1 >
     struct ReadTiff{
         static constexpr uint16_t inStride = T_inStride;
         static constexpr uint16_t outStride = T_outStride;
 
-        TIFF* m_handle;
-        unsigned m_width, m_height;
+        const T_Reader& m_reader;
+        size_t m_rowStride;
         T_Data* m_data;
-        char* m_tmp;
 
-        ReadTiff(TIFF* handle, unsigned w, unsigned h, T_Data* data, char* tmp):
-            m_handle(handle), m_width(w), m_height(h), m_data(data), m_tmp(tmp){}
+        ReadTiff(const T_Reader& reader, size_t rowStride, T_Data* data):
+            m_reader(reader), m_rowStride(rowStride), m_data(data){}
 
         template< typename T >
         void
@@ -116,26 +410,28 @@ namespace tiffWriter {
         template<typename T_Func>
         void operator()(T_Func func) {
             using SrcType = typename T_Func::Src;
-            SrcType* srcChannels = reinterpret_cast<SrcType*>(m_tmp);
-            for (unsigned y = 0; y < m_height; y++) {
-                if(!TIFFReadScanline(m_handle, m_tmp, y))
-                    throw std::runtime_error("Failed reading scanline\n");
-                for (unsigned x = 0; x < m_width; x++) {
-                    assign(m_data[(y*m_width + x)*outStride], func(srcChannels[x*inStride]));
-                }
-            }
+            m_reader(sizeof(SrcType) * inStride,
+                    [&](const char* src, unsigned y, unsigned x0, unsigned numPixels)
+                    {
+                        const SrcType* srcChannels = reinterpret_cast<const SrcType*>(src);
+                        T_Data* dst = &m_data[(y*m_rowStride + x0)*outStride];
+                        unsigned x = ConvertRow<T_Func>::apply(srcChannels, dst, numPixels);
+                        for (; x < numPixels; x++) {
+                            assign(dst[x*outStride], func(srcChannels[x*inStride]));
+                        }
+                    });
         }
     };
 
     template< ImageFormat T_imgFormat, class T_Allocator >
-    template< uint16_t T_numChannels, bool T_minIsBlack >
+    template< uint16_t T_numChannels, bool T_minIsBlack, class T_Reader >
     void
-    Image< T_imgFormat, T_Allocator >::convert(char* tmp)
+    Image< T_imgFormat, T_Allocator >::convert(const T_Reader& reader, DataType* dst, size_t rowStride)
     {
         static constexpr uint16_t numChannelsSrc = T_numChannels;
         static constexpr uint16_t numChannelsDest = SamplesPerPixel<T_imgFormat>::value;
         static constexpr bool minIsBlack = T_minIsBlack;
-        ReadTiff<ChannelType, numChannelsSrc, numChannelsDest > read(m_handle.get(), m_width, m_height, reinterpret_cast<ChannelType*>(m_data.get()), tmp);
+        ReadTiff<ChannelType, T_Reader, numChannelsSrc, numChannelsDest > read(reader, rowStride, reinterpret_cast<ChannelType*>(dst));
         //Mono pictures
         if(tiffSampleFormat == SAMPLEFORMAT_UINT && bitsPerSample == 8)
             read(Convert<uint8_t, ChannelType, numChannelsSrc, numChannelsDest, minIsBlack>());
@@ -149,6 +445,8 @@ namespace tiffWriter {
             read(Convert<int16_t, ChannelType, numChannelsSrc, numChannelsDest, minIsBlack>());
         else if(tiffSampleFormat == SAMPLEFORMAT_INT && bitsPerSample == 32)
             read(Convert<int32_t, ChannelType, numChannelsSrc, numChannelsDest, minIsBlack>());
+        else if(tiffSampleFormat == SAMPLEFORMAT_IEEEFP && bitsPerSample == 16)
+            read(Convert<Half, ChannelType, numChannelsSrc, numChannelsDest, minIsBlack>());
         else if(tiffSampleFormat == SAMPLEFORMAT_IEEEFP && bitsPerSample == 32)
             read(Convert<float, ChannelType, numChannelsSrc, numChannelsDest, minIsBlack>());
         else if(tiffSampleFormat == SAMPLEFORMAT_IEEEFP && bitsPerSample == 64)
@@ -161,6 +459,8 @@ namespace tiffWriter {
     void
     Image< T_imgFormat, T_Allocator >::allocData()
     {
+        // Mapped data belongs to the file, so it is never reused as a buffer
+        releaseMapping();
         if(m_data)
             return;
         DataType* p;
@@ -170,6 +470,75 @@ namespace tiffWriter {
         m_data.reset(p);
     }
 
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    bool
+    Image< T_imgFormat, T_Allocator >::mapData()
+    {
+#if defined(__unix__)
+        TIFF* handle = m_handle.get();
+        // Only complete rows of pixels in their memory layout can be used in place
+        if(m_regionX || m_fileWidth != m_width || TIFFIsTiled(handle) || TIFFIsByteSwapped(handle) ||
+                needConversion<T_imgFormat>(tiffSampleFormat, samplesPerPixel, bitsPerSample))
+            return false;
+        uint16 compression;
+        if(!TIFFGetFieldDefaulted(handle, TIFFTAG_COMPRESSION, &compression) || compression != COMPRESSION_NONE)
+            return false;
+        toff_t* offsets;
+        toff_t* byteCounts;
+        if(!TIFFGetField(handle, TIFFTAG_STRIPOFFSETS, &offsets) || !TIFFGetField(handle, TIFFTAG_STRIPBYTECOUNTS, &byteCounts))
+            return false;
+        // The strips must follow each other without gaps
+        const uint32 numStrips = TIFFNumberOfStrips(handle);
+        uint64_t stripsEnd = offsets[0] + byteCounts[0];
+        for(uint32 i = 1; i < numStrips; ++i)
+        {
+            if(offsets[i] != stripsEnd)
+                return false;
+            stripsEnd += byteCounts[i];
+        }
+        const uint64_t rowSize = uint64_t(m_width) * sizeof(DataType);
+        const uint64_t start = offsets[0] + m_regionY * rowSize;
+        const uint64_t end = start + m_height * rowSize;
+        if(end > stripsEnd || start % alignof(DataType))
+            return false;
+        try
+        {
+            m_mappedFile.open(m_filepath);
+        }catch(const std::runtime_error&)
+        {
+            // Read the data instead
+            return false;
+        }
+        if(end > m_mappedFile.getSize())
+        {
+            m_mappedFile.close();
+            return false;
+        }
+        m_data = DataPtr(reinterpret_cast<DataType*>(m_mappedFile.getData() + start), &keepBuffer);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::releaseMapping(bool keepValues)
+    {
+        if(!m_mappedFile.isOpen())
+            return;
+        DataType* p = nullptr;
+        if(keepValues)
+        {
+            Allocator().malloc(p, getDataSize());
+            if(!p)
+                throw std::runtime_error("Out of memory");
+            std::copy_n(m_data.get(), size_t(m_width) * m_height, p);
+        }
+        m_data = DataPtr(p, &freeBuffer);
+        m_mappedFile.close();
+    }
+
     template< ImageFormat T_imgFormat, class T_Allocator >
     void
     Image< T_imgFormat, T_Allocator >::load()
@@ -179,6 +548,18 @@ namespace tiffWriter {
         loadData();
     }
 
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::loadTo(Pixel* dst, size_t rowStride)
+    {
+        if(!m_isReadable)
+            throw std::runtime_error("Cannot load file that is not opened for reading");
+        if(rowStride < m_width)
+            throw std::runtime_error("Row stride must not be smaller than the width");
+        readFormat();
+        loadData(dst, rowStride);
+    }
+
     template< ImageFormat T_imgFormat, class T_Allocator >
     template< typename T>
     void
@@ -190,30 +571,53 @@ namespace tiffWriter {
 
     template< ImageFormat T_imgFormat, class T_Allocator >
     void
-    Image< T_imgFormat, T_Allocator >::saveTo(const std::string& filePath, bool compress, bool saveAsARGB)
+    Image< T_imgFormat, T_Allocator >::saveTo(const std::string& filePath, const WriteOptions& options, bool saveAsARGB)
     {
-        openHandle(filePath, "w");
+        // The file might be the one that is mapped
+        releaseMapping(true);
+        openHandle(filePath, isBigTiffRequired(options, getDataSize()) ? "w8" : "w");
         m_isWriteable = true;
-        save(compress, saveAsARGB);
+        save(options, saveAsARGB);
     }
 
+    /**
+     * Converts the pixels of the image to the format written to the file
+     */
     template< ImageFormat T_imgFormat, bool T_EnableRGB = (T_imgFormat == ImageFormat::ARGB) >
     struct SavePolicy
     {
-        static constexpr ImageFormat imgFormat = T_imgFormat;
+        using DataType = typename PixelType<T_imgFormat>::type;
+
+        /** Whether the pixels are written as half floats */
+        static bool
+        isHalf(const WriteOptions& options)
+        {
+            return std::is_floating_point<DataType>::value && options.halfFloat;
+        }
+
+        static uint16
+        getBitsPerSample(const WriteOptions& options)
+        {
+            return isHalf(options) ? 16 : BitsPerSample<T_imgFormat>::value;
+        }
+
+        static unsigned
+        getBytesPerPixel(const WriteOptions& options, bool /*saveAsARGB*/)
+        {
+            return isHalf(options) ? sizeof(Half) : sizeof(DataType);
+        }
 
-        template<typename T, typename Allocator>
         static void
-        save(bool /*saveAsRGB*/, TIFF* handle, T* data, const Allocator& /*alloc*/, unsigned w, unsigned h)
+        copyPixels(const WriteOptions& options, bool /*saveAsARGB*/, const DataType* src, unsigned numPixels, char* dst)
         {
-            assert( TIFFScanlineSize(handle) >= 0 );
-            if( sizeof(T)*w != (unsigned) TIFFScanlineSize(handle) )
-                throw FormatException("Scanline size is unexpected");
-            for (unsigned y = 0; y < h; y++)
+            if(!isHalf(options))
             {
-                if(!TIFFWriteScanline(handle, &data[y*w], y))
-                    throw std::runtime_error("Failed writing scanline");
+                std::copy_n(reinterpret_cast<const char*>(src), numPixels * sizeof(DataType), dst);
+                return;
             }
+            Half* halfs = reinterpret_cast<Half*>(dst);
+            for(unsigned x = packHalf(src, halfs, numPixels); x < numPixels; x++)
+                halfs[x] = Half(static_cast<float>(src[x]));
         }
     };
 
@@ -221,83 +625,532 @@ namespace tiffWriter {
     struct SavePolicy< ImageFormat::ARGB, true >
     {
         static constexpr ImageFormat imgFormat = ImageFormat::ARGB;
+        using DataType = typename PixelType<imgFormat>::type;
         using ChannelType = typename PixelType<imgFormat>::ChannelType;
 
-        template<typename T, typename Allocator>
+        static uint16
+        getBitsPerSample(const WriteOptions& /*options*/)
+        {
+            return BitsPerSample<imgFormat>::value;
+        }
+
+        static unsigned
+        getBytesPerPixel(const WriteOptions& /*options*/, bool saveAsARGB)
+        {
+            return saveAsARGB ? sizeof(DataType) : 3 * sizeof(ChannelType);
+        }
+
         static void
-        save(bool saveAsRGB, TIFF* handle, T* data, const Allocator& alloc, unsigned w, unsigned h)
+        copyPixels(const WriteOptions& options, bool saveAsARGB, const DataType* src, unsigned numPixels, char* dst)
         {
-            if(!saveAsRGB)
+            if(saveAsARGB)
             {
-                SavePolicy< imgFormat, false >::save(false, handle, data, alloc, w, h);
+                SavePolicy< imgFormat, false >::copyPixels(options, true, src, numPixels, dst);
                 return;
             }
             // Convert from ARGB to RGB
-            if(w * sizeof(ChannelType) * 3 != TIFFScanlineSize(handle))
-                throw FormatException("Scanline size is unexpected");
+            ChannelType* channels = reinterpret_cast<ChannelType*>(dst);
+            for(unsigned x = packRGB(src, channels, numPixels); x < numPixels; x++)
+            {
+                channels[x*3] = static_cast<ChannelType>(TIFFGetR(src[x]));
+                channels[x*3+1] = static_cast<ChannelType>(TIFFGetG(src[x]));
+                channels[x*3+2] = static_cast<ChannelType>(TIFFGetB(src[x]));
+            }
+        }
+    };
+
+    /**
+     * Sets the compression and predictor tags
+     */
+    inline void
+    setCompressionTags(TIFF* handle, const WriteOptions& options, uint16 sampleFormat)
+    {
+        uint16 compression = COMPRESSION_NONE;
+        switch(options.compression)
+        {
+        case Compression::None:
+            compression = COMPRESSION_NONE;
+            break;
+        case Compression::LZW:
+            compression = COMPRESSION_LZW;
+            break;
+        case Compression::Deflate:
+            compression = COMPRESSION_ADOBE_DEFLATE;
+            break;
+        case Compression::ZSTD:
+#ifdef COMPRESSION_ZSTD
+            compression = COMPRESSION_ZSTD;
+            break;
+#else
+            throw FormatException("ZSTD compression requires libtiff 4.0.10 or newer");
+#endif
+        }
+        if(!TIFFIsCODECConfigured(compression))
+            throw FormatException("Compression is not supported by libtiff: " + std::to_string(compression));
+        if(!TIFFSetField(handle, TIFFTAG_COMPRESSION, compression))
+            throw InfoWriteException(std::to_string(TIFFTAG_COMPRESSION));
+        if(options.level > 0 && (options.compression == Compression::Deflate || options.compression == Compression::ZSTD))
+        {
+            uint32 levelTag = TIFFTAG_ZIPQUALITY;
+#ifdef COMPRESSION_ZSTD
+            if(options.compression == Compression::ZSTD)
+                levelTag = TIFFTAG_ZSTD_LEVEL;
+#endif
+            if(!TIFFSetField(handle, levelTag, options.level))
+                throw InfoWriteException(std::to_string(levelTag));
+        }
+        if(compression == COMPRESSION_NONE || options.predictor == Predictor::None)
+            return;
+        if(options.predictor == Predictor::FloatingPoint && sampleFormat != SAMPLEFORMAT_IEEEFP)
+            throw FormatException("Floating point predictor requires floating point data");
+        const uint16 predictor = (options.predictor == Predictor::Horizontal) ? PREDICTOR_HORIZONTAL : PREDICTOR_FLOATINGPOINT;
+        if(!TIFFSetField(handle, TIFFTAG_PREDICTOR, predictor))
+            throw InfoWriteException(std::to_string(TIFFTAG_PREDICTOR));
+    }
+
+    /**
+     * Growing in-memory file for TIFFClientOpen
+     */
+    struct MemoryFile
+    {
+        std::vector<char> data;
+        size_t pos = 0;
+
+        static tmsize_t
+        read(thandle_t handle, void* buf, tmsize_t size)
+        {
+            MemoryFile& file = *static_cast<MemoryFile*>(handle);
+            const size_t numBytes = std::min<size_t>(size, file.data.size() - std::min(file.pos, file.data.size()));
+            std::copy_n(file.data.data() + file.pos, numBytes, static_cast<char*>(buf));
+            file.pos += numBytes;
+            return numBytes;
+        }
+
+        static tmsize_t
+        write(thandle_t handle, void* buf, tmsize_t size)
+        {
+            MemoryFile& file = *static_cast<MemoryFile*>(handle);
+            if(file.pos + size > file.data.size())
+                file.data.resize(file.pos + size);
+            std::copy_n(static_cast<const char*>(buf), size, file.data.data() + file.pos);
+            file.pos += size;
+            return size;
+        }
+
+        static toff_t
+        seek(thandle_t handle, toff_t offset, int whence)
+        {
+            MemoryFile& file = *static_cast<MemoryFile*>(handle);
+            if(whence == SEEK_CUR)
+                file.pos += offset;
+            else if(whence == SEEK_END)
+                file.pos = file.data.size() + offset;
+            else
+                file.pos = offset;
+            return file.pos;
+        }
+
+        static int
+        close(thandle_t)
+        {
+            return 0;
+        }
+
+        static toff_t
+        size(thandle_t handle)
+        {
+            return static_cast<MemoryFile*>(handle)->data.size();
+        }
+
+        static int
+        map(thandle_t, void**, toff_t*)
+        {
+            return 0;
+        }
+
+        static void
+        unmap(thandle_t, void*, toff_t)
+        {}
+    };
+
+    /**
+     * Writes the image data as strips or tiles
+     * Compressed strips/tiles can be encoded in parallel: Worker threads encode each one into an
+     * in-memory TIFF with the same layout and the encoded data is written to the file in order
+     */
+    class ChunkWriter
+    {
+        TIFF* m_handle;
+        WriteOptions m_options;
+        unsigned m_width, m_height, m_bytesPerPixel;
+        bool m_isTiled;
+        /** Extents of a strip or tile */
+        uint32 m_chunkWidth, m_chunkHeight;
+        unsigned m_numChunksX, m_numChunksY;
+        /** Tags describing the pixel format, copied to the in-memory files */
+        static constexpr unsigned numFormatTags = 5;
+        std::array<uint32, numFormatTags> m_formatTags;
+        std::array<uint16, numFormatTags> m_formatValues;
+        uint16 m_sampleFormat;
+
+        /**
+         * Fills the buffer with the pixels of a chunk and returns the number of rows
+         */
+        template< typename T_Fill >
+        unsigned
+        fillChunk(size_t idx, char* buffer, T_Fill& fill) const
+        {
+            const unsigned chunkX = (idx % m_numChunksX) * m_chunkWidth;
+            const unsigned chunkY = (idx / m_numChunksX) * m_chunkHeight;
+            const unsigned numPixels = std::min(m_chunkWidth, m_width - chunkX);
+            const unsigned numRows = std::min(m_chunkHeight, m_height - chunkY);
+            const size_t rowSize = size_t(m_chunkWidth) * m_bytesPerPixel;
+            // Tiles at the border are padded
+            if(m_isTiled && (numPixels < m_chunkWidth || numRows < m_chunkHeight))
+                std::fill_n(buffer, rowSize * m_chunkHeight, 0);
+            for(unsigned y = 0; y < numRows; ++y)
+                fill(buffer + y * rowSize, chunkY + y, chunkX, numPixels);
+            return m_isTiled ? m_chunkHeight : numRows;
+        }
+
+        /**
+         * Returns the encoded data of a chunk
+         */
+        std::vector<char>
+        encode(char* buffer, unsigned numRows) const
+        {
+            MemoryFile file;
+            std::unique_ptr<TIFF, void(*)(TIFF*)> handle(
+                    TIFFClientOpen("memory", "w", &file,
+                            MemoryFile::read, MemoryFile::write, MemoryFile::seek, MemoryFile::close,
+                            MemoryFile::size, MemoryFile::map, MemoryFile::unmap),
+                    TIFFClose);
+            if(!handle)
+                throw std::runtime_error("Could not create in-memory TIFF");
+            for(unsigned i = 0; i < numFormatTags; ++i)
+            {
+                if(!TIFFSetField(handle.get(), m_formatTags[i], m_formatValues[i]))
+                    throw InfoWriteException(std::to_string(m_formatTags[i]));
+            }
+            TIFFSetField(handle.get(), TIFFTAG_IMAGEWIDTH, m_chunkWidth);
+            TIFFSetField(handle.get(), TIFFTAG_IMAGELENGTH, numRows);
+            if(m_isTiled)
+            {
+                TIFFSetField(handle.get(), TIFFTAG_TILEWIDTH, m_chunkWidth);
+                TIFFSetField(handle.get(), TIFFTAG_TILELENGTH, m_chunkHeight);
+            }else
+                TIFFSetField(handle.get(), TIFFTAG_ROWSPERSTRIP, numRows);
+            setCompressionTags(handle.get(), m_options, m_sampleFormat);
+            const tmsize_t size = tmsize_t(m_chunkWidth) * m_bytesPerPixel * numRows;
+            toff_t* offsets;
+            toff_t* byteCounts;
+            if(m_isTiled)
+            {
+                if(TIFFWriteEncodedTile(handle.get(), 0, buffer, size) < 0)
+                    throw std::runtime_error("Failed encoding tile");
+                TIFFGetField(handle.get(), TIFFTAG_TILEOFFSETS, &offsets);
+                TIFFGetField(handle.get(), TIFFTAG_TILEBYTECOUNTS, &byteCounts);
+            }else
+            {
+                if(TIFFWriteEncodedStrip(handle.get(), 0, buffer, size) < 0)
+                    throw std::runtime_error("Failed encoding strip");
+                TIFFGetField(handle.get(), TIFFTAG_STRIPOFFSETS, &offsets);
+                TIFFGetField(handle.get(), TIFFTAG_STRIPBYTECOUNTS, &byteCounts);
+            }
+            return std::vector<char>(file.data.begin() + offsets[0], file.data.begin() + offsets[0] + byteCounts[0]);
+        }
+
+        void
+        writeEncoded(size_t idx, char* buffer, unsigned numRows) const
+        {
+            const tmsize_t size = tmsize_t(m_chunkWidth) * m_bytesPerPixel * numRows;
+            if(m_isTiled ? TIFFWriteEncodedTile(m_handle, idx, buffer, size) < 0 : TIFFWriteEncodedStrip(m_handle, idx, buffer, size) < 0)
+                throw std::runtime_error(m_isTiled ? "Failed writing tile" : "Failed writing strip");
+        }
+
+        void
+        writeRaw(size_t idx, std::vector<char>& data) const
+        {
+            if(m_isTiled ? TIFFWriteRawTile(m_handle, idx, data.data(), data.size()) < 0 : TIFFWriteRawStrip(m_handle, idx, data.data(), data.size()) < 0)
+                throw std::runtime_error(m_isTiled ? "Failed writing tile" : "Failed writing strip");
+        }
+
+    public:
+        /**
+         * Creates the writer for a handle whose tags (including the layout) are already set
+         */
+        ChunkWriter(TIFF* handle, const WriteOptions& options, unsigned w, unsigned h, unsigned bytesPerPixel):
+            m_handle(handle), m_options(options), m_width(w), m_height(h), m_bytesPerPixel(bytesPerPixel),
+            m_isTiled(options.tileSize != 0)
+        {
+            if(m_isTiled)
+            {
+                m_chunkWidth = m_chunkHeight = options.tileSize;
+            }else
+            {
+                m_chunkWidth = w;
+                if(!TIFFGetField(m_handle, TIFFTAG_ROWSPERSTRIP, &m_chunkHeight) || !m_chunkHeight)
+                    throw InfoMissingException("Rows per strip");
+                m_chunkHeight = std::min(m_chunkHeight, h);
+            }
+            m_numChunksX = (w + m_chunkWidth - 1) / m_chunkWidth;
+            m_numChunksY = (h + m_chunkHeight - 1) / m_chunkHeight;
+            // Read here as the handle is used by the writing thread while encoding
+            m_formatTags = {{TIFFTAG_SAMPLESPERPIXEL, TIFFTAG_BITSPERSAMPLE, TIFFTAG_SAMPLEFORMAT, TIFFTAG_PHOTOMETRIC, TIFFTAG_PLANARCONFIG}};
+            for(unsigned i = 0; i < numFormatTags; ++i)
+            {
+                if(!TIFFGetField(m_handle, m_formatTags[i], &m_formatValues[i]))
+                    throw InfoMissingException(std::to_string(m_formatTags[i]));
+            }
+            m_sampleFormat = m_formatValues[2];
+        }
 
-            // Make sure memory is freed even in case of exceptions
-            auto tmpAlloc = wrapAllocator<ChannelType>(alloc);
-            ao::uvector< ChannelType, decltype(tmpAlloc) > tmpLine(TIFFScanlineSize(handle) / sizeof(ChannelType), tmpAlloc);
+        size_t
+        getNumChunks() const
+        {
+            return size_t(m_numChunksX) * m_numChunksY;
+        }
+
+        /**
+         * Writes all strips/tiles
+         *
+         * @param numThreads Number of threads encoding strips/tiles (besides the calling thread writing them)
+         * @param fill Functor called as fill(dstRow, y, x, numPixels) to get the pixels of a row segment in the file format
+         */
+        template< typename T_Fill >
+        void
+        operator()(unsigned numThreads, T_Fill&& fill) const
+        {
+            const size_t numChunks = getNumChunks();
+            const size_t bufferSize = size_t(m_chunkWidth) * m_chunkHeight * m_bytesPerPixel;
+            if(numThreads <= 1 || numChunks <= 1)
+            {
+                std::vector<char> buffer(bufferSize);
+                for(size_t i = 0; i < numChunks; ++i)
+                    writeEncoded(i, buffer.data(), fillChunk(i, buffer.data(), fill));
+                return;
+            }
+            // Limits the memory used by encoded chunks waiting to be written
+            const size_t maxInFlight = 4 * size_t(numThreads);
+            std::vector< std::vector<char> > encoded(numChunks);
+            std::vector<char> isReady(numChunks, 0);
+            size_t nextChunk = 0, numWritten = 0;
+            bool abort = false;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable cond;
+            auto setError = [&](std::exception_ptr e)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error = e;
+                abort = true;
+                cond.notify_all();
+            };
 
-            for (unsigned y = 0; y < h; y++)
+            std::vector<std::thread> threads;
+            for(unsigned i = 0; i < numThreads; ++i)
             {
-                auto* lineData = &data[y*w];
-                for(unsigned x = 0; x < w; x++)
+                threads.emplace_back([&]
                 {
-                    tmpLine[x*3] = static_cast<ChannelType>(TIFFGetR(lineData[x]));
-                    tmpLine[x*3+1] = static_cast<ChannelType>(TIFFGetG(lineData[x]));
-                    tmpLine[x*3+2] = static_cast<ChannelType>(TIFFGetB(lineData[x]));
+                    try
+                    {
+                        std::vector<char> buffer(bufferSize);
+                        std::unique_lock<std::mutex> lock(mutex);
+                        while(true)
+                        {
+                            cond.wait(lock, [&]{ return abort || nextChunk >= numChunks || nextChunk < numWritten + maxInFlight; });
+                            if(abort || nextChunk >= numChunks)
+                                return;
+                            const size_t idx = nextChunk++;
+                            lock.unlock();
+                            std::vector<char> data = encode(buffer.data(), fillChunk(idx, buffer.data(), fill));
+                            lock.lock();
+                            encoded[idx] = std::move(data);
+                            isReady[idx] = 1;
+                            cond.notify_all();
+                        }
+                    }catch(...)
+                    {
+                        setError(std::current_exception());
+                    }
+                });
+            }
+            // Write in order
+            try
+            {
+                for(size_t i = 0; i < numChunks; ++i)
+                {
+                    std::vector<char> data;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cond.wait(lock, [&]{ return abort || isReady[i]; });
+                        if(abort)
+                            break;
+                        data = std::move(encoded[i]);
+                    }
+                    writeRaw(i, data);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++numWritten;
+                    cond.notify_all();
                 }
-                if(!TIFFWriteScanline(handle, tmpLine.data(), y))
-                    throw std::runtime_error("Failed writing scanline");
+            }catch(...)
+            {
+                setError(std::current_exception());
             }
+            for(std::thread& thread: threads)
+                thread.join();
+            if(error)
+                std::rethrow_exception(error);
         }
     };
 
     template< ImageFormat T_imgFormat, class T_Allocator >
     void
-    Image< T_imgFormat, T_Allocator >::save(bool compress, bool saveAsARGB)
+    Image< T_imgFormat, T_Allocator >::save(const WriteOptions& options, bool saveAsARGB)
     {
         if(!m_isWriteable)
             throw std::runtime_error("Cannot save to a file that is not opened for writing");
-        // If we already wrote to the image we need to reopen it to be able to modify the tags
-        if(m_dataWritten){
-            openHandle(m_filepath, "w");
-            m_isWriteable = true;
+        const WriteOptions layout = getLayoutOptions(options);
+        prepareWrite(layout, getDataSize());
+        writeTags(layout, saveAsARGB, m_width, m_height);
+        writeData(layout, saveAsARGB, m_data.get(), m_width, m_height);
+        // Without a pyramid the directory is written on close
+        if(getNumPyramidLevels(m_width, m_height, layout))
+            writeDirectory(layout, saveAsARGB);
+        m_dataWritten = true;
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::savePage(unsigned page, unsigned numPages, const WriteOptions& options, bool saveAsARGB)
+    {
+        if(!m_isWriteable)
+            throw std::runtime_error("Cannot save to a file that is not opened for writing");
+        if(m_dataWritten)
+            throw std::runtime_error("Cannot add pages to a file saved as a single image");
+        const WriteOptions layout = getLayoutOptions(options);
+        if(page == 0)
+            prepareWrite(layout, uint64_t(getDataSize()) * numPages);
+        writeTags(layout, saveAsARGB, m_width, m_height);
+        checkedWrite(TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+        // The page number tag is limited to 16 bit and optional (readers count the directories)
+        if(numPages <= 0xFFFF && !TIFFSetField(m_handle.get(), TIFFTAG_PAGENUMBER, static_cast<uint16>(page), static_cast<uint16>(numPages)))
+            throw InfoWriteException(std::to_string(TIFFTAG_PAGENUMBER));
+        writeData(layout, saveAsARGB, m_data.get(), m_width, m_height);
+        // Finishes the page, following tags go to the next one
+        writeDirectory(layout, saveAsARGB);
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::writeDirectory(const WriteOptions& options, bool saveAsARGB)
+    {
+        const unsigned numLevels = getNumPyramidLevels(m_width, m_height, options);
+        std::vector< PyramidLevel<DataType> > levels;
+        if(numLevels)
+        {
+            unsigned numThreads = options.numThreads ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+            numThreads = std::min<size_t>(numThreads, std::max<size_t>(1, getDataSize() / minParallelSize));
+            levels = buildPyramid(m_data.get(), m_width, m_height, numLevels, numThreads);
+            // The offsets are filled in by libTIFF when the following directories (the levels) are written
+            std::vector<toff_t> subIFDOffsets(numLevels, 0);
+            if(!TIFFSetField(m_handle.get(), TIFFTAG_SUBIFD, static_cast<uint16>(numLevels), subIFDOffsets.data()))
+                throw InfoWriteException(std::to_string(TIFFTAG_SUBIFD));
         }
+        if(!TIFFWriteDirectory(m_handle.get()))
+            throw std::runtime_error("Failed writing directory");
+        for(const PyramidLevel<DataType>& level: levels)
+        {
+            writeTags(options, saveAsARGB, level.width, level.height);
+            checkedWrite(TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+            writeData(options, saveAsARGB, level.data.data(), level.width, level.height);
+            if(!TIFFWriteDirectory(m_handle.get()))
+                throw std::runtime_error("Failed writing pyramid level " + std::to_string(level.width) + "x" + std::to_string(level.height));
+        }
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::writeData(const WriteOptions& options, bool saveAsARGB, const DataType* data, unsigned width, unsigned height)
+    {
+        const unsigned bytesPerPixel = SavePolicy<imgFormat>::getBytesPerPixel(options, saveAsARGB);
+        ChunkWriter writer(m_handle.get(), options, width, height, bytesPerPixel);
+        unsigned numThreads = options.numThreads ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+        if(options.compression == Compression::None)
+            numThreads = 1;
+        else
+            numThreads = std::min<size_t>(numThreads, std::max<size_t>(1, size_t(width) * height * sizeof(DataType) / minParallelSize));
+        writer(numThreads, [data, width, &options, saveAsARGB](char* dst, unsigned y, unsigned x, unsigned numPixels)
+        {
+            SavePolicy<imgFormat>::copyPixels(options, saveAsARGB, &data[size_t(y)*width + x], numPixels, dst);
+        });
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::writeTags(const WriteOptions& options, bool saveAsARGB, unsigned width, unsigned height)
+    {
         if(imgFormat == ImageFormat::ARGB && !saveAsARGB)
             checkedWrite(TIFFTAG_SAMPLESPERPIXEL, 3); // Write as RGB
         else
             checkedWrite(TIFFTAG_SAMPLESPERPIXEL, SamplesPerPixel<imgFormat>::value);
-        checkedWrite(TIFFTAG_BITSPERSAMPLE, BitsPerSample<imgFormat>::value);
+        checkedWrite(TIFFTAG_BITSPERSAMPLE, SavePolicy<imgFormat>::getBitsPerSample(options));
         checkedWrite(TIFFTAG_SAMPLEFORMAT, PixelType<imgFormat>::tiffType);
-        checkedWrite(TIFFTAG_IMAGEWIDTH, m_width);
-        checkedWrite(TIFFTAG_IMAGELENGTH, m_height);
+        checkedWrite(TIFFTAG_IMAGEWIDTH, width);
+        checkedWrite(TIFFTAG_IMAGELENGTH, height);
         if(imgFormat == ImageFormat::ARGB)
+        {
             checkedWrite(TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-        else
+            if(saveAsARGB)
+            {
+                const uint16 extraSamples = EXTRASAMPLE_UNASSALPHA;
+                if(!TIFFSetField(m_handle.get(), TIFFTAG_EXTRASAMPLES, 1, &extraSamples))
+                    throw InfoWriteException(std::to_string(TIFFTAG_EXTRASAMPLES));
+            }
+        }else
             checkedWrite(TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-        checkedWrite(TIFFTAG_ROWSPERSTRIP, 1);
+        if(options.tileSize)
+        {
+            if(options.tileSize % 16)
+                throw FormatException("Tile size must be a multiple of 16");
+            checkedWrite(TIFFTAG_TILEWIDTH, options.tileSize);
+            checkedWrite(TIFFTAG_TILELENGTH, options.tileSize);
+        }else
+        {
+            // Default to strips of about 256KiB
+            const size_t rowSize = size_t(width) * SavePolicy<imgFormat>::getBytesPerPixel(options, saveAsARGB);
+            const unsigned rowsPerStrip = options.rowsPerStrip ? options.rowsPerStrip : std::max<size_t>(1, (256u << 10) / rowSize);
+            checkedWrite(TIFFTAG_ROWSPERSTRIP, std::min(rowsPerStrip, height));
+        }
         checkedWrite(TIFFTAG_XRESOLUTION, 1.);
         checkedWrite(TIFFTAG_YRESOLUTION, 1.);
         checkedWrite(TIFFTAG_RESOLUTIONUNIT, 1);
-        if(compress)
-            checkedWrite(TIFFTAG_COMPRESSION, COMPRESSION_LZW);
-        else
-            checkedWrite(TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+        setCompressionTags(m_handle.get(), options, PixelType<imgFormat>::tiffType);
         checkedWrite(TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
         checkedWrite(TIFFTAG_ORIENTATION, originIsAtTop ? ORIENTATION_TOPLEFT : ORIENTATION_BOTLEFT);
-        SavePolicy<imgFormat>::save(saveAsARGB, m_handle.get(), m_data.get(), Allocator(), m_width, m_height);
-        m_dataWritten = true;
     }
 
     template< ImageFormat T_imgFormat, class T_Allocator >
     void
     Image< T_imgFormat, T_Allocator >::loadData()
     {
+        readFormat();
+        // Map the file unless disabled or memory was already allocated (e.g. for an FFT) and must be reused
+        if(!m_data || m_mappedFile.isOpen())
+        {
+            releaseMapping();
+            if(m_useMapping && mapData())
+                return;
+        }
         allocData();
+        loadData(m_data.get(), m_width);
+    }
 
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::readFormat()
+    {
         if(!TIFFGetField(m_handle.get(), TIFFTAG_PHOTOMETRIC, &photometric))
             throw InfoMissingException("Photometric");
         if(photometric != PHOTOMETRIC_RGB && photometric != PHOTOMETRIC_MINISBLACK && photometric != PHOTOMETRIC_MINISWHITE)
@@ -326,42 +1179,56 @@ namespace tiffWriter {
             throw FormatException("PlanarConfig missing or not 1");
         }
 
+        if(bitsPerSample % 8)
+            throw FormatException("Unsupported bits per sample: " + std::to_string(bitsPerSample));
+    }
+
+    template< ImageFormat T_imgFormat, class T_Allocator >
+    void
+    Image< T_imgFormat, T_Allocator >::loadData(DataType* dst, size_t rowStride)
+    {
+        const unsigned bytesPerPixel = samplesPerPixel*bitsPerSample/8;
+        // Decompression dominates for compressed files, so those are decoded in parallel
+        // (unless they are too small to make up for the additional file handles)
+        unsigned numThreads = m_numThreads ? m_numThreads : std::max(1u, std::thread::hardware_concurrency());
+        uint16 compression;
+        if(!TIFFGetField(m_handle.get(), TIFFTAG_COMPRESSION, &compression) || compression == COMPRESSION_NONE)
+            numThreads = 1;
+        else
+            numThreads = std::min<size_t>(numThreads, std::max<size_t>(1, getDataSize() / minParallelSize));
+        // Decodes only the strips/tiles intersecting the region
+        const RegionReader<Allocator> reader(m_handle.get(), m_filepath, m_regionX, m_regionY, m_width, m_height, numThreads);
+
         if(needConversion<T_imgFormat>(tiffSampleFormat, samplesPerPixel, bitsPerSample))
         {
-            size_t numBytes = samplesPerPixel*bitsPerSample/8*m_width;
-            if(numBytes != static_cast<size_t>(TIFFScanlineSize(m_handle.get())))
-                throw FormatException("Scanline size is unexpected: "+std::to_string(numBytes)+":"+std::to_string(TIFFScanlineSize(m_handle.get())));
             if(samplesPerPixel != 1 && samplesPerPixel != 3 && samplesPerPixel != 4)
                 throw FormatException("Unsupported sample count");
 
-            // Use a vector here to safely delete the memory
-            using TmpAlloc = AllocatorWrapper<char, Allocator>;
-            ao::uvector< char, TmpAlloc > tmp(numBytes);
-
             if(samplesPerPixel == 1)
             {
                 if(photometric == PHOTOMETRIC_MINISWHITE)
-                    convert<1, false>(tmp.data());
+                    convert<1, false>(reader, dst, rowStride);
                 else
-                    convert<1, true>(tmp.data());
+                    convert<1, true>(reader, dst, rowStride);
             }else if(samplesPerPixel == 3){
                 if(photometric == PHOTOMETRIC_MINISWHITE)
-                    convert<3, false>(tmp.data());
+                    convert<3, false>(reader, dst, rowStride);
                 else
-                    convert<3, true>(tmp.data());
+                    convert<3, true>(reader, dst, rowStride);
             }else{
                 if(photometric == PHOTOMETRIC_MINISWHITE)
-                    convert<4, false>(tmp.data());
+                    convert<4, false>(reader, dst, rowStride);
                 else
-                    convert<4, true>(tmp.data());
+                    convert<4, true>(reader, dst, rowStride);
             }
         }else{
-            if(getDataSize() != static_cast<size_t>(TIFFScanlineSize(m_handle.get()))*m_height)
-                throw FormatException("Scanline size is unexpected");
-            for (unsigned y = 0; y < m_height; y++) {
-                if(TIFFReadScanline(m_handle.get(), &m_data[y*m_width], y) != 1)
-                    throw std::runtime_error("Failed reading scanline");
-            }
+            if(bytesPerPixel != sizeof(DataType))
+                throw FormatException("Pixel size is unexpected");
+            reader(bytesPerPixel,
+                    [dst, rowStride](const char* src, unsigned y, unsigned x, unsigned numPixels)
+                    {
+                        std::copy_n(src, numPixels * sizeof(DataType), reinterpret_cast<char*>(&dst[y*rowStride + x]));
+                    });
         }
     }
 
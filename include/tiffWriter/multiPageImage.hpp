@@ -0,0 +1,280 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include "tiffWriter/image.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace tiffWriter
+{
+    /**
+     * Wrapper for a 3D volume stored as the pages of one TIFF file
+     *
+     * When reading, the pages are loaded lazily on first access, so iterating
+     * over the volume with the page index (z) outermost reads the file sequentially.
+     * When writing, pages are appended in order: accessing a later page finishes
+     * the current one(s) and accessing an earlier page is an error.
+     *
+     * \tparam T_imgFormat Format of the pixels
+     * \tparam T_Allocator Allocator(::malloc, ::free) used for managing the raw memory of one page
+     */
+    template< ImageFormat T_imgFormat = ImageFormat::Float, class T_Allocator = TiffAllocator >
+    class MultiPageImage
+    {
+        using PageType = Image< T_imgFormat, T_Allocator >;
+        using DataType = typename PixelType<T_imgFormat>::type;
+        using Ref = DataType&;
+        using ConstRef = const DataType&;
+
+        /** Data of the current page, changed on (const) access when reading */
+        mutable PageType m_page;
+        mutable unsigned m_curPage;
+        mutable bool m_isPageLoaded;
+        unsigned m_numPages;
+        bool m_isWriteable;
+        WriteOptions m_writeOptions;
+
+        MultiPageImage(const MultiPageImage&) = delete;
+        MultiPageImage& operator=(const MultiPageImage&) = delete;
+
+        void
+        loadPage(unsigned page) const
+        {
+            if(m_isPageLoaded && page == m_curPage)
+                return;
+            if(page >= m_numPages)
+                throw std::out_of_range("Page " + std::to_string(page) + " does not exist");
+            const unsigned w = m_page.getWidth();
+            const unsigned h = m_page.getHeight();
+            m_page.setPage(page);
+            m_curPage = page;
+            m_isPageLoaded = true;
+            if(m_page.getWidth() != w || m_page.getHeight() != h)
+                throw std::runtime_error("Page " + std::to_string(page) + " differs in size from the first page");
+        }
+
+        void
+        clearPage()
+        {
+            for(unsigned y = 0; y < m_page.getHeight(); ++y)
+                for(unsigned x = 0; x < m_page.getWidth(); ++x)
+                    m_page(x, y) = DataType();
+        }
+    public:
+
+        /**
+         * Creates an invalid image. Before accessing it you need to call \ref open(..)
+         */
+        MultiPageImage():
+            m_curPage(0), m_isPageLoaded(false), m_numPages(0), m_isWriteable(false)
+        {}
+
+        /**
+         * Opens the file at the given filePath for reading
+         */
+        explicit MultiPageImage(const std::string& filePath): MultiPageImage()
+        {
+            open(filePath);
+        }
+
+        /**
+         * Opens the file at the given filePath for writing
+         */
+        MultiPageImage(const std::string& filePath, unsigned w, unsigned h, unsigned numPages, bool compress = true):
+            MultiPageImage()
+        {
+            open(filePath, w, h, numPages, compress);
+        }
+
+        /**
+         * Opens the file at the given filePath for writing with the given layout and compression of the pages
+         */
+        MultiPageImage(const std::string& filePath, unsigned w, unsigned h, unsigned numPages, const WriteOptions& options):
+            MultiPageImage()
+        {
+            open(filePath, w, h, numPages, options);
+        }
+
+        /**
+         * Closes the file. Pages not yet written are lost, use \ref save() before!
+         */
+        ~MultiPageImage()
+        {
+            close();
+        }
+
+        /**
+         * Opens the file at the given filePath for reading
+         * Only the extents are read, the pages are loaded on access
+         * Implicitly closes an open file
+         */
+        void
+        open(const std::string& filePath)
+        {
+            close();
+            m_page.open(filePath, false);
+            m_numPages = m_page.getNumPages();
+        }
+
+        /**
+         * Opens the file at the given filePath for writing
+         * Overwrites or creates it
+         * Implicitly closes an open file
+         *
+         * @param filePath Path to the file to save to
+         * @param w Width of the pages
+         * @param h Height of the pages
+         * @param numPages Number of pages of the volume
+         * @param compress Whether to compress the pages or not
+         */
+        void
+        open(const std::string& filePath, unsigned w, unsigned h, unsigned numPages, bool compress = true)
+        {
+            open(filePath, w, h, numPages, WriteOptions(compress ? Compression::LZW : Compression::None));
+        }
+
+        /**
+         * Opens the file at the given filePath for writing with the given layout and compression of the pages
+         */
+        void
+        open(const std::string& filePath, unsigned w, unsigned h, unsigned numPages, const WriteOptions& options)
+        {
+            close();
+            m_page.open(filePath, w, h);
+            m_numPages = numPages;
+            m_isWriteable = true;
+            m_writeOptions = options;
+            clearPage();
+        }
+
+        /**
+         * Closes the file freeing all memory
+         */
+        void
+        close()
+        {
+            m_page.close();
+            m_curPage = 0;
+            m_isPageLoaded = false;
+            m_numPages = 0;
+            m_isWriteable = false;
+        }
+
+        /**
+         * Writes the current page and starts the next one (filled with zeros)
+         */
+        void
+        writePage()
+        {
+            if(!m_isWriteable)
+                throw std::runtime_error("Cannot save to a file that is not opened for writing");
+            if(m_curPage >= m_numPages)
+                throw std::out_of_range("All pages have already been written");
+            m_page.savePage(m_curPage, m_numPages, m_writeOptions);
+            ++m_curPage;
+            clearPage();
+        }
+
+        /**
+         * Writes the current and all remaining pages and closes the file. This is NOT done in the destructor!
+         */
+        void
+        save()
+        {
+            while(m_curPage < m_numPages)
+                writePage();
+            close();
+        }
+
+        bool isOpen() const
+        {
+            return m_page.isOpen();
+        }
+
+        unsigned getWidth() const
+        {
+            return m_page.getWidth();
+        }
+
+        unsigned getHeight() const
+        {
+            return m_page.getHeight();
+        }
+
+        unsigned getNumPages() const
+        {
+            return m_numPages;
+        }
+
+        /**
+         * Returns the page that is currently held in memory
+         */
+        unsigned getCurrentPage() const
+        {
+            return m_curPage;
+        }
+
+        /**
+         * Accesses the pixel at the given location (read-write)
+         * Loads the page when reading, finishes the preceding pages when writing
+         */
+        Ref
+        operator()(unsigned x, unsigned y, unsigned z)
+        {
+            if(!m_isWriteable)
+                loadPage(z);
+            else if(z != m_curPage)
+            {
+                if(z < m_curPage)
+                    throw std::runtime_error("Page " + std::to_string(z) + " has already been written");
+                if(z >= m_numPages)
+                    throw std::out_of_range("Page " + std::to_string(z) + " does not exist");
+                while(m_curPage < z)
+                    writePage();
+            }
+            return m_page(x, y);
+        }
+
+        /**
+         * Accesses the pixel at the given location (read-only)
+         * Loads the page if required
+         */
+        ConstRef
+        operator()(unsigned x, unsigned y, unsigned z) const
+        {
+            if(!m_isWriteable)
+                loadPage(z);
+            else if(z != m_curPage)
+                throw std::runtime_error("Only the current page can be read from a file opened for writing");
+            return m_page(x, y);
+        }
+    };
+
+    /**
+     * Monochrome volume where each pixel is represented by 1 float value
+     */
+    template< class T_Allocator = TiffAllocator >
+    using FloatMultiPageImage = MultiPageImage< ImageFormat::Float, T_Allocator >;
+
+    /**
+     * Monochrome volume where each pixel is represented by 1 double value
+     */
+    template< class T_Allocator = TiffAllocator >
+    using DoubleMultiPageImage = MultiPageImage< ImageFormat::Double, T_Allocator >;
+
+}  // namespace tiffWriter
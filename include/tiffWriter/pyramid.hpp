@@ -0,0 +1,167 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#pragma once
+
+#include "tiffWriter/WriteOptions.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace tiffWriter {
+
+    /**
+     * A reduced resolution version of an image
+     *
+     * \tparam T_Pixel Pixel type in memory
+     */
+    template< typename T_Pixel >
+    struct PyramidLevel
+    {
+        unsigned width, height;
+        std::vector<T_Pixel> data;
+    };
+
+    /**
+     * Returns the number of 2x downsampled levels written for an image with the given extents
+     * Levels stop once one fits into a single tile as further ones would not be smaller in the file
+     */
+    inline unsigned
+    getNumPyramidLevels(unsigned width, unsigned height, const WriteOptions& options)
+    {
+        const unsigned tileSize = options.tileSize ? options.tileSize : defaultPyramidTileSize;
+        unsigned numLevels = 0;
+        for(; numLevels < options.numPyramidLevels && (width > tileSize || height > tileSize); ++numLevels)
+        {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+        return numLevels;
+    }
+
+    namespace detail {
+
+        /**
+         * Average of 4 (2x2) pixels
+         */
+        template< typename T >
+        inline T
+        average4(T a, T b, T c, T d)
+        {
+            return (a + b + c + d) / T(4);
+        }
+
+        /**
+         * Average of 4 ARGB pixels, rounded per channel
+         */
+        inline uint32_t
+        average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+        {
+            uint32_t result = 0;
+            for(unsigned shift = 0; shift < 32; shift += 8)
+            {
+                const uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+                result |= ((sum + 2) >> 2) << shift;
+            }
+            return result;
+        }
+
+        /**
+         * Computes a row of the downsampled image from 2 rows of the source image
+         * The last column is repeated for odd widths
+         */
+        template< typename T_Pixel >
+        void
+        downsampleRow(const T_Pixel* row0, const T_Pixel* row1, unsigned srcWidth, T_Pixel* dst, unsigned dstWidth)
+        {
+            const unsigned numPairs = srcWidth / 2;
+            for(unsigned x = 0; x < numPairs; ++x)
+                dst[x] = average4(row0[2*x], row0[2*x + 1], row1[2*x], row1[2*x + 1]);
+            if(numPairs < dstWidth)
+                dst[numPairs] = average4(row0[srcWidth - 1], row0[srcWidth - 1], row1[srcWidth - 1], row1[srcWidth - 1]);
+        }
+
+    }  // namespace detail
+
+    /**
+     * Computes the 2x downsampled (2x2 box filtered) levels of an image, each one from the previous one
+     * Odd extents are rounded up by repeating the last row/column.
+     *
+     * All levels are computed in a single pass over the image: It is split into bands of 2^numLevels rows
+     * whose pixels only contribute to the same band of all levels. Each thread processes its bands through
+     * all levels while the rows are still in the cache.
+     *
+     * @param src Pixels of the image (unstrided)
+     * @param width Width of the image
+     * @param height Height of the image
+     * @param numLevels Number of levels, see \ref getNumPyramidLevels
+     * @param numThreads Number of threads to use
+     * @return The levels in the order of decreasing resolution
+     */
+    template< typename T_Pixel >
+    std::vector< PyramidLevel<T_Pixel> >
+    buildPyramid(const T_Pixel* src, unsigned width, unsigned height, unsigned numLevels, unsigned numThreads)
+    {
+        std::vector< PyramidLevel<T_Pixel> > levels(numLevels);
+        unsigned curWidth = width, curHeight = height;
+        for(PyramidLevel<T_Pixel>& level: levels)
+        {
+            curWidth = level.width = (curWidth + 1) / 2;
+            curHeight = level.height = (curHeight + 1) / 2;
+            level.data.resize(size_t(level.width) * level.height);
+        }
+        if(!numLevels)
+            return levels;
+
+        const size_t bandHeight = size_t(1) << numLevels;
+        const size_t numBands = (height + bandHeight - 1) / bandHeight;
+        auto processBands = [&](size_t firstBand, size_t endBand)
+        {
+            for(size_t band = firstBand; band < endBand; ++band)
+            {
+                const T_Pixel* srcData = src;
+                unsigned srcWidth = width, srcHeight = height;
+                for(unsigned i = 0; i < numLevels; ++i)
+                {
+                    PyramidLevel<T_Pixel>& level = levels[i];
+                    const size_t levelBandHeight = bandHeight >> (i + 1);
+                    const size_t endRow = std::min<size_t>((band + 1) * levelBandHeight, level.height);
+                    for(size_t y = band * levelBandHeight; y < endRow; ++y)
+                    {
+                        const T_Pixel* row0 = &srcData[2 * y * srcWidth];
+                        const T_Pixel* row1 = 2 * y + 1 < srcHeight ? row0 + srcWidth : row0;
+                        detail::downsampleRow(row0, row1, srcWidth, &level.data[y * level.width], level.width);
+                    }
+                    srcData = level.data.data();
+                    srcWidth = level.width;
+                    srcHeight = level.height;
+                }
+            }
+        };
+
+        numThreads = std::max<size_t>(1, std::min<size_t>(numThreads, numBands));
+        std::vector<std::thread> threads;
+        for(unsigned i = 1; i < numThreads; ++i)
+            threads.emplace_back(processBands, numBands * i / numThreads, numBands * (i + 1) / numThreads);
+        processBands(0, numBands / numThreads);
+        for(std::thread& thread: threads)
+            thread.join();
+        return levels;
+    }
+
+}  // namespace tiffWriter
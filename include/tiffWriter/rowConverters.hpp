@@ -0,0 +1,699 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include "tiffWriter/converters.hpp"
+#include "tiffWriter/Half.hpp"
+#include "libLiFFT/CpuFeatures.hpp"
+#include "libLiFFT/c++14_types.hpp"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+namespace tiffWriter {
+
+    namespace detail {
+
+        /**
+         * Vectorized row converters for one instruction set, see \ref ConvertRow
+         * The generic versions do not vectorize the conversion and fall back to the next smaller instruction set.
+         * Only the SSE2 version may be called without checking the CPU features first.
+         */
+        template< class T_Convert, typename T_SFINAE = void >
+        struct ConvertRowSse2
+        {
+            template< typename T_Src, typename T_Dest >
+            static unsigned
+            apply(const T_Src* /*src*/, T_Dest* /*dst*/, unsigned /*numPixels*/)
+            {
+                return 0;
+            }
+        };
+
+#if defined(LiFFT_X86_DISPATCH)
+
+        template< class T_Convert, typename T_SFINAE = void >
+        struct ConvertRowAvx2: ConvertRowSse2<T_Convert>{};
+
+        template< class T_Convert, typename T_SFINAE = void >
+        struct ConvertRowAvx2F16c: ConvertRowAvx2<T_Convert>{};
+
+#endif
+
+    }  // namespace detail
+
+    /**
+     * Vectorized version of a pixel converter (\ref Convert) for whole rows
+     * apply(src, dst, numPixels) converts the first pixels of the row and returns their number, the remaining ones
+     * (tail of the row or all of them if the conversion is not vectorized) must be converted by the scalar converter.
+     * The results are the same as those of the scalar converter (up to rounding for the weighted RGB sum).
+     * Uses the widest instruction set supported by the CPU.
+     *
+     * \tparam T_Convert Scalar converter
+     */
+    template< class T_Convert >
+    struct ConvertRow
+    {
+        template< typename T_Src, typename T_Dest >
+        static unsigned
+        apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+        {
+#if defined(LiFFT_X86_DISPATCH)
+            const LiFFT::CpuFeatures& cpu = LiFFT::getCpuFeatures();
+            if(cpu.f16c)
+                return detail::ConvertRowAvx2F16c<T_Convert>::apply(src, dst, numPixels);
+            if(cpu.avx2)
+                return detail::ConvertRowAvx2<T_Convert>::apply(src, dst, numPixels);
+#endif
+            return detail::ConvertRowSse2<T_Convert>::apply(src, dst, numPixels);
+        }
+    };
+
+#if defined(__SSE2__)
+
+    namespace detail {
+
+        template< typename T >
+        struct Vec4;
+
+        /**
+         * 4 floats in an SSE register
+         */
+        template<>
+        struct Vec4<float>
+        {
+            __m128 v;
+
+            static Vec4 set1(float val){ return Vec4{_mm_set1_ps(val)}; }
+            static Vec4 fromInt(__m128i val){ return Vec4{_mm_cvtepi32_ps(val)}; }
+            static Vec4 load(const float* src){ return Vec4{_mm_loadu_ps(src)}; }
+
+            void
+            store(float* dst) const
+            {
+                _mm_storeu_ps(dst, v);
+            }
+
+            void
+            store(double* dst) const
+            {
+                _mm_storeu_pd(dst, _mm_cvtps_pd(v));
+                _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+            }
+
+            Vec4 operator+(const Vec4& rhs) const { return Vec4{_mm_add_ps(v, rhs.v)}; }
+            Vec4 operator-(const Vec4& rhs) const { return Vec4{_mm_sub_ps(v, rhs.v)}; }
+            Vec4 operator*(const Vec4& rhs) const { return Vec4{_mm_mul_ps(v, rhs.v)}; }
+        };
+
+        /**
+         * 4 doubles in 2 SSE registers
+         */
+        template<>
+        struct Vec4<double>
+        {
+            __m128d lo, hi;
+
+            static Vec4 set1(double val){ return Vec4{_mm_set1_pd(val), _mm_set1_pd(val)}; }
+            static Vec4 fromInt(__m128i val){ return Vec4{_mm_cvtepi32_pd(val), _mm_cvtepi32_pd(_mm_unpackhi_epi64(val, val))}; }
+            static Vec4 load(const double* src){ return Vec4{_mm_loadu_pd(src), _mm_loadu_pd(src + 2)}; }
+
+            void
+            store(double* dst) const
+            {
+                _mm_storeu_pd(dst, lo);
+                _mm_storeu_pd(dst + 2, hi);
+            }
+
+            void
+            store(float* dst) const
+            {
+                _mm_storeu_ps(dst, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+            }
+
+            Vec4 operator+(const Vec4& rhs) const { return Vec4{_mm_add_pd(lo, rhs.lo), _mm_add_pd(hi, rhs.hi)}; }
+            Vec4 operator-(const Vec4& rhs) const { return Vec4{_mm_sub_pd(lo, rhs.lo), _mm_sub_pd(hi, rhs.hi)}; }
+            Vec4 operator*(const Vec4& rhs) const { return Vec4{_mm_mul_pd(lo, rhs.lo), _mm_mul_pd(hi, rhs.hi)}; }
+        };
+
+        /**
+         * Loads 4 bytes into the lowest 32 bit element
+         */
+        inline __m128i
+        loadBytes4(const void* src)
+        {
+            int32_t val;
+            std::memcpy(&val, src, sizeof(val));
+            return _mm_cvtsi32_si128(val);
+        }
+
+        /**
+         * Loads 4 consecutive integers and converts them to a vector
+         */
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const uint8_t* src)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            return T_Vec::fromInt(_mm_unpacklo_epi16(_mm_unpacklo_epi8(loadBytes4(src), zero), zero));
+        }
+
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const int8_t* src)
+        {
+            // Replicate each byte to all 4 bytes of its 32 bit element and shift it back to sign extend it
+            __m128i values = loadBytes4(src);
+            values = _mm_unpacklo_epi8(values, values);
+            return T_Vec::fromInt(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 24));
+        }
+
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const uint16_t* src)
+        {
+            const __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+            return T_Vec::fromInt(_mm_unpacklo_epi16(values, _mm_setzero_si128()));
+        }
+
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const int16_t* src)
+        {
+            const __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+            return T_Vec::fromInt(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16));
+        }
+
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const int32_t* src)
+        {
+            return T_Vec::fromInt(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+        }
+
+        template< class T_Vec >
+        T_Vec
+        loadInt4(const uint32_t* src)
+        {
+            // There is no unsigned conversion, so convert the upper and lower 16 bits separately.
+            // Both parts are exact and the sum is rounded once, like the conversion of the whole value.
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            const T_Vec hi = T_Vec::fromInt(_mm_srli_epi32(values, 16));
+            const T_Vec lo = T_Vec::fromInt(_mm_and_si128(values, _mm_set1_epi32(0xFFFF)));
+            return hi * T_Vec::set1(65536) + lo;
+        }
+
+        /**
+         * Integral (8/16/32 bit) -> FP
+         */
+        template< typename T_Src, typename T_Dest, bool T_minIsBlack >
+        struct ConvertRowSse2<
+            Convert< T_Src, T_Dest, 1, 1, T_minIsBlack >,
+            std::enable_if_t< std::is_integral<T_Src>::value && sizeof(T_Src) <= 4 && std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using Channel = ConvertChannel< T_Src, T_Dest, T_minIsBlack >;
+            using Vec = Vec4<T_Dest>;
+
+            static unsigned
+            apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec min = Vec::set1(Channel::min);
+                const Vec factor = Vec::set1(Channel::factor);
+                const Vec maxVal = Vec::set1(GetMaxVal<T_Src>::value);
+                unsigned x = 0;
+                for(; x + 4 <= numPixels; x += 4)
+                {
+                    Vec res = (loadInt4<Vec>(src + x) - min) * factor;
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+        /**
+         * FP -> FP (values are inverted in the source precision like the scalar version)
+         */
+        template< typename T_Src, typename T_Dest, bool T_minIsBlack >
+        struct ConvertRowSse2<
+            Convert< T_Src, T_Dest, 1, 1, T_minIsBlack >,
+            std::enable_if_t< std::is_floating_point<T_Src>::value && std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using Vec = Vec4<T_Src>;
+
+            static unsigned
+            apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec maxVal = Vec::set1(GetMaxVal<T_Src>::value);
+                unsigned x = 0;
+                for(; x + 4 <= numPixels; x += 4)
+                {
+                    Vec res = Vec::load(src + x);
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+    }  // namespace detail
+
+#endif
+
+#if defined(LiFFT_X86_DISPATCH)
+
+    namespace detail {
+
+        template< typename T >
+        struct Vec8;
+
+        /**
+         * 8 floats in an AVX register
+         */
+        template<>
+        struct Vec8<float>
+        {
+            __m256 v;
+
+            LiFFT_TARGET("avx2") static Vec8 set1(float val){ return Vec8{_mm256_set1_ps(val)}; }
+            LiFFT_TARGET("avx2") static Vec8 fromInt(__m256i val){ return Vec8{_mm256_cvtepi32_ps(val)}; }
+            LiFFT_TARGET("avx2") static Vec8 load(const float* src){ return Vec8{_mm256_loadu_ps(src)}; }
+
+            LiFFT_TARGET("avx2")
+            void
+            store(float* dst) const
+            {
+                _mm256_storeu_ps(dst, v);
+            }
+
+            LiFFT_TARGET("avx2")
+            void
+            store(double* dst) const
+            {
+                _mm256_storeu_pd(dst, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+                _mm256_storeu_pd(dst + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+            }
+
+            LiFFT_TARGET("avx2") Vec8 operator+(const Vec8& rhs) const { return Vec8{_mm256_add_ps(v, rhs.v)}; }
+            LiFFT_TARGET("avx2") Vec8 operator-(const Vec8& rhs) const { return Vec8{_mm256_sub_ps(v, rhs.v)}; }
+            LiFFT_TARGET("avx2") Vec8 operator*(const Vec8& rhs) const { return Vec8{_mm256_mul_ps(v, rhs.v)}; }
+        };
+
+        /**
+         * 8 doubles in 2 AVX registers
+         */
+        template<>
+        struct Vec8<double>
+        {
+            __m256d lo, hi;
+
+            LiFFT_TARGET("avx2") static Vec8 set1(double val){ return Vec8{_mm256_set1_pd(val), _mm256_set1_pd(val)}; }
+
+            LiFFT_TARGET("avx2")
+            static Vec8
+            fromInt(__m256i val)
+            {
+                return Vec8{_mm256_cvtepi32_pd(_mm256_castsi256_si128(val)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(val, 1))};
+            }
+
+            LiFFT_TARGET("avx2") static Vec8 load(const double* src){ return Vec8{_mm256_loadu_pd(src), _mm256_loadu_pd(src + 4)}; }
+
+            LiFFT_TARGET("avx2")
+            void
+            store(double* dst) const
+            {
+                _mm256_storeu_pd(dst, lo);
+                _mm256_storeu_pd(dst + 4, hi);
+            }
+
+            LiFFT_TARGET("avx2")
+            void
+            store(float* dst) const
+            {
+                _mm_storeu_ps(dst, _mm256_cvtpd_ps(lo));
+                _mm_storeu_ps(dst + 4, _mm256_cvtpd_ps(hi));
+            }
+
+            LiFFT_TARGET("avx2") Vec8 operator+(const Vec8& rhs) const { return Vec8{_mm256_add_pd(lo, rhs.lo), _mm256_add_pd(hi, rhs.hi)}; }
+            LiFFT_TARGET("avx2") Vec8 operator-(const Vec8& rhs) const { return Vec8{_mm256_sub_pd(lo, rhs.lo), _mm256_sub_pd(hi, rhs.hi)}; }
+            LiFFT_TARGET("avx2") Vec8 operator*(const Vec8& rhs) const { return Vec8{_mm256_mul_pd(lo, rhs.lo), _mm256_mul_pd(hi, rhs.hi)}; }
+        };
+
+        /**
+         * Converts 8 unsigned 32 bit integers to a vector
+         * Same split into 16 bit halves as for SSE2 (unsigned conversions require AVX-512)
+         */
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        fromUInt8(__m256i values)
+        {
+            const T_Vec hi = T_Vec::fromInt(_mm256_srli_epi32(values, 16));
+            const T_Vec lo = T_Vec::fromInt(_mm256_and_si256(values, _mm256_set1_epi32(0xFFFF)));
+            return hi * T_Vec::set1(65536) + lo;
+        }
+
+        /**
+         * Loads 8 consecutive integers and converts them to a vector
+         */
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const uint8_t* src)
+        {
+            return T_Vec::fromInt(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src))));
+        }
+
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const int8_t* src)
+        {
+            return T_Vec::fromInt(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src))));
+        }
+
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const uint16_t* src)
+        {
+            return T_Vec::fromInt(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))));
+        }
+
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const int16_t* src)
+        {
+            return T_Vec::fromInt(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))));
+        }
+
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const int32_t* src)
+        {
+            return T_Vec::fromInt(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+        }
+
+        template< class T_Vec >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadInt8(const uint32_t* src)
+        {
+            return fromUInt8<T_Vec>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+        }
+
+        /**
+         * Loads one channel of 8 consecutive pixels and converts it to a vector
+         * Reads up to 3 bytes after the channel of the last pixel, so there must be another pixel after those
+         */
+        template< class T_Vec, typename T, uint16_t T_numChannels >
+        LiFFT_TARGET("avx2")
+        T_Vec
+        loadChannel(const T* pixels, uint16_t channel)
+        {
+            static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "Only 8, 16 and 32 bit integral channels are supported");
+            constexpr int stride = T_numChannels * sizeof(T);
+            // Bits above the channel in the 32 bit loads
+            constexpr int shift = 32 - 8 * sizeof(T);
+            const __m256i offsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+            const __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pixels + channel), offsets, 1);
+            if(std::is_signed<T>::value)
+                return T_Vec::fromInt(shift ? _mm256_srai_epi32(_mm256_slli_epi32(values, shift), shift) : values);
+            if(shift)
+                return T_Vec::fromInt(_mm256_and_si256(values, _mm256_set1_epi32(int(std::numeric_limits<T>::max()))));
+            return fromUInt8<T_Vec>(values);
+        }
+
+        /**
+         * Integral (8/16/32 bit) -> FP
+         */
+        template< typename T_Src, typename T_Dest, bool T_minIsBlack >
+        struct ConvertRowAvx2<
+            Convert< T_Src, T_Dest, 1, 1, T_minIsBlack >,
+            std::enable_if_t< std::is_integral<T_Src>::value && sizeof(T_Src) <= 4 && std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using Channel = ConvertChannel< T_Src, T_Dest, T_minIsBlack >;
+            using Vec = Vec8<T_Dest>;
+
+            LiFFT_TARGET("avx2")
+            static unsigned
+            apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec min = Vec::set1(Channel::min);
+                const Vec factor = Vec::set1(Channel::factor);
+                const Vec maxVal = Vec::set1(GetMaxVal<T_Src>::value);
+                unsigned x = 0;
+                for(; x + 8 <= numPixels; x += 8)
+                {
+                    Vec res = (loadInt8<Vec>(src + x) - min) * factor;
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+        /**
+         * FP -> FP (values are inverted in the source precision like the scalar version)
+         */
+        template< typename T_Src, typename T_Dest, bool T_minIsBlack >
+        struct ConvertRowAvx2<
+            Convert< T_Src, T_Dest, 1, 1, T_minIsBlack >,
+            std::enable_if_t< std::is_floating_point<T_Src>::value && std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using Vec = Vec8<T_Src>;
+
+            LiFFT_TARGET("avx2")
+            static unsigned
+            apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec maxVal = Vec::set1(GetMaxVal<T_Src>::value);
+                unsigned x = 0;
+                for(; x + 8 <= numPixels; x += 8)
+                {
+                    Vec res = Vec::load(src + x);
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+        /**
+         * (A)RGB (8/16/32 bit) -> mono FP
+         */
+        template< typename T_Src, typename T_Dest, uint16_t T_numChannelsSrc, bool T_minIsBlack >
+        struct ConvertRowAvx2<
+            Convert< T_Src, T_Dest, T_numChannelsSrc, 1, T_minIsBlack >,
+            std::enable_if_t< T_numChannelsSrc != 1 && std::is_integral<T_Src>::value && sizeof(T_Src) <= 4 && std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using ToMono = ConvertARGBToMono< T_Src, T_numChannelsSrc, T_Dest, T_minIsBlack >;
+            static_assert(std::is_same< typename ToMono::FloatType, T_Dest >::value, "Weighted sum must be calculated in the destination type");
+            using Vec = Vec8<T_Dest>;
+
+            LiFFT_TARGET("avx2")
+            static unsigned
+            apply(const T_Src* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec rWeight = Vec::set1(ToMono::rWeight);
+                const Vec gWeight = Vec::set1(ToMono::gWeight);
+                const Vec bWeight = Vec::set1(ToMono::bWeight);
+                const Vec maxVal = Vec::set1(GetMaxVal<T_Dest>::value);
+                unsigned x = 0;
+                // The channels are gathered with 32 bit loads, so leave at least 1 pixel to not read past the row
+                for(; x + 8 < numPixels; x += 8)
+                {
+                    const T_Src* pixels = src + x * T_numChannelsSrc;
+                    const Vec r = loadChannel< Vec, T_Src, T_numChannelsSrc >(pixels, 0);
+                    const Vec g = loadChannel< Vec, T_Src, T_numChannelsSrc >(pixels, 1);
+                    const Vec b = loadChannel< Vec, T_Src, T_numChannelsSrc >(pixels, 2);
+                    Vec res = rWeight * r + gWeight * g + bWeight * b;
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+        /**
+         * Half -> FP
+         */
+        template< typename T_Dest, bool T_minIsBlack >
+        struct ConvertRowAvx2F16c<
+            Convert< Half, T_Dest, 1, 1, T_minIsBlack >,
+            std::enable_if_t< std::is_floating_point<T_Dest>::value >
+        >
+        {
+            using Vec = Vec8<float>;
+
+            LiFFT_TARGET("avx2,f16c")
+            static unsigned
+            apply(const Half* src, T_Dest* dst, unsigned numPixels)
+            {
+                const Vec maxVal = Vec::set1(GetMaxVal<float>::value);
+                unsigned x = 0;
+                for(; x + 8 <= numPixels; x += 8)
+                {
+                    Vec res{_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)))};
+                    if(!T_minIsBlack)
+                        res = maxVal - res;
+                    res.store(dst + x);
+                }
+                return x;
+            }
+        };
+
+        /**
+         * Half float packing and RGB packing for the instruction sets in their names, see \ref packHalf and \ref packRGB
+         */
+        LiFFT_TARGET("avx2,f16c")
+        inline unsigned
+        packHalfF16c(const float* src, Half* dst, unsigned numPixels)
+        {
+            unsigned x = 0;
+            for(; x + 8 <= numPixels; x += 8)
+            {
+                const __m128i res = _mm256_cvtps_ph(_mm256_loadu_ps(src + x), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), res);
+            }
+            return x;
+        }
+
+        LiFFT_TARGET("avx2,f16c")
+        inline unsigned
+        packHalfF16c(const double* src, Half* dst, unsigned numPixels)
+        {
+            unsigned x = 0;
+            for(; x + 8 <= numPixels; x += 8)
+            {
+                const __m256 values = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(src + x + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(src + x)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+            }
+            return x;
+        }
+
+        LiFFT_TARGET("avx2")
+        inline unsigned
+        packRGBAvx2(const uint32_t* src, uint8_t* dst, unsigned numPixels)
+        {
+            // Drop the alpha byte of each pixel in both 128 bit lanes: 4 pixels -> 12 bytes
+            const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                     0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+            unsigned x = 0;
+            // Each lane is stored with 16 bytes, so the last store writes 4 bytes past the 8 pixels
+            // which must belong to pixels converted afterwards
+            for(; x + 10 <= numPixels; x += 8)
+            {
+                const __m256i packed = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x)), shuffle);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x), _mm256_castsi256_si128(packed));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x + 12), _mm256_extracti128_si256(packed, 1));
+            }
+            return x;
+        }
+
+        LiFFT_TARGET("ssse3")
+        inline unsigned
+        packRGBSsse3(const uint32_t* src, uint8_t* dst, unsigned numPixels)
+        {
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+            unsigned x = 0;
+            // Same as for AVX2: The 16 byte store writes 4 bytes (of the next 2 pixels) past the 4 pixels
+            for(; x + 6 <= numPixels; x += 4)
+            {
+                const __m128i packed = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)), shuffle);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x), packed);
+            }
+            return x;
+        }
+
+    }  // namespace detail
+
+#endif
+
+    /**
+     * Converts floating point values to half floats (via float like Half(float))
+     * Returns the number of converted values like \ref ConvertRow
+     */
+    template< typename T_Src >
+    unsigned
+    packHalf(const T_Src* /*src*/, Half* /*dst*/, unsigned /*numPixels*/)
+    {
+        return 0;
+    }
+
+#if defined(LiFFT_X86_DISPATCH)
+
+    template<>
+    inline unsigned
+    packHalf(const float* src, Half* dst, unsigned numPixels)
+    {
+        return LiFFT::getCpuFeatures().f16c ? detail::packHalfF16c(src, dst, numPixels) : 0;
+    }
+
+    template<>
+    inline unsigned
+    packHalf(const double* src, Half* dst, unsigned numPixels)
+    {
+        return LiFFT::getCpuFeatures().f16c ? detail::packHalfF16c(src, dst, numPixels) : 0;
+    }
+
+#endif
+
+    /**
+     * Packs ARGB pixels (as read by TIFFGetR/G/B) into RGB channels
+     * Returns the number of packed pixels like \ref ConvertRow
+     */
+#if defined(LiFFT_X86_DISPATCH)
+
+    inline unsigned
+    packRGB(const uint32_t* src, uint8_t* dst, unsigned numPixels)
+    {
+        const LiFFT::CpuFeatures& cpu = LiFFT::getCpuFeatures();
+        if(cpu.avx2)
+            return detail::packRGBAvx2(src, dst, numPixels);
+        if(cpu.ssse3)
+            return detail::packRGBSsse3(src, dst, numPixels);
+        return 0;
+    }
+
+#else
+
+    inline unsigned
+    packRGB(const uint32_t* /*src*/, uint8_t* /*dst*/, unsigned /*numPixels*/)
+    {
+        return 0;
+    }
+
+#endif
+
+}  // namespace tiffWriter
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "tiffWriter/image.hpp"
+#include "tiffWriter/multiPageImage.hpp"
 #include "libLiFFT/traits/NumDims.hpp"
 #include "libLiFFT/traits/IdentityAccessor.hpp"
 #include "libLiFFT/traits/IsComplex.hpp"
@@ -44,6 +45,21 @@ namespace traits {
         using type = accessors::VolumeAccessor;
     };
 
+    template< tiffWriter::ImageFormat T_imgFormat, class T_Allocator >
+    struct NumDims< tiffWriter::MultiPageImage< T_imgFormat, T_Allocator > >: std::integral_constant<unsigned, 3>{};
+
+    template< tiffWriter::ImageFormat T_imgFormat, class T_Allocator >
+    struct IsComplex< tiffWriter::MultiPageImage< T_imgFormat, T_Allocator > >: BoolConst<false>{};
+
+    template< tiffWriter::ImageFormat T_imgFormat, class T_Allocator >
+    struct IsStrided< tiffWriter::MultiPageImage< T_imgFormat, T_Allocator > >: BoolConst<false>{};
+
+    template< tiffWriter::ImageFormat T_imgFormat, class T_Allocator >
+    struct IdentityAccessor< tiffWriter::MultiPageImage< T_imgFormat, T_Allocator > >
+    {
+        using type = accessors::VolumeAccessor;
+    };
+
 }  // namespace traits
 
 namespace policies {
@@ -64,5 +80,21 @@ namespace policies {
         const types::Vec<2> m_extents;
     };
 
+    template< tiffWriter::ImageFormat T_imgFormat, class T_Allocator >
+    struct GetExtentsImpl< tiffWriter::MultiPageImage< T_imgFormat, T_Allocator > >
+    {
+        using type = tiffWriter::MultiPageImage< T_imgFormat, T_Allocator >;
+
+        GetExtentsImpl(const type& data): m_extents(data.getNumPages(), data.getHeight(), data.getWidth()){}
+
+        unsigned
+        operator[](unsigned dim) const
+        {
+            return m_extents[dim];
+        }
+    private:
+        const types::Vec<3> m_extents;
+    };
+
 }  // namespace policies
 }  // namespace LiFFT
@@ -18,8 +18,11 @@
 #include <string>
 
 #include "tiffWriter/image.hpp"
+#include "tiffWriter/WriteOptionsArgs.hpp"
+#include "tiffWriter/multiPageImage.hpp"
 #include "tiffWriter/traitsAndPolicies.hpp"
 #include "libLiFFT/FFT.hpp"
+#include "libLiFFT/MemoryPlanner.hpp"
 #if defined(WITH_CUDA)
 #   include "libLiFFT/libraries/cuFFT/cuFFT.hpp"
     using FFT_LIB = LiFFT::libraries::cuFFT::CuFFT<>;
@@ -209,7 +212,7 @@ void genData(T& data, unsigned dataSet)
     std::cout << "Generating done" << std::endl;
 }
 
-void writeInput(const string& filePath, unsigned dataSet)
+void writeInput(const string& filePath, unsigned dataSet, const tiffWriter::WriteOptions& writeOptions)
 {
     tiffWriter::FloatImage<> img(filePath, 1024u, 1024u);
     LiFFT::mem::RealContainer<3, float> data(LiFFT::types::Vec3(1u, 1024u, 1024u));
@@ -221,41 +224,45 @@ void writeInput(const string& filePath, unsigned dataSet)
         auto view = LiFFT::types::makeSliceView<0>(data, LiFFT::types::makeRange());
         LiFFT::policies::copy(view, img);
         if(dataSet)
-            img.save();
+            img.save(writeOptions);
         else
         {
             boost::filesystem::path fPath(filePath);
             fPath.replace_extension(std::to_string(i) + fPath.extension().string());
-            img.saveTo(fPath.string());
+            img.saveTo(fPath.string(), writeOptions);
             img.flush();
         }
     }
 }
 
-void writeAllInput(const string& filePath, unsigned dataSet)
+void writeAllInput(const string& filePath, unsigned dataSet, const tiffWriter::WriteOptions& writeOptions)
 {
-    tiffWriter::FloatImage<> img(filePath, 1024u, 1024u);
     LiFFT::mem::RealContainer<3, float> data(LiFFT::types::Vec3(1024u, 1024u, 1024u));
     unsigned startDS = dataSet ? dataSet : 1;
     unsigned lastDS = dataSet ? dataSet : 4;
     for(unsigned i = startDS; i<=lastDS; i++)
     {
         genData(data, i);
-        for(unsigned z=0; z<data.getExtents()[0]; z++){
-            auto view = LiFFT::types::makeSliceView<0>(data, LiFFT::types::makeRange(LiFFT::types::Vec3(z, 0u, 0u)));
-            LiFFT::policies::copy(view, img);
-            boost::filesystem::path fPath(filePath);
-            fPath.replace_extension(std::to_string(i) + string("_") + std::to_string(z) + fPath.extension().string());
-            img.saveTo(fPath.string());
-            img.flush();
-        }
+        // One multi-page file per data set
+        boost::filesystem::path fPath(filePath);
+        fPath.replace_extension(std::to_string(i) + fPath.extension().string());
+        tiffWriter::FloatMultiPageImage<> img(fPath.string(), 1024u, 1024u, data.getExtents()[0], writeOptions);
+        LiFFT::policies::copy(data, img);
+        img.save();
     }
 }
 
-void writeFFT(const string& filePath, unsigned dataSet)
+void writeFFT(const string& filePath, unsigned dataSet, const tiffWriter::WriteOptions& writeOptions)
 {
     using FFT = LiFFT::FFT_3D_R2C_F<true>;
-    auto input = FFT::createNewInput(LiFFT::types::Vec3(1024u, 1024u, 1024u));
+    const LiFFT::types::Vec3 extents(1024u, 1024u, 1024u);
+    // Fail before allocating anything if the FFT cannot fit
+    const LiFFT::MemoryRequirements req = LiFFT::MemoryPlanner<FFT, FFT_LIB>::getRequirements(extents);
+    const size_t availableMem = LiFFT::getAvailableMemory();
+    cout << "FFT requires " << (req.getTotal() >> 20) << "MiB (" << (availableMem >> 20) << "MiB available)" << std::endl;
+    if(availableMem && req.getTotal() > availableMem)
+        throw std::runtime_error("Not enough memory for the FFT");
+    auto input = FFT::createNewInput(extents);
     auto output = FFT::createNewOutput(input);
     auto outSlice = LiFFT::types::makeSliceView<0>(LiFFT::getFullData(output), LiFFT::types::makeRange());
     auto fft = LiFFT::makeFFT<FFT_LIB, false>(input);
@@ -271,12 +278,12 @@ void writeFFT(const string& filePath, unsigned dataSet)
         LiFFT::accessors::TransposeAccessor<decltype(acc1)> acc(acc1);
         LiFFT::policies::copy(outSlice, img, acc);
         if(dataSet)
-            img.save();
+            img.save(writeOptions);
         else
         {
             boost::filesystem::path fPath(filePath);
             fPath.replace_extension(std::to_string(i) + fPath.extension().string());
-            img.saveTo(fPath.string());
+            img.saveTo(fPath.string(), writeOptions);
             img.flush();
         }
     }
@@ -292,8 +299,10 @@ main(int argc, char** argv)
         ("help,h", "Show help message")
         ("outputFile,o", po::value<string>(&outFilePath)->default_value("output.tif"), "Output file to write to")
         ("dataSet,d", po::value<unsigned>(&dataSet)->default_value(0), "Data set to use (1-4) 0 => all")
-        ("type,t", po::value<unsigned>(&inOrOut)->default_value(0), "Write Output(0), Input(1) or all Input(2)")
+        ("type,t", po::value<unsigned>(&inOrOut)->default_value(0), "Write Output(0), Input(1) or all Input as multi-page TIFF(2)")
     ;
+    tiffWriter::WriteOptionsArgs writeOptionsArgs;
+    writeOptionsArgs.addTo(options::desc);
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, options::desc), vm);
@@ -305,10 +314,11 @@ main(int argc, char** argv)
         return 1;
     }
 
+    const tiffWriter::WriteOptions writeOptions = writeOptionsArgs.getWriteOptions();
     if(inOrOut == 0)
-        writeFFT(outFilePath, dataSet);
+        writeFFT(outFilePath, dataSet, writeOptions);
     else if(inOrOut == 1)
-        writeInput(outFilePath, dataSet);
+        writeInput(outFilePath, dataSet, writeOptions);
     else
-        writeAllInput(outFilePath, dataSet);
+        writeAllInput(outFilePath, dataSet, writeOptions);
 }
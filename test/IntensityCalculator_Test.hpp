@@ -35,24 +35,22 @@ void testIntensityCalculator()
     std::vector<double> result(NumVals);
 
     real.extents = {NumVals};
-    real.data = new Real<double>[getNumElements(real)];
+    real.data.allocData(getNumElements(real));
 
     complexAoS.extents = {NumVals};
-    complexAoS.data = new Complex<double>[getNumElements(complexAoS)];
+    complexAoS.data.allocData(getNumElements(complexAoS));
 
     complexSoA.extents = {NumVals};
-    complexSoA.data.getRealData() = new Real<double>[getNumElements(complexSoA)];
-    complexSoA.data.getImagData() = new Real<double>[getNumElements(complexSoA)];
+    complexSoA.data.allocData(getNumElements(complexSoA));
 
     real3D.extents = {NumVals, NumVals+1, NumVals+2};
-    real3D.data = new Real<double>[getNumElements(real3D)];
+    real3D.data.allocData(getNumElements(real3D));
 
     complexAoS3D.extents = {NumVals, NumVals+1, NumVals+2};
-    complexAoS3D.data = new Complex<double>[getNumElements(complexAoS3D)];
+    complexAoS3D.data.allocData(getNumElements(complexAoS3D));
 
     complexSoA3D.extents = {NumVals, NumVals+1, NumVals+2};
-    complexSoA3D.data.getRealData() = new Real<double>[getNumElements(complexSoA3D)];
-    complexSoA3D.data.getImagData() = new Real<double>[getNumElements(complexSoA3D)];
+    complexSoA3D.data.allocData(getNumElements(complexSoA3D));
 
     useIntensityCalculator(real, result.data());
     useIntensityCalculator(complexAoS, result.data());
@@ -55,20 +55,19 @@ void test(){
     DataContainer< 1, ComplexSoAValues<double> > complexSoA;
 
     simpleRealData.extents = {NumVals};
-    simpleRealData.data = new Real<double>[NumVals];
+    simpleRealData.data.allocData(NumVals);
     for(unsigned i=0; i<NumVals; i++)
         simpleRealData.data[i] = 5;
 
     complexAoS.extents = {NumVals};
-    complexAoS.data = new Complex<double>[NumVals];
+    complexAoS.data.allocData(NumVals);
     for(unsigned i=0; i<NumVals; i++){
         complexAoS.data[i].real = 4;
         complexAoS.data[i].imag = 3;
     }
 
     complexSoA.extents = {NumVals};
-    complexSoA.data.getRealData() = new Real<double>[NumVals];
-    complexSoA.data.getImagData() = new Real<double>[NumVals];
+    complexSoA.data.allocData(NumVals);
     for(unsigned i=0; i<NumVals; i++){
         complexSoA.data.getRealData()[i] = 4;
         complexSoA.data.getImagData()[i] = 3;
@@ -0,0 +1,161 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/AsyncFileReader.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/Allocator.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(AsyncReader)
+
+    using LiFFT::mem::AsyncFileReader;
+    using LiFFT::mem::AsyncReadOptions;
+    using LiFFT::mem::IoBackend;
+    using Extents = LiFFT::types::Vec<3>;
+    using Volume = LiFFT::mem::RealContainer<3, float, false, LiFFT::mem::AlignedAllocator<LiFFT::mem::directIOAlignment>>;
+
+    const std::string filePath = "asyncReader.raw";
+    const Extents extents(16u, 64u, 256u);
+    const size_t headerSize = 4096;
+
+    void
+    writeFile(size_t numElements)
+    {
+        std::ofstream file(filePath, std::ios::binary);
+        const std::string header(headerSize, 'x');
+        file.write(header.data(), header.size());
+        for(unsigned i = 0; i < numElements; ++i)
+        {
+            const float value = i;
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+
+    void
+    checkVolume(Volume& volume, size_t firstPlane = 0, size_t endPlane = extents[0])
+    {
+        const size_t planeSize = extents[1] * extents[2];
+        const float* data = reinterpret_cast<const float*>(volume.getData());
+        for(size_t i = firstPlane * planeSize; i < endPlane * planeSize; ++i)
+        {
+            if(data[i] != float(i))
+                BOOST_FAIL("Mismatch at " + std::to_string(i));
+        }
+    }
+
+    void
+    testBackend(IoBackend backend)
+    {
+        writeFile(extents[0] * extents[1] * extents[2]);
+        AsyncReadOptions options;
+        options.backend = backend;
+        // Small requests so each slab consists of several
+        options.requestSize = 16 * 1024;
+        options.queueDepth = 8;
+        AsyncFileReader reader(filePath, options);
+        if(backend == IoBackend::Threads)
+            BOOST_REQUIRE(reader.getBackend() == IoBackend::Threads);
+
+        Volume volume(extents);
+        reader.read(volume, headerSize);
+        BOOST_REQUIRE_EQUAL(reader.getNumSlabs(), extents[0]);
+        for(size_t i = 0; i < reader.getNumSlabs(); ++i)
+        {
+            reader.waitForSlab(i);
+            BOOST_REQUIRE(reader.isSlabReady(i));
+            checkVolume(volume, i, i + 1);
+        }
+        reader.wait();
+
+        // Unaligned offset: buffered reads only
+        Volume volume2(extents);
+        std::vector<char> expected(1000);
+        reader.read(volume2.getData(), expected.size(), 3);
+        reader.wait();
+        std::ifstream file(filePath, std::ios::binary);
+        file.seekg(3);
+        file.read(expected.data(), expected.size());
+        BOOST_REQUIRE(std::equal(expected.begin(), expected.end(), reinterpret_cast<const char*>(volume2.getData())));
+
+        // Multiple planes per slab
+        reader.read(volume2, headerSize, 5);
+        BOOST_REQUIRE_EQUAL(reader.getNumSlabs(), 4u);
+        reader.waitForSlab(3);
+        reader.wait();
+        checkVolume(volume2);
+    }
+
+    BOOST_AUTO_TEST_CASE(Threads)
+    {
+        testBackend(IoBackend::Threads);
+    }
+
+    BOOST_AUTO_TEST_CASE(Auto)
+    {
+        testBackend(IoBackend::Auto);
+    }
+
+    BOOST_AUTO_TEST_CASE(Errors)
+    {
+        writeFile(100);
+        AsyncFileReader reader(filePath);
+        Volume volume(extents);
+        BOOST_REQUIRE_THROW(reader.read(volume, headerSize), std::runtime_error);
+        BOOST_REQUIRE_THROW(AsyncFileReader("doesNotExist.raw"), std::runtime_error);
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(RecoverAfterError)
+    {
+        const size_t numElements = extents[0] * extents[1] * extents[2];
+        writeFile(numElements);
+        AsyncReadOptions options;
+        options.requestSize = 16 * 1024;
+        AsyncFileReader reader(filePath, options);
+        Volume volume(extents);
+        BOOST_REQUIRE_THROW(reader.isSlabReady(0), std::out_of_range);
+        // File gets shorter after it was opened -> read fails partway
+        writeFile(numElements / 2);
+        reader.read(volume, headerSize);
+        BOOST_REQUIRE_THROW(reader.waitForSlab(extents[0] - 1), std::runtime_error);
+        BOOST_REQUIRE_THROW(reader.wait(), std::runtime_error);
+        BOOST_REQUIRE_THROW(reader.waitForSlab(extents[0]), std::out_of_range);
+        // Error is reported once, the next read succeeds
+        writeFile(numElements);
+        reader.read(volume, headerSize);
+        reader.wait();
+        checkVolume(volume);
+        // Error not reported by wait() is rethrown by the next read
+        writeFile(numElements / 2);
+        reader.read(volume, headerSize);
+        BOOST_REQUIRE_THROW(reader.read(volume, headerSize), std::runtime_error);
+        writeFile(numElements);
+        reader.read(volume, headerSize);
+        reader.wait();
+        checkVolume(volume);
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
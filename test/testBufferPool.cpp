@@ -0,0 +1,167 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#include "testUtils.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/mem/BufferPool.hpp"
+#include "libLiFFT/types/Expression.hpp"
+#include <boost/test/unit_test.hpp>
+#include <set>
+#include <thread>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(BufferPool)
+
+    using LiFFT::mem::PoolStatistics;
+
+    PoolStatistics
+    getPoolStats()
+    {
+        return LiFFT::mem::BufferPool::getInstance().getStatistics();
+    }
+
+    BOOST_AUTO_TEST_CASE(SizeClasses)
+    {
+        using Pool = LiFFT::mem::BufferPool;
+        for(size_t size: {size_t(1), size_t(255), size_t(1000), size_t(4097), size_t(8191), size_t(123456789)})
+        {
+            size_t sizeClass = Pool::getSizeClass(size);
+            BOOST_REQUIRE_GE(sizeClass, size);
+            // 16 classes per power of two -> at most 6.25% wasted
+            BOOST_REQUIRE_LE(sizeClass, std::max<size_t>(256, size + size / 16));
+            BOOST_REQUIRE_EQUAL(Pool::getSizeClass(sizeClass), sizeClass);
+        }
+        std::set<size_t> sizeClasses;
+        for(size_t size = 4097; size <= 8192; ++size)
+            sizeClasses.insert(Pool::getSizeClass(size));
+        BOOST_REQUIRE_EQUAL(sizeClasses.size(), 16u);
+    }
+
+    BOOST_AUTO_TEST_CASE(Reuse)
+    {
+        auto& pool = LiFFT::mem::BufferPool::getInstance();
+        pool.trim();
+        PoolStatistics before = getPoolStats();
+        void* first = pool.allocate(100000);
+        BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(first) % 64u, 0u);
+        BOOST_REQUIRE_EQUAL(getPoolStats().bytesInUse, before.bytesInUse + pool.getSizeClass(100000));
+        pool.release(first);
+        // Same size class -> same buffer
+        void* second = pool.allocate(99000);
+        BOOST_REQUIRE_EQUAL(first, second);
+        pool.release(second);
+        PoolStatistics after = getPoolStats();
+        BOOST_REQUIRE_EQUAL(after.numAllocations, before.numAllocations + 2);
+        BOOST_REQUIRE_EQUAL(after.numReused, before.numReused + 1);
+        BOOST_REQUIRE_EQUAL(after.bytesInUse, before.bytesInUse);
+        BOOST_REQUIRE_GE(after.peakBytesInUse, pool.getSizeClass(100000));
+        BOOST_REQUIRE_GT(after.bytesCached, 0u);
+        pool.trim();
+        BOOST_REQUIRE_EQUAL(getPoolStats().bytesCached, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(ReuseLargeBuffer)
+    {
+        auto& pool = LiFFT::mem::BufferPool::getInstance();
+        pool.trim();
+        // Larger than the minimum cache limit, e.g. a 1024^3 float volume (memory is never touched)
+        const size_t numBytes = (size_t(1) << 30) * 3 / 2;
+        void* first = pool.allocate(numBytes);
+        BOOST_REQUIRE_GE(pool.getMaxCachedBytes(), pool.getSizeClass(numBytes));
+        pool.release(first);
+        BOOST_REQUIRE_EQUAL(getPoolStats().bytesCached, pool.getSizeClass(numBytes));
+        PoolStatistics before = getPoolStats();
+        void* second = pool.allocate(numBytes);
+        BOOST_REQUIRE_EQUAL(first, second);
+        BOOST_REQUIRE_EQUAL(getPoolStats().numReused, before.numReused + 1);
+        pool.release(second);
+        pool.trim();
+    }
+
+    BOOST_AUTO_TEST_CASE(SharedBetweenThreads)
+    {
+        auto& pool = LiFFT::mem::BufferPool::getInstance();
+        pool.trim();
+        void* buffer = nullptr;
+        // Thread caches are returned to the shared cache on thread exit
+        std::thread([&pool, &buffer](){
+            buffer = pool.allocate(5000);
+            pool.release(buffer);
+        }).join();
+        void* reused = pool.allocate(5000);
+        BOOST_REQUIRE_EQUAL(buffer, reused);
+        pool.release(reused);
+        pool.trim();
+    }
+
+    /**
+     * Releases its buffer when destroyed
+     */
+    struct PooledBuffer
+    {
+        void* data = nullptr;
+
+        ~PooledBuffer()
+        {
+            LiFFT::mem::BufferPool::getInstance().release(data);
+        }
+    };
+
+    BOOST_AUTO_TEST_CASE(ReleaseAfterThreadCache)
+    {
+        auto& pool = LiFFT::mem::BufferPool::getInstance();
+        pool.trim();
+        PoolStatistics before = getPoolStats();
+        std::thread([&pool](){
+            // Constructed before the thread cache -> destroyed after it
+            static thread_local PooledBuffer buffer;
+            pool.release(pool.allocate(1000));
+            buffer.data = pool.allocate(3000);
+        }).join();
+        PoolStatistics after = getPoolStats();
+        BOOST_REQUIRE_EQUAL(after.bytesInUse, before.bytesInUse);
+        // Both buffers went to the shared cache
+        BOOST_REQUIRE_EQUAL(after.bytesCached, pool.getSizeClass(1000) + pool.getSizeClass(3000));
+        pool.trim();
+    }
+
+    BOOST_AUTO_TEST_CASE(FFTBuffers)
+    {
+        using FFT_Def = LiFFT::FFT_2D_R2C<TestPrecision>;
+        RealContainer input(TestExtents::all(128u));
+        LiFFT::generateData(input, LiFFT::generators::Rect<TestPrecision>(10, 64));
+        PoolStatistics before = getPoolStats();
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            // Expressions need internal memory, the output is newly created in each iteration
+            auto in = FFT_Def::wrapInput(LiFFT::types::makeExpr(input) * TestPrecision(i + 1));
+            auto out = FFT_Def::createNewOutput(in);
+            auto fft = LiFFT::makeFFT<TestLibrary, false>(in, out);
+            fft(in, out);
+        }
+        PoolStatistics after = getPoolStats();
+        BOOST_REQUIRE_EQUAL(after.bytesInUse, before.bytesInUse);
+        // 2 buffers per iteration, all but the first ones are reused
+        BOOST_REQUIRE_GE(after.numAllocations - before.numAllocations, 6u);
+        BOOST_REQUIRE_GE(after.numReused - before.numReused, 4u);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
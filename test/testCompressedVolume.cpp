@@ -0,0 +1,169 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/CompressedVolume.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using LiFFT::generateData;
+using namespace LiFFT::generators;
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(CompressedVolume)
+
+    using Extents = LiFFT::types::Vec<3>;
+    using RealVolume = LiFFT::mem::RealContainer<3, float>;
+    using CompressedReal = LiFFT::mem::CompressedVolume<3, float>;
+
+    const Extents extents(10u, 33u, 40u);
+
+    /**
+     * Smooth data in the middle, zero elsewhere
+     */
+    void
+    fillSmooth(RealVolume& data)
+    {
+        for(unsigned z = 0; z < extents[0]; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                    data(Extents(z, y, x)) = (y > 8 && y < 24) ? std::sin(0.1f * x + 0.2f * y + 0.3f * z) * 100.f : 0.f;
+    }
+
+    BOOST_AUTO_TEST_CASE(Lossless)
+    {
+        RealVolume data(extents);
+        fillSmooth(data);
+        LiFFT::mem::CompressionOptions options;
+        options.blockSize = 1000;
+        options.cacheSize = 2;
+        CompressedReal compressed(extents, options);
+        BOOST_REQUIRE_EQUAL(compressed.getNumBlocks(), (10u * 33u * 40u + 999u) / 1000u);
+        BOOST_REQUIRE_EQUAL(compressed(Extents(5u, 10u, 10u)), 0.f);
+        // Empty volume is tiny
+        BOOST_REQUIRE_LT(compressed.getCompressedSize() * 7, compressed.getMemSize());
+
+        compressed.assign(data);
+        BOOST_REQUIRE_LT(compressed.getCompressedSize(), compressed.getMemSize());
+        for(unsigned z = 0; z < extents[0]; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                    BOOST_REQUIRE_EQUAL(compressed(Extents(z, y, x)), data(Extents(z, y, x)));
+
+        RealVolume result(extents);
+        compressed.materialize(result);
+        checkResult(data, result, "Lossless roundtrip", CmpError(0, 0));
+
+        // Slab
+        RealVolume slab(Extents(3u, extents[1], extents[2]));
+        compressed.materialize(slab, 4, 3);
+        for(unsigned z = 0; z < 3; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                    BOOST_REQUIRE_EQUAL(slab(Extents(z, y, x)), data(Extents(z + 4, y, x)));
+        BOOST_REQUIRE_THROW(compressed.materialize(slab, 8, 3), std::runtime_error);
+        BOOST_REQUIRE_THROW(compressed.materialize(slab, 0, 4), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(ErrorBounded)
+    {
+        RealVolume data(extents);
+        fillSmooth(data);
+        LiFFT::mem::CompressionOptions options;
+        options.codec = LiFFT::mem::CompressionCodec::ErrorBounded;
+        options.errorBound = 1e-2;
+        CompressedReal compressed(extents, options);
+        compressed.assign(data);
+        CompressedReal lossless(extents);
+        lossless.assign(data);
+        BOOST_REQUIRE_LT(compressed.getCompressedSize(), lossless.getCompressedSize());
+
+        RealVolume result(extents);
+        compressed.materialize(result);
+        for(unsigned z = 0; z < extents[0]; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                {
+                    const float expected = data(Extents(z, y, x));
+                    BOOST_REQUIRE_LE(std::abs(result(Extents(z, y, x)) - expected), options.errorBound + std::abs(expected) * 1e-6);
+                }
+
+        // Blocks with values that cannot be quantized are stored lossless
+        data(Extents(1u, 1u, 1u)) = std::numeric_limits<float>::quiet_NaN();
+        data(Extents(1u, 1u, 2u)) = 1e30f;
+        compressed.assign(data);
+        BOOST_REQUIRE(std::isnan(compressed(Extents(1u, 1u, 1u))));
+        BOOST_REQUIRE_EQUAL(compressed(Extents(1u, 1u, 2u)), 1e30f);
+
+        options.errorBound = 0;
+        BOOST_REQUIRE_THROW(CompressedReal(extents, options), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(Incompressible)
+    {
+        RealVolume data(extents);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        for(unsigned z = 0; z < extents[0]; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                    data(Extents(z, y, x)) = dist(rng);
+        for(LiFFT::mem::CompressionCodec codec: {LiFFT::mem::CompressionCodec::Lossless, LiFFT::mem::CompressionCodec::ErrorBounded})
+        {
+            LiFFT::mem::CompressionOptions options;
+            options.codec = codec;
+            options.errorBound = 1e-9;
+            options.blockSize = 1000;
+            CompressedReal compressed(extents, options);
+            compressed.assign(data);
+            // Noise is stored uncompressed, only the codec byte per block is added
+            BOOST_REQUIRE_LE(compressed.getCompressedSize(), compressed.getMemSize() + compressed.getNumBlocks());
+            RealVolume result(extents);
+            compressed.materialize(result);
+            checkResult(data, result, "Incompressible roundtrip", CmpError(0, 0));
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(FFT)
+    {
+        using FFT_Type = LiFFT::FFT_3D_R2C_F<>;
+        auto input = FFT_Type::wrapInput(RealVolume(extents));
+        fillSmooth(input.getBase());
+        auto output = FFT_Type::createNewOutput(input);
+        auto fft = LiFFT::makeFFT<TestLibrary>(input, output);
+        fft(input, output);
+
+        // Keep the complex result compressed between stages
+        using CompressedComplex = LiFFT::mem::CompressedVolume<3, float, true>;
+        CompressedComplex compressed(output.getExtents());
+        compressed.assign(output.getBase());
+        LiFFT::mem::ComplexContainer<3, float> result(output.getExtents());
+        compressed.materialize(result);
+        checkResult(output.getBase(), result, "Complex roundtrip", CmpError(0, 0));
+        BOOST_REQUIRE_EQUAL(LiFFT::types::Complex<float>(compressed(Extents(1u, 2u, 3u))).imag,
+                            LiFFT::types::Complex<float>(result(Extents(1u, 2u, 3u))).imag);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
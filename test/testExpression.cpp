@@ -0,0 +1,129 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/types/Expression.hpp"
+#include "libLiFFT/types/View.hpp"
+#include "libLiFFT/accessors/TransposeAccessor.hpp"
+#include <boost/test/unit_test.hpp>
+
+using LiFFT::generateData;
+using namespace LiFFT::generators;
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(Expression)
+
+    using LiFFT::types::makeExpr;
+
+    BOOST_AUTO_TEST_CASE(MultiplyConj)
+    {
+        const TestExtents extents(77u, 131u);
+        ComplexContainer a(extents), b(extents), result(extents);
+        TestExtents idx;
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+            {
+                a(idx) = LiFFT::types::Complex<TestPrecision>(idx[0] * 0.5f, idx[1] - 3.f);
+                b(idx) = LiFFT::types::Complex<TestPrecision>(idx[1] * 0.25f, 1.f - idx[0]);
+            }
+        auto expr = makeExpr(a) * conj(makeExpr(b)) + 1;
+        static_assert(decltype(expr)::isFlat, "Plain containers should be evaluated with a flat index");
+        LiFFT::types::assign(result, expr);
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+            {
+                TestPrecision ar = a(idx).real, ai = a(idx).imag, br = b(idx).real, bi = b(idx).imag;
+                BOOST_REQUIRE_CLOSE(TestPrecision(result(idx).real), ar * br + ai * bi + 1, 1e-4);
+                BOOST_REQUIRE_CLOSE(TestPrecision(result(idx).imag), ai * br - ar * bi, 1e-4);
+            }
+    }
+
+    BOOST_AUTO_TEST_CASE(ShiftedIntensity)
+    {
+        const TestExtents extents(64u, 128u);
+        ComplexContainer a(extents);
+        RealContainer result(extents), expected(extents);
+        generateData(a, Cosinus<TestPrecision>(64, 32));
+        auto view = LiFFT::types::makeView(a, LiFFT::types::makeRange());
+        auto expr = abs2(fftShift(scale(makeExpr(view), 2)));
+        static_assert(!decltype(expr)::isFlat, "Views/shifts require index based evaluation");
+        LiFFT::types::assign(result, expr, 3);
+        auto acc = LiFFT::accessors::makeTransposeAccessorFor(a);
+        TestExtents idx;
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+            {
+                auto val = acc(idx, a);
+                expected(idx) = 4 * (val.real * val.real + val.imag * val.imag);
+            }
+        checkResult(expected, result, "Shifted intensity");
+    }
+
+    BOOST_AUTO_TEST_CASE(NegativeShift)
+    {
+        const TestExtents extents(7u, 10u);
+        RealContainer a(extents), result(extents);
+        TestExtents idx;
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+                a(idx) = TestPrecision(idx[0] * extents[1] + idx[1]);
+        // -1 and -13 are the same as 6 and 7
+        LiFFT::types::assign(result, shift(makeExpr(a), LiFFT::types::Vec<2, int>(-1, -13)));
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+            {
+                const TestExtents srcIdx((idx[0] + 1) % extents[0], (idx[1] + 3) % extents[1]);
+                BOOST_REQUIRE_EQUAL(TestPrecision(result(idx)), TestPrecision(a(srcIdx)));
+            }
+    }
+
+    BOOST_AUTO_TEST_CASE(InPlaceShift)
+    {
+        // Large enough to be split over multiple threads
+        const TestExtents extents(301u, 256u);
+        RealContainer a(extents), expected(extents);
+        TestExtents idx;
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+                a(idx) = TestPrecision(idx[0] * extents[1] + idx[1]);
+        LiFFT::types::assign(expected, fftShift(makeExpr(a)) - makeExpr(a));
+        LiFFT::types::assign(a, fftShift(makeExpr(a)) - makeExpr(a));
+        for(idx[0] = 0; idx[0] < extents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < extents[1]; ++idx[1])
+                BOOST_REQUIRE_EQUAL(TestPrecision(a(idx)), TestPrecision(expected(idx)));
+    }
+
+    BOOST_AUTO_TEST_CASE(ExpressionAsInput)
+    {
+        RealContainer input1(TestExtents::all(testSize));
+        RealContainer input2(TestExtents::all(testSize));
+        generateData(input1, Rect<TestPrecision>(20, testSize/2));
+        generateData(input2, Cosinus<TestPrecision>(testSize, testSize/2));
+        using FFT_Type = LiFFT::FFT_2D_R2C<TestPrecision>;
+        auto input = FFT_Type::wrapInput(makeExpr(input1) * makeExpr(input2));
+        auto output = FFT_Type::createNewOutput(input);
+        auto fft = LiFFT::makeFFT<TestLibrary>(input, output);
+        fft(input, output);
+        LiFFT::types::assign(baseR2CInput, makeExpr(input1) * makeExpr(input2));
+        execBaseR2C();
+        checkResult(baseR2COutput, output, "R2C with expression input");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}  // namespace LiFFTTest
@@ -20,11 +20,19 @@
 #include "libLiFFT/mem/FileContainer.hpp"
 #include "libLiFFT/accessors/ImageAccessor.hpp"
 #include "tiffWriter/image.hpp"
+#include "tiffWriter/multiPageImage.hpp"
+#include "tiffWriter/pyramid.hpp"
+#include "tiffWriter/rowConverters.hpp"
 #include "tiffWriter/traitsAndPolicies.hpp"
 #include "libLiFFT/FFT.hpp"
 #include "libLiFFT/generateData.hpp"
 #include "libLiFFT/accessors/TransposeAccessor.hpp"
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
 
 
 using LiFFT::generateData;
@@ -105,6 +113,610 @@ namespace LiFFTTest {
         checkResult(baseR2COutput, output, "TIFF test");
     }
 
+    /**
+     * Writes a float image with strips of multiple rows or with tiles directly via libtiff
+     */
+    void
+    writeChunkedTiff(const std::string& filePath, unsigned w, unsigned h, unsigned tileSize, unsigned rowsPerStrip)
+    {
+        TIFF* handle = TIFFOpen(filePath.c_str(), "w");
+        BOOST_REQUIRE(handle);
+        TIFFSetField(handle, TIFFTAG_IMAGEWIDTH, w);
+        TIFFSetField(handle, TIFFTAG_IMAGELENGTH, h);
+        TIFFSetField(handle, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(handle, TIFFTAG_BITSPERSAMPLE, 32);
+        TIFFSetField(handle, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+        TIFFSetField(handle, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(handle, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(handle, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        if(tileSize)
+        {
+            TIFFSetField(handle, TIFFTAG_TILEWIDTH, tileSize);
+            TIFFSetField(handle, TIFFTAG_TILELENGTH, tileSize);
+            std::vector<float> tile(tileSize * tileSize);
+            for(unsigned ty = 0; ty < h; ty += tileSize)
+                for(unsigned tx = 0; tx < w; tx += tileSize)
+                {
+                    for(unsigned y = 0; y < tileSize; ++y)
+                        for(unsigned x = 0; x < tileSize; ++x)
+                            tile[y * tileSize + x] = (ty + y) * w + tx + x;
+                    BOOST_REQUIRE(TIFFWriteTile(handle, tile.data(), tx, ty, 0, 0) >= 0);
+                }
+        }else
+        {
+            TIFFSetField(handle, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
+            std::vector<float> row(w);
+            for(unsigned y = 0; y < h; ++y)
+            {
+                for(unsigned x = 0; x < w; ++x)
+                    row[x] = y * w + x;
+                BOOST_REQUIRE(TIFFWriteScanline(handle, row.data(), y) == 1);
+            }
+        }
+        TIFFClose(handle);
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffRegion)
+    {
+        const std::string filePath = "chunked.tif";
+        const unsigned w = 70, h = 45;
+        // Strips of 1 and multiple rows and tiles not aligned to the image extents
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            writeChunkedTiff(filePath, w, h, i == 2 ? 16 : 0, i == 0 ? 1 : 7);
+            tiffWriter::FloatImage<> full(filePath);
+            BOOST_REQUIRE_EQUAL(full.getWidth(), w);
+            BOOST_REQUIRE_EQUAL(full.getHeight(), h);
+            for(unsigned y = 0; y < h; ++y)
+                for(unsigned x = 0; x < w; ++x)
+                    BOOST_REQUIRE_EQUAL(full(x, y), y * w + x);
+
+            tiffWriter::FloatImage<> region;
+            region.openRegion(filePath, 13, 9, 40, 30);
+            BOOST_REQUIRE_EQUAL(region.getWidth(), 40u);
+            BOOST_REQUIRE_EQUAL(region.getHeight(), 30u);
+            BOOST_REQUIRE_EQUAL(region.getFileWidth(), w);
+            BOOST_REQUIRE_EQUAL(region.getFileHeight(), h);
+            for(unsigned y = 0; y < 30; ++y)
+                for(unsigned x = 0; x < 40; ++x)
+                    BOOST_REQUIRE_EQUAL(region(x, y), (y + 9) * w + x + 13);
+            BOOST_REQUIRE_THROW(region.openRegion(filePath, 40, 0, 31, 1), std::runtime_error);
+            // Offsets outside the image, also where offset + size wraps around
+            BOOST_REQUIRE_THROW(region.openRegion(filePath, w, 0, 1, 1), std::runtime_error);
+            BOOST_REQUIRE_THROW(region.openRegion(filePath, ~0u - 15, 0, 32, 1), std::runtime_error);
+            BOOST_REQUIRE_THROW(region.openRegion(filePath, 0, ~0u - 15, 1, 32), std::runtime_error);
+            unsigned fileWidth = 0, fileHeight = 0;
+            tiffWriter::FloatImage<>::readFileExtents(filePath, fileWidth, fileHeight);
+            BOOST_REQUIRE_EQUAL(fileWidth, w);
+            BOOST_REQUIRE_EQUAL(fileHeight, h);
+        }
+        std::remove(filePath.c_str());
+
+        // Conversion from (A)RGB
+        tiffWriter::FloatImage<> full("rect.tif");
+        tiffWriter::FloatImage<> region;
+        region.openRegion("rect.tif", 3, 5, full.getWidth() - 4, full.getHeight() - 7);
+        for(unsigned y = 0; y < region.getHeight(); ++y)
+            for(unsigned x = 0; x < region.getWidth(); ++x)
+                BOOST_REQUIRE_EQUAL(region(x, y), full(x + 3, y + 5));
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffParallelDecode)
+    {
+        const std::string filePath = "chunkedLarge.tif";
+        const unsigned w = 1000, h = 1100;
+        for(unsigned i = 0; i < 2; ++i)
+        {
+            writeChunkedTiff(filePath, w, h, i == 1 ? 64 : 0, 8);
+            for(unsigned numThreads: {1u, 3u, 0u})
+            {
+                tiffWriter::FloatImage<> img;
+                img.setNumThreads(numThreads);
+                img.open(filePath);
+                unsigned numErrors = 0;
+                for(unsigned y = 0; y < h; ++y)
+                    for(unsigned x = 0; x < w; ++x)
+                        numErrors += img(x, y) != y * w + x;
+                img.openRegion(filePath, 100, 37, 800, 1000);
+                for(unsigned y = 0; y < 1000; ++y)
+                    for(unsigned x = 0; x < 800; ++x)
+                        numErrors += img(x, y) != (y + 37) * w + x + 100;
+                BOOST_REQUIRE_EQUAL(numErrors, 0u);
+            }
+        }
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffWriteOptions)
+    {
+        using tiffWriter::Compression;
+        using tiffWriter::Predictor;
+        const std::string filePath = "writeOptions.tif";
+        // Large enough to be encoded by 2 threads
+        const unsigned w = 1024, h = 600;
+        tiffWriter::FloatImage<> img(filePath, w, h);
+        for(unsigned y = 0; y < h; ++y)
+            for(unsigned x = 0; x < w; ++x)
+                img(x, y) = std::sin(x * 0.01f) * y;
+        std::vector<Compression> compressions = {Compression::None, Compression::LZW, Compression::Deflate};
+#ifdef COMPRESSION_ZSTD
+        compressions.push_back(Compression::ZSTD);
+#else
+        BOOST_REQUIRE_THROW(img.saveTo(filePath, tiffWriter::WriteOptions(Compression::ZSTD)), tiffWriter::FormatException);
+#endif
+        for(Compression compression: compressions)
+        {
+            for(unsigned layout = 0; layout < 3; ++layout)
+            {
+                for(unsigned numThreads: {1u, 3u})
+                {
+                    tiffWriter::WriteOptions options(compression, Predictor::FloatingPoint);
+                    if(compression == Compression::LZW)
+                        options.predictor = Predictor::Horizontal;
+                    options.rowsPerStrip = (layout == 1) ? 7 : 0;
+                    options.tileSize = (layout == 2) ? 48 : 0;
+                    options.numThreads = numThreads;
+                    options.level = (compression == Compression::Deflate) ? 9 : 0;
+                    img.saveTo(filePath, options);
+                    img.flush();
+                    tiffWriter::FloatImage<> img2(filePath);
+                    BOOST_REQUIRE_EQUAL(img2.getWidth(), w);
+                    BOOST_REQUIRE_EQUAL(img2.getHeight(), h);
+                    unsigned numErrors = 0;
+                    for(unsigned y = 0; y < h; ++y)
+                        for(unsigned x = 0; x < w; ++x)
+                            numErrors += img2(x, y) != img(x, y);
+                    BOOST_REQUIRE_EQUAL(numErrors, 0u);
+                }
+            }
+        }
+        tiffWriter::WriteOptions invalid;
+        invalid.tileSize = 20;
+        BOOST_REQUIRE_THROW(img.saveTo(filePath, invalid), tiffWriter::FormatException);
+        img.close();
+
+        // (A)RGB is written as RGB or ARGB
+        tiffWriter::Image<> argb(filePath, 40, 30);
+        for(unsigned y = 0; y < 30; ++y)
+            for(unsigned x = 0; x < 40; ++x)
+                argb(x, y) = 0xFF000000u | (x << 16) | (y << 8) | (x + y);
+        for(bool saveAsARGB: {false, true})
+        {
+            argb.saveTo(filePath, tiffWriter::WriteOptions(Compression::Deflate, Predictor::Horizontal), saveAsARGB);
+            argb.flush();
+            tiffWriter::Image<> argb2(filePath);
+            unsigned numErrors = 0;
+            for(unsigned y = 0; y < 30; ++y)
+                for(unsigned x = 0; x < 40; ++x)
+                    numErrors += argb2(x, y) != argb(x, y);
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+        }
+        argb.close();
+        std::remove(filePath.c_str());
+    }
+
+    /**
+     * Returns the version from the header of a TIFF file (42: classic, 43: BigTIFF)
+     */
+    unsigned
+    getTiffVersion(const std::string& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        unsigned char header[4] = {};
+        file.read(reinterpret_cast<char*>(header), 4);
+        // Byte order is given by the first 2 bytes: "II" little endian, "MM" big endian
+        return (header[0] == 'I') ? header[2] | (header[3] << 8) : header[3] | (header[2] << 8);
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffBigTiff)
+    {
+        using tiffWriter::BigTiff;
+        tiffWriter::WriteOptions options;
+        BOOST_REQUIRE(!tiffWriter::isBigTiffRequired(options, 1024u * 1024u * 4u));
+        BOOST_REQUIRE(tiffWriter::isBigTiffRequired(options, uint64_t(5) << 30));
+        options.bigTiff = BigTiff::Never;
+        BOOST_REQUIRE(!tiffWriter::isBigTiffRequired(options, uint64_t(5) << 30));
+        options.bigTiff = BigTiff::Always;
+        BOOST_REQUIRE(tiffWriter::isBigTiffRequired(options, 16));
+
+        const std::string filePath = "bigTiff.tif";
+        const unsigned w = 100, h = 60;
+        for(BigTiff bigTiff: {BigTiff::Auto, BigTiff::Always})
+        {
+            options.bigTiff = bigTiff;
+            {
+                tiffWriter::FloatImage<> img(filePath, w, h);
+                for(unsigned y = 0; y < h; ++y)
+                    for(unsigned x = 0; x < w; ++x)
+                        img(x, y) = y * w + x;
+                img.save(options);
+                BOOST_REQUIRE_EQUAL(img.isBigTiff(), bigTiff == BigTiff::Always);
+                // Saving again reopens the file
+                img.save(options);
+            }
+            BOOST_REQUIRE_EQUAL(getTiffVersion(filePath), bigTiff == BigTiff::Always ? 43u : 42u);
+            tiffWriter::FloatImage<> img(filePath);
+            unsigned numErrors = 0;
+            for(unsigned y = 0; y < h; ++y)
+                for(unsigned x = 0; x < w; ++x)
+                    numErrors += img(x, y) != y * w + x;
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+            img.close();
+
+            {
+                tiffWriter::FloatMultiPageImage<> volume(filePath, w, h, 3, options);
+                for(unsigned z = 0; z < 3; ++z)
+                    volume(1, 2, z) = z + 1.f;
+                volume.save();
+            }
+            BOOST_REQUIRE_EQUAL(getTiffVersion(filePath), bigTiff == BigTiff::Always ? 43u : 42u);
+            tiffWriter::FloatMultiPageImage<> volume(filePath);
+            BOOST_REQUIRE_EQUAL(volume.getNumPages(), 3u);
+            for(unsigned z = 0; z < 3; ++z)
+                BOOST_REQUIRE_EQUAL(volume(1, 2, z), z + 1.f);
+        }
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffMapped)
+    {
+        const std::string filePath = "mapped.tif";
+        const unsigned w = 70, h = 50;
+        tiffWriter::WriteOptions options(tiffWriter::Compression::None);
+        options.rowsPerStrip = 8;
+        {
+            tiffWriter::DoubleImage<> img(filePath, w, h);
+            for(unsigned y = 0; y < h; ++y)
+                for(unsigned x = 0; x < w; ++x)
+                    img(x, y) = y * w + x;
+            img.save(options);
+        }
+        tiffWriter::DoubleImage<> img(filePath);
+        BOOST_REQUIRE(img.isMapped());
+        unsigned numErrors = 0;
+        for(unsigned y = 0; y < h; ++y)
+            for(unsigned x = 0; x < w; ++x)
+                numErrors += img(x, y) != y * w + x;
+        BOOST_REQUIRE_EQUAL(numErrors, 0u);
+
+        // Full rows of a region are mapped, others are read
+        img.openRegion(filePath, 0, 9, w, 30);
+        BOOST_REQUIRE(img.isMapped());
+        BOOST_REQUIRE_EQUAL(img(3, 2), 11 * w + 3);
+        img.openRegion(filePath, 1, 9, 40, 30);
+        BOOST_REQUIRE(!img.isMapped());
+        BOOST_REQUIRE_EQUAL(img(3, 2), 11 * w + 4);
+        img.close();
+
+        // Allocated memory is reused (and stays valid) when loading
+        img.open(filePath, false);
+        const double* data = &img(0, 0);
+        img.load();
+        BOOST_REQUIRE(!img.isMapped());
+        BOOST_REQUIRE_EQUAL(&img(0, 0), data);
+        BOOST_REQUIRE_EQUAL(img(5, 7), 7 * w + 5);
+        img.close();
+
+        // Changes are copy-on-write and can be saved to the mapped file
+        img.open(filePath);
+        BOOST_REQUIRE(img.isMapped());
+        img(5, 7) = -1;
+        {
+            tiffWriter::DoubleImage<> other(filePath);
+            BOOST_REQUIRE_EQUAL(other(5, 7), 7 * w + 5);
+        }
+        img.saveTo(filePath, options);
+        BOOST_REQUIRE(!img.isMapped());
+        img.close();
+        img.open(filePath);
+        BOOST_REQUIRE_EQUAL(img(5, 7), -1);
+        BOOST_REQUIRE_EQUAL(img(6, 7), 7 * w + 6);
+
+        // Disabling the mapping copies mapped data and reads files afterwards
+        BOOST_REQUIRE(img.isMapped());
+        img(6, 7) = -2;
+        img.setMapping(false);
+        BOOST_REQUIRE(!img.isMapped());
+        BOOST_REQUIRE_EQUAL(img(5, 7), -1);
+        BOOST_REQUIRE_EQUAL(img(6, 7), -2);
+        img.open(filePath);
+        BOOST_REQUIRE(!img.isMapped());
+        BOOST_REQUIRE_EQUAL(img(6, 7), 7 * w + 6);
+        img.close();
+        img.setMapping(true);
+        img.open(filePath);
+        BOOST_REQUIRE(img.isMapped());
+        img.close();
+
+        // Compressed and tiled files are read
+        tiffWriter::FloatImage<> floatImg(filePath, w, h);
+        floatImg(1, 2) = 3;
+        floatImg.save(tiffWriter::WriteOptions(tiffWriter::Compression::LZW));
+        floatImg.close();
+        floatImg.open(filePath);
+        BOOST_REQUIRE(!floatImg.isMapped());
+        BOOST_REQUIRE_EQUAL(floatImg(1, 2), 3);
+        floatImg.open(filePath, w, h);
+        floatImg(1, 2) = 4;
+        options.tileSize = 16;
+        floatImg.save(options);
+        floatImg.close();
+        floatImg.open(filePath);
+        BOOST_REQUIRE(!floatImg.isMapped());
+        BOOST_REQUIRE_EQUAL(floatImg(1, 2), 4);
+        floatImg.close();
+        std::remove(filePath.c_str());
+    }
+
+    /**
+     * Converts a row with the vectorized converter and compares it to the scalar one, returns the number of differences
+     */
+    template< template< class... > class T_ConvertRow, typename T_Src, typename T_Dest, uint16_t T_numChannels, bool T_minIsBlack >
+    unsigned
+    checkConvertRow(unsigned numPixels)
+    {
+        using Conv = tiffWriter::Convert< T_Src, T_Dest, T_numChannels, 1, T_minIsBlack >;
+        std::vector<T_Src> src(numPixels * T_numChannels);
+        for(size_t i = 0; i < src.size(); ++i)
+            src[i] = std::is_floating_point<T_Src>::value ? T_Src(i % 97) / 97 : static_cast<T_Src>(i * 2654435761u);
+        std::vector<T_Dest> dst(numPixels);
+        unsigned x = T_ConvertRow<Conv>::apply(src.data(), dst.data(), numPixels);
+        Conv conv;
+        for(; x < numPixels; ++x)
+            dst[x] = conv(src[x * T_numChannels]);
+        unsigned numErrors = 0;
+        for(x = 0; x < numPixels; ++x)
+        {
+            // The scalar version might be contracted to FMAs
+            const T_Dest expected = conv(src[x * T_numChannels]);
+            numErrors += std::abs(dst[x] - expected) > 1e-5 * std::max<T_Dest>(1, std::abs(expected));
+        }
+        return numErrors;
+    }
+
+    /**
+     * Checks the row converters of one instruction set
+     */
+    template< template< class... > class T_ConvertRow >
+    void
+    checkConvertRows()
+    {
+        for(unsigned numPixels: {1u, 8u, 9u, 37u})
+        {
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint8_t, float, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint8_t, float, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int8_t, double, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint16_t, float, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint16_t, double, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int16_t, float, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint32_t, float, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint32_t, double, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int32_t, float, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int32_t, double, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, float, float, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, double, float, 1, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, float, double, 1, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint8_t, float, 3, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint8_t, float, 4, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint16_t, double, 3, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint16_t, float, 4, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int8_t, float, 3, false>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int16_t, double, 4, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, uint32_t, float, 3, true>(numPixels)), 0u);
+            BOOST_REQUIRE_EQUAL((checkConvertRow<T_ConvertRow, int32_t, double, 4, false>(numPixels)), 0u);
+        }
+    }
+
+    /**
+     * Checks a function packing ARGB to RGB pixels
+     */
+    void
+    checkPackRGB(unsigned (*packRGB)(const uint32_t*, uint8_t*, unsigned))
+    {
+        for(unsigned numPixels: {1u, 8u, 9u, 37u})
+        {
+            std::vector<uint32_t> argb(numPixels);
+            for(unsigned x = 0; x < numPixels; ++x)
+                argb[x] = x * 2654435761u;
+            std::vector<uint8_t> rgb(numPixels * 3);
+            unsigned x = packRGB(argb.data(), rgb.data(), numPixels);
+            BOOST_REQUIRE_LE(x, numPixels);
+            unsigned numErrors = 0;
+            for(unsigned i = 0; i < x; ++i)
+                numErrors += rgb[i*3] != TIFFGetR(argb[i]) || rgb[i*3+1] != TIFFGetG(argb[i]) || rgb[i*3+2] != TIFFGetB(argb[i]);
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffRowConverters)
+    {
+        checkConvertRows<tiffWriter::ConvertRow>();
+        checkConvertRows<tiffWriter::detail::ConvertRowSse2>();
+        checkPackRGB(tiffWriter::packRGB);
+#if defined(__SSE2__)
+        // 32 bit integers are vectorized too
+        std::vector<uint32_t> src(37, 0xFFFFFFFFu);
+        std::vector<float> dst(37);
+        BOOST_REQUIRE_EQUAL((tiffWriter::detail::ConvertRowSse2< tiffWriter::Convert< uint32_t, float, 1, 1, true > >::apply(src.data(), dst.data(), 37u)), 36u);
+        BOOST_REQUIRE_EQUAL(dst[35], 1.f);
+#endif
+#if defined(LiFFT_X86_DISPATCH)
+        const LiFFT::CpuFeatures& cpu = LiFFT::getCpuFeatures();
+        if(cpu.avx2)
+        {
+            checkConvertRows<tiffWriter::detail::ConvertRowAvx2>();
+            checkPackRGB(tiffWriter::detail::packRGBAvx2);
+        }
+        if(cpu.f16c)
+            checkConvertRows<tiffWriter::detail::ConvertRowAvx2F16c>();
+        if(cpu.ssse3)
+            checkPackRGB(tiffWriter::detail::packRGBSsse3);
+#endif
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffHalfFloat)
+    {
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::fromFloat(1.f), 0x3C00);
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::fromFloat(-2.5f), 0xC100);
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::fromFloat(65520.f), 0x7C00);
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::fromFloat(std::ldexp(1.f, -24)), 0x0001);
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::toFloat(0x3555), 0.333251953125f);
+        BOOST_REQUIRE_EQUAL(tiffWriter::Half::toFloat(0x0200), std::ldexp(1.f, -15));
+        for(uint32_t bits = 0; bits < 0x7C00; ++bits)
+            BOOST_REQUIRE_EQUAL(tiffWriter::Half::fromFloat(tiffWriter::Half::toFloat(bits)), bits);
+
+        const std::string filePath = "half.tif";
+        const unsigned w = 67, h = 45;
+        for(tiffWriter::Compression compression: {tiffWriter::Compression::None, tiffWriter::Compression::Deflate})
+        {
+            tiffWriter::WriteOptions options(compression, tiffWriter::Predictor::FloatingPoint);
+            options.halfFloat = true;
+            {
+                tiffWriter::DoubleImage<> img(filePath, w, h);
+                for(unsigned y = 0; y < h; ++y)
+                    for(unsigned x = 0; x < w; ++x)
+                        img(x, y) = (y * w + x) / 7.;
+                img.save(options);
+            }
+            TIFF* handle = TIFFOpen(filePath.c_str(), "r");
+            BOOST_REQUIRE(handle);
+            uint16 bitsPerSample = 0;
+            TIFFGetField(handle, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+            TIFFClose(handle);
+            BOOST_REQUIRE_EQUAL(bitsPerSample, 16u);
+
+            tiffWriter::FloatImage<> img(filePath);
+            BOOST_REQUIRE(!img.isMapped());
+            unsigned numErrors = 0;
+            for(unsigned y = 0; y < h; ++y)
+                for(unsigned x = 0; x < w; ++x)
+                    numErrors += img(x, y) != tiffWriter::Half(float((y * w + x) / 7.));
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+        }
+        std::remove(filePath.c_str());
+
+        for(unsigned numPixels: {7u, 8u, 37u})
+        {
+            std::vector<float> values(numPixels);
+            for(unsigned i = 0; i < numPixels; ++i)
+                values[i] = std::ldexp(float(i) - 20.f, int(i % 40) - 20) / 3.f;
+            std::vector<tiffWriter::Half> halfs(numPixels);
+            unsigned x = tiffWriter::packHalf(values.data(), halfs.data(), numPixels);
+            for(; x < numPixels; ++x)
+                halfs[x] = tiffWriter::Half(values[x]);
+            using Conv = tiffWriter::Convert< tiffWriter::Half, float, 1, 1, false >;
+            std::vector<float> inverted(numPixels);
+            x = tiffWriter::ConvertRow<Conv>::apply(halfs.data(), inverted.data(), numPixels);
+            for(; x < numPixels; ++x)
+                inverted[x] = Conv()(halfs[x]);
+            unsigned numErrors = 0;
+            for(unsigned i = 0; i < numPixels; ++i)
+            {
+                numErrors += halfs[i].bits != tiffWriter::Half::fromFloat(values[i]);
+                numErrors += inverted[i] != 1.f - tiffWriter::Half::toFloat(halfs[i].bits);
+            }
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(TiffPyramid)
+    {
+        const unsigned w = 100, h = 70;
+        std::vector<float> data(w * h);
+        for(unsigned i = 0; i < w * h; ++i)
+            data[i] = float(i % 251) / 3.f;
+        tiffWriter::WriteOptions options(tiffWriter::Compression::Deflate);
+        options.tileSize = 16;
+        options.numPyramidLevels = 10;
+        // The 3rd level (13x9) fits into a tile
+        const unsigned numLevels = tiffWriter::getNumPyramidLevels(w, h, options);
+        BOOST_REQUIRE_EQUAL(numLevels, 3u);
+
+        const auto levels = tiffWriter::buildPyramid(data.data(), w, h, numLevels, 3);
+        BOOST_REQUIRE_EQUAL(levels.size(), numLevels);
+        BOOST_REQUIRE_EQUAL(levels[2].width, 13u);
+        BOOST_REQUIRE_EQUAL(levels[2].height, 9u);
+        unsigned srcWidth = w, srcHeight = h;
+        const float* src = data.data();
+        for(const auto& level: levels)
+        {
+            unsigned numErrors = 0;
+            for(unsigned y = 0; y < level.height; ++y)
+            {
+                for(unsigned x = 0; x < level.width; ++x)
+                {
+                    const unsigned x1 = std::min(2 * x + 1, srcWidth - 1), y1 = std::min(2 * y + 1, srcHeight - 1);
+                    const float expected = (src[2*y*srcWidth + 2*x] + src[2*y*srcWidth + x1] + src[y1*srcWidth + 2*x] + src[y1*srcWidth + x1]) / 4.f;
+                    numErrors += level.data[y * level.width + x] != expected;
+                }
+            }
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+            src = level.data.data();
+            srcWidth = level.width;
+            srcHeight = level.height;
+        }
+        BOOST_REQUIRE_EQUAL(tiffWriter::detail::average4(0xFF000001u, 0x01000002u, 0x80000003u, 0x00FF0004u), 0x60400003u);
+
+        const std::string filePath = "pyramid.tif";
+        {
+            tiffWriter::FloatImage<> img(filePath, w, h);
+            std::copy(data.begin(), data.end(), &img(0, 0));
+            img.save(options);
+        }
+        TIFF* handle = TIFFOpen(filePath.c_str(), "r");
+        BOOST_REQUIRE(handle);
+        uint16 numSubIFDs = 0;
+        toff_t* subIFDs = nullptr;
+        BOOST_REQUIRE(TIFFGetField(handle, TIFFTAG_SUBIFD, &numSubIFDs, &subIFDs));
+        BOOST_REQUIRE_EQUAL(numSubIFDs, numLevels);
+        const std::vector<toff_t> offsets(subIFDs, subIFDs + numSubIFDs);
+        for(unsigned i = 0; i < numLevels; ++i)
+        {
+            BOOST_REQUIRE(TIFFSetSubDirectory(handle, offsets[i]));
+            uint32 levelWidth = 0, levelHeight = 0, subFileType = 0;
+            TIFFGetField(handle, TIFFTAG_IMAGEWIDTH, &levelWidth);
+            TIFFGetField(handle, TIFFTAG_IMAGELENGTH, &levelHeight);
+            TIFFGetField(handle, TIFFTAG_SUBFILETYPE, &subFileType);
+            BOOST_REQUIRE_EQUAL(levelWidth, levels[i].width);
+            BOOST_REQUIRE_EQUAL(levelHeight, levels[i].height);
+            BOOST_REQUIRE_EQUAL(subFileType, uint32(FILETYPE_REDUCEDIMAGE));
+            BOOST_REQUIRE(TIFFIsTiled(handle));
+            std::vector<float> tile(options.tileSize * options.tileSize);
+            unsigned numErrors = 0;
+            for(unsigned y = 0; y < levelHeight; y += options.tileSize)
+            {
+                for(unsigned x = 0; x < levelWidth; x += options.tileSize)
+                {
+                    BOOST_REQUIRE(TIFFReadTile(handle, tile.data(), x, y, 0, 0) > 0);
+                    for(unsigned ty = 0; ty < options.tileSize && y + ty < levelHeight; ++ty)
+                        for(unsigned tx = 0; tx < options.tileSize && x + tx < levelWidth; ++tx)
+                            numErrors += tile[ty * options.tileSize + tx] != levels[i].data[(y + ty) * levelWidth + x + tx];
+                }
+            }
+            BOOST_REQUIRE_EQUAL(numErrors, 0u);
+        }
+        TIFFClose(handle);
+        {
+            tiffWriter::FloatImage<> img(filePath);
+            BOOST_REQUIRE_EQUAL(img.getNumPages(), 1u);
+            BOOST_REQUIRE_EQUAL(img.getWidth(), w);
+            BOOST_REQUIRE(std::equal(data.begin(), data.end(), &img(0, 0)));
+        }
+
+        // Each page gets its own pyramid
+        {
+            tiffWriter::FloatMultiPageImage<> volume(filePath, w, h, 2, options);
+            for(unsigned z = 0; z < 2; ++z)
+                volume(1, 2, z) = z + 1.f;
+            volume.save();
+        }
+        tiffWriter::FloatMultiPageImage<> volume(filePath);
+        BOOST_REQUIRE_EQUAL(volume.getNumPages(), 2u);
+        for(unsigned z = 0; z < 2; ++z)
+            BOOST_REQUIRE_EQUAL(volume(1, 2, z), z + 1.f);
+        std::remove(filePath.c_str());
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace LiFFTTest
@@ -0,0 +1,169 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/ImageStackContainer.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "tiffWriter/image.hpp"
+#include "tiffWriter/traitsAndPolicies.hpp"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(ImageStack)
+
+    using StackType = LiFFT::mem::ImageStackContainer< tiffWriter::FloatImage<> >;
+    using Idx3D = LiFFT::types::Vec<3>;
+
+    const unsigned numImages = 6;
+    const unsigned width = 32;
+    const unsigned height = 24;
+
+    float
+    getValue(unsigned z, unsigned y, unsigned x)
+    {
+        return getRampValue(z, y, x, width);
+    }
+
+    struct Files: TempTiffFiles
+    {
+        Files(): TempTiffFiles(StackType::getFilePaths("imageStack%02i.tif", 0, numImages - 1), width, height)
+        {
+            BOOST_REQUIRE_EQUAL(paths[1], "imageStack01.tif");
+        }
+    };
+
+    BOOST_AUTO_TEST_CASE(Access)
+    {
+        Files files;
+        StackType stack("imageStack%02i.tif", 0, numImages - 1, 2);
+        BOOST_REQUIRE_EQUAL(stack.getExtents()[0], numImages);
+        BOOST_REQUIRE_EQUAL(stack.getExtents()[1], height);
+        BOOST_REQUIRE_EQUAL(stack.getExtents()[2], width);
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(0u, 0u, 1u)), getValue(0, 0, 1));
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(3u, 5u, 7u)), getValue(3, 5, 7));
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(5u, 23u, 31u)), getValue(5, 23, 31));
+
+        // Cached slices are reused, the least recently used is evicted
+        auto slice3 = stack.getSlice(3);
+        auto slice5 = stack.getSlice(5);
+        BOOST_REQUIRE_EQUAL(stack.getSlice(3), slice3);
+        stack.getSlice(1);
+        BOOST_REQUIRE_EQUAL(stack.getSlice(3), slice3);
+        BOOST_REQUIRE_NE(stack.getSlice(5), slice5);
+
+        stack.setRegion(LiFFT::types::Vec<2>(4u, 8u), LiFFT::types::Vec<2>(10u, 12u));
+        BOOST_REQUIRE_EQUAL(stack.getExtents()[1], 10u);
+        BOOST_REQUIRE_EQUAL(stack.getExtents()[2], 12u);
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(2u, 0u, 0u)), getValue(2, 4, 8));
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(2u, 9u, 11u)), getValue(2, 13, 19));
+        BOOST_REQUIRE_THROW(stack.setRegion(LiFFT::types::Vec<2>(20u, 0u), LiFFT::types::Vec<2>(10u, 12u)), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(Materialize)
+    {
+        Files files;
+        StackType stack(files.paths, 2, 3);
+        stack.prefetch(1, 2);
+        LiFFT::mem::RealContainer<3, float> data(stack.getExtents());
+        stack.materialize(data);
+        for(unsigned z = 0; z < numImages; ++z)
+            for(unsigned y = 0; y < height; ++y)
+                for(unsigned x = 0; x < width; ++x)
+                    BOOST_REQUIRE_EQUAL(data(Idx3D(z, y, x)), getValue(z, y, x));
+
+        LiFFT::mem::RealContainer<3, float> wrongSize(Idx3D(numImages, height, width + 1));
+        BOOST_REQUIRE_THROW(stack.materialize(wrongSize), std::runtime_error);
+
+        // All images must have the same size
+        tiffWriter::FloatImage<> img;
+        img.open(files.paths[4], width + 1, height);
+        img.save();
+        img.close();
+        BOOST_REQUIRE_THROW(stack.materialize(data), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(DecodeInPlace)
+    {
+        using Data = LiFFT::mem::RealContainer<3, float>;
+        using Memory = LiFFT::mem::detail::ContiguousMemory< Data, LiFFT::traits::IdentityAccessor_t<Data> >;
+        static_assert(LiFFT::mem::detail::CanReadRegionTo< tiffWriter::FloatImage<>, LiFFT::accessors::VolumeAccessor, Memory::Value >::value,
+                "Float images should be decoded directly into float containers");
+        static_assert(!LiFFT::mem::detail::CanReadRegionTo< tiffWriter::FloatImage<>, LiFFT::accessors::VolumeAccessor, LiFFT::types::Real<double> >::value,
+                "Float images cannot be decoded directly into double containers");
+        Files files;
+
+        // Decode into padded rows of a buffer
+        const unsigned rowStride = width + 3;
+        std::vector<float> padded(height * rowStride, -1.f);
+        tiffWriter::FloatImage<> img;
+        img.open(files.paths[2], false);
+        img.loadTo(padded.data(), rowStride);
+        for(unsigned y = 0; y < height; ++y)
+        {
+            for(unsigned x = 0; x < width; ++x)
+                BOOST_REQUIRE_EQUAL(padded[y * rowStride + x], getValue(2, y, x));
+            BOOST_REQUIRE_EQUAL(padded[y * rowStride + width], -1.f);
+        }
+        BOOST_REQUIRE_THROW(img.loadTo(padded.data(), width - 1), std::runtime_error);
+        img.readRegionTo(files.paths[3], 8, 4, 12, 10, padded.data(), 12);
+        BOOST_REQUIRE_EQUAL(img.getFileWidth(), width);
+        for(unsigned y = 0; y < 10; ++y)
+            for(unsigned x = 0; x < 12; ++x)
+                BOOST_REQUIRE_EQUAL(padded[y * 12 + x], getValue(3, y + 4, x + 8));
+
+        // Decoding directly into the container must match the copy through a view
+        StackType stack(files.paths, 0);
+        stack.setRegion(LiFFT::types::Vec<2>(4u, 8u), LiFFT::types::Vec<2>(10u, 12u));
+        Data data(stack.getExtents());
+        stack.materialize(data);
+        Data viewData(stack.getExtents());
+        auto view = LiFFT::types::makeView(viewData, LiFFT::types::makeRange());
+        stack.materialize(view);
+        for(unsigned z = 0; z < numImages; ++z)
+            for(unsigned y = 0; y < 10; ++y)
+                for(unsigned x = 0; x < 12; ++x)
+                {
+                    BOOST_REQUIRE_EQUAL(data(Idx3D(z, y, x)), getValue(z, y + 4, x + 8));
+                    BOOST_REQUIRE_EQUAL(viewData(Idx3D(z, y, x)), getValue(z, y + 4, x + 8));
+                }
+        BOOST_REQUIRE_EQUAL(stack(Idx3D(5u, 9u, 11u)), getValue(5, 13, 19));
+    }
+
+    BOOST_AUTO_TEST_CASE(FFT)
+    {
+        Files files;
+        StackType stack(files.paths);
+        using FFT_Type = LiFFT::FFT_3D_R2C_F<>;
+        auto input = FFT_Type::wrapInput(stack);
+        auto output = FFT_Type::createNewOutput(input);
+        auto fft = LiFFT::makeFFT<TestLibrary>(input, output);
+        fft(input, output);
+
+        auto input2 = FFT_Type::wrapInput(LiFFT::mem::RealContainer<3, float>(stack.getExtents()));
+        stack.materialize(input2.getBase());
+        auto output2 = FFT_Type::createNewOutput(input2);
+        auto fft2 = LiFFT::makeFFT<TestLibrary>(input2, output2);
+        fft2(input2, output2);
+        checkResult(output2, output, "FFT of image stack");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
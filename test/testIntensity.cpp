@@ -0,0 +1,206 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/ComplexSoAValues.hpp"
+#include "libLiFFT/policies/IntensityCalculator.hpp"
+#include "libLiFFT/policies/CalcIntensityFunctor.hpp"
+#include "libLiFFT/policies/GetNumElements.hpp"
+#include "libLiFFT/policies/IntensityKernels.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(Intensity)
+
+    // Odd sizes so the vectorized kernels have to handle a scalar tail
+    // and enough elements (> 4 * minElementsPerThread) for 4 threads
+    using IntensityExtents = LiFFT::types::Vec<3>;
+    const IntensityExtents intensityExtents(33u, 67u, 129u);
+
+    template< class T_Data, class T_Generator >
+    void fill(T_Data& data, const T_Generator& gen)
+    {
+        IntensityExtents idx;
+        size_t i = 0;
+        for(idx[0] = 0; idx[0] < intensityExtents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < intensityExtents[1]; ++idx[1])
+                for(idx[2] = 0; idx[2] < intensityExtents[2]; ++idx[2], ++i)
+                    gen(data(idx), i);
+    }
+
+    template< class T_Data, typename T >
+    void checkIntensity(T_Data& data, const std::vector<T>& result)
+    {
+        LiFFT::policies::CalcIntensityFunc calcIntensity;
+        IntensityExtents idx;
+        size_t i = 0;
+        for(idx[0] = 0; idx[0] < intensityExtents[0]; ++idx[0])
+            for(idx[1] = 0; idx[1] < intensityExtents[1]; ++idx[1])
+                for(idx[2] = 0; idx[2] < intensityExtents[2]; ++idx[2], ++i)
+                {
+                    T expected = calcIntensity(data(idx));
+                    BOOST_REQUIRE_SMALL(std::abs(expected - result[i]), std::abs(expected) * 1e-6f + 1e-6f);
+                }
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityReal)
+    {
+        LiFFT::mem::DataContainer< 3, LiFFT::mem::RealValues<TestPrecision> > data(intensityExtents);
+        fill(data, [](LiFFT::types::Real<TestPrecision>& val, size_t i){ val = TestPrecision(i % 101) - 50; });
+        std::vector<TestPrecision> result(LiFFT::policies::getNumElements(data));
+        LiFFT::policies::useIntensityCalculator(data, result.data());
+        checkIntensity(data, result);
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityComplexAoS)
+    {
+        LiFFT::mem::DataContainer< 3, LiFFT::mem::ComplexAoSValues<TestPrecision> > data(intensityExtents);
+        fill(data, [](LiFFT::types::Complex<TestPrecision>& val, size_t i){
+            val.real = TestPrecision(i % 101) - 50;
+            val.imag = TestPrecision(i % 37) / 4;
+        });
+        std::vector<TestPrecision> result(LiFFT::policies::getNumElements(data));
+        BOOST_REQUIRE_GT(result.size(), 4 * LiFFT::policies::intensity::minElementsPerThread);
+        LiFFT::policies::useIntensityCalculator(data, result.data(), 4);
+        checkIntensity(data, result);
+
+        // In-place: Output aliases the input and is computed by a single thread
+        auto inPlace = LiFFT::policies::safe_ptr_cast<TestPrecision*>(&data.getData()->real);
+        LiFFT::policies::useIntensityCalculator(data, inPlace, 4);
+        BOOST_REQUIRE(std::equal(result.begin(), result.end(), inPlace));
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityComplexSoA)
+    {
+        LiFFT::mem::DataContainer< 3, LiFFT::mem::ComplexSoAValues<TestPrecision> > data(intensityExtents);
+        fill(data, [](LiFFT::types::ComplexRef<TestPrecision> val, size_t i){
+            val.real = TestPrecision(i % 101) - 50;
+            val.imag = TestPrecision(i % 37) / 4;
+        });
+        std::vector<TestPrecision> result(LiFFT::policies::getNumElements(data));
+        LiFFT::policies::useIntensityCalculator(data, result.data(), 0);
+        checkIntensity(data, result);
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityBulkFunctor)
+    {
+        const size_t numEl = (1 << 18) + 3;
+        std::vector<LiFFT::types::Complex<double>> data(numEl);
+        for(size_t i = 0; i < numEl; ++i)
+            data[i] = LiFFT::types::Complex<double>(double(i % 13) - 6, double(i % 7));
+        std::vector<double> result(numEl);
+        LiFFT::policies::CalcIntensityFunc calcIntensity;
+        calcIntensity(data.data(), result.data(), numEl, 0);
+        for(size_t i = 0; i < numEl; ++i)
+            BOOST_REQUIRE_EQUAL(result[i], calcIntensity(data[i]));
+    }
+
+    /**
+     * Compares with a relative tolerance: Vectorized kernels may use FMA which rounds differently
+     */
+    template< typename T >
+    void checkClose(const std::vector<T>& expected, const std::vector<T>& result, size_t begin)
+    {
+        const T tolerance = 4 * std::numeric_limits<T>::epsilon();
+        for(size_t i = begin; i < expected.size(); ++i)
+            BOOST_REQUIRE_LE(std::abs(expected[i] - result[i]), std::abs(expected[i]) * tolerance);
+    }
+
+    template< typename T, class T_Kernel >
+    void checkKernel()
+    {
+        using Scalar = LiFFT::policies::intensity::detail::ScalarKernel<T>;
+        // Unaligned range with a scalar tail
+        const size_t numEl = 1003, begin = 3;
+        std::vector<T> real(2 * numEl), imag(numEl);
+        // Values that are not exactly representable, so the squares are rounded
+        for(size_t i = 0; i < 2 * numEl; ++i)
+            real[i] = (T(i % 101) - 50) / 3 + T(0.1);
+        for(size_t i = 0; i < numEl; ++i)
+            imag[i] = T(i % 37) / 7 - T(0.3);
+        std::vector<T> expected(numEl), result(numEl);
+        Scalar::real(real.data(), expected.data(), begin, numEl);
+        T_Kernel::real(real.data(), result.data(), begin, numEl);
+        checkClose(expected, result, begin);
+        Scalar::aos(real.data(), expected.data(), begin, numEl);
+        T_Kernel::aos(real.data(), result.data(), begin, numEl);
+        checkClose(expected, result, begin);
+        Scalar::soa(real.data(), imag.data(), expected.data(), begin, numEl);
+        T_Kernel::soa(real.data(), imag.data(), result.data(), begin, numEl);
+        checkClose(expected, result, begin);
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityKernels)
+    {
+        namespace detail = LiFFT::policies::intensity::detail;
+        checkKernel<TestPrecision, detail::Kernel<TestPrecision>>();
+#if defined(LiFFT_X86_DISPATCH)
+        // Check all kernels the CPU supports, not only the one selected
+        const LiFFT::CpuFeatures& cpu = LiFFT::getCpuFeatures();
+        if(cpu.avx2)
+        {
+            checkKernel<float, detail::Avx2Kernel<float>>();
+            checkKernel<double, detail::Avx2Kernel<double>>();
+        }
+        if(cpu.avx512f)
+        {
+            checkKernel<float, detail::Avx512Kernel<float>>();
+            checkKernel<double, detail::Avx512Kernel<double>>();
+        }
+#endif
+    }
+
+    BOOST_AUTO_TEST_CASE(IntensityOverlap)
+    {
+        namespace intensity = LiFFT::policies::intensity;
+        // Enough elements for 4 threads, so a wrong thread count would show up
+        const size_t numEl = 4 * intensity::minElementsPerThread + 5, offset = 7;
+        std::vector<TestPrecision> input(2 * numEl);
+        for(size_t i = 0; i < input.size(); ++i)
+            input[i] = TestPrecision(i % 101) / 3 - 10;
+        std::vector<TestPrecision> expectedReal(numEl), expectedAoS(numEl);
+        intensity::calculateReal(input.data(), expectedReal.data(), numEl, 4);
+        intensity::calculateAoS(input.data(), expectedAoS.data(), numEl, 4);
+
+        // Output starts before the input (e.g. compacting a buffer)
+        std::vector<TestPrecision> buffer(offset + 2 * numEl);
+        std::copy(input.begin(), input.end(), buffer.begin() + offset);
+        intensity::calculateAoS(buffer.data() + offset, buffer.data(), numEl, 4);
+        BOOST_REQUIRE(std::equal(expectedAoS.begin(), expectedAoS.end(), buffer.begin()));
+        std::copy(input.begin(), input.end(), buffer.begin() + offset);
+        intensity::calculateReal(buffer.data() + offset, buffer.data(), numEl, 4);
+        BOOST_REQUIRE(std::equal(expectedReal.begin(), expectedReal.end(), buffer.begin()));
+        std::copy(input.begin(), input.end(), buffer.begin() + offset);
+        intensity::calculateSoA(buffer.data() + offset, buffer.data() + offset, buffer.data(), numEl, 0);
+        for(size_t i = 0; i < numEl; ++i)
+            BOOST_REQUIRE_LE(std::abs(buffer[i] - 2 * expectedReal[i]), 2 * expectedReal[i] * 4 * std::numeric_limits<TestPrecision>::epsilon());
+
+        // Output starts behind the input: Values would be overwritten before they are read
+        std::copy(input.begin(), input.end(), buffer.begin());
+        BOOST_REQUIRE_THROW(intensity::calculateAoS(buffer.data(), buffer.data() + offset, numEl, 4), std::invalid_argument);
+        BOOST_REQUIRE_THROW(intensity::calculateReal(buffer.data(), buffer.data() + offset, numEl, 1), std::invalid_argument);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
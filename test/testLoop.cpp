@@ -0,0 +1,84 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#include "testDefines.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/policies/Copy.hpp"
+#include "libLiFFT/types/View.hpp"
+#include <boost/test/unit_test.hpp>
+
+namespace LiFFTTest {
+
+    /**
+     * Generates a unique value for each index of a 3D volume
+     */
+    struct IdxValue
+    {
+        template< class T_Idx >
+        TestPrecision
+        operator()(T_Idx&& idx) const
+        {
+            return TestPrecision(idx[0] * 10000 + idx[1] * 100 + idx[2]);
+        }
+    };
+
+    BOOST_AUTO_TEST_SUITE(Loop)
+
+    BOOST_AUTO_TEST_CASE(RunningOffsets)
+    {
+        using Container = LiFFT::mem::RealContainer<3, TestPrecision>;
+        using LiFFT::types::Vec;
+        using LiFFT::types::makeView;
+        using LiFFT::types::makeRange;
+        using ContainerAcc = LiFFT::traits::IdentityAccessor_t<Container>;
+
+        Container src(Vec<3>(4u, 5u, 6u));
+        Container dst(Vec<3>(4u, 5u, 6u));
+        Container big(Vec<3>(6u, 8u, 10u));
+        Vec<3> offset(1u, 2u, 3u);
+        auto view = makeView(big, makeRange(offset, Vec<3>(4u, 5u, 6u)));
+        static_assert(LiFFT::traits::IsFlatOffsetAccessor<ContainerAcc, Container>::value, "Containers should use running offsets");
+        static_assert(!LiFFT::traits::IsFlatOffsetAccessor<LiFFT::traits::IdentityAccessor_t<decltype(view)>, decltype(view)>::value,
+                      "Views need the full index");
+
+        LiFFT::generateData(src, IdxValue());
+        LiFFT::generateData(big, LiFFT::generators::SetToConst<TestPrecision>(-1));
+        // Flat -> Flat, Flat -> View, View -> Flat
+        LiFFT::policies::copy(src, dst);
+        LiFFT::policies::copy(src, view);
+        Container fromView(Vec<3>(4u, 5u, 6u));
+        LiFFT::policies::copy(view, fromView);
+
+        IdxValue expected;
+        Vec<3> idx;
+        for(idx[0] = 0; idx[0] < 4; ++idx[0])
+            for(idx[1] = 0; idx[1] < 5; ++idx[1])
+                for(idx[2] = 0; idx[2] < 6; ++idx[2])
+                {
+                    Vec<3> bigIdx(idx[0] + offset[0], idx[1] + offset[1], idx[2] + offset[2]);
+                    BOOST_REQUIRE_EQUAL(dst(idx), expected(idx));
+                    BOOST_REQUIRE_EQUAL(big(bigIdx), expected(idx));
+                    BOOST_REQUIRE_EQUAL(fromView(idx), expected(idx));
+                }
+        BOOST_REQUIRE_EQUAL(big(Vec<3>(0u, 0u, 0u)), -1);
+        BOOST_REQUIRE_EQUAL(big(Vec<3>(5u, 7u, 9u)), -1);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
@@ -0,0 +1,166 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/MappedVolume.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/policies/Copy.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+
+using LiFFT::generateData;
+using namespace LiFFT::generators;
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(MappedVolume)
+
+    using Extents = LiFFT::types::Vec<3>;
+    using RealVolume = LiFFT::mem::MappedVolume<3, float>;
+
+    BOOST_AUTO_TEST_CASE(Raw)
+    {
+        const std::string filePath = "mappedVolume.raw";
+        const Extents extents(4u, 5u, 6u);
+        const size_t headerSize = 16;
+        {
+            std::ofstream file(filePath, std::ios::binary);
+            const std::string header(headerSize, 'x');
+            file.write(header.data(), header.size());
+            for(unsigned i = 0; i < 4 * 5 * 6; ++i)
+            {
+                const float value = i;
+                file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+        }
+        RealVolume volume = RealVolume::openRaw(filePath, extents, headerSize);
+        BOOST_REQUIRE(!volume.isWritable());
+        for(unsigned i = 0; i < 3; ++i)
+            BOOST_REQUIRE_EQUAL(volume.getExtents()[i], extents[i]);
+        BOOST_REQUIRE_EQUAL(volume(LiFFT::types::Vec<3>(0u, 0u, 1u)), 1.f);
+        BOOST_REQUIRE_EQUAL(volume(LiFFT::types::Vec<3>(1u, 2u, 3u)), float(1 * 30 + 2 * 6 + 3));
+        BOOST_REQUIRE_EQUAL(volume(LiFFT::types::Vec<3>(3u, 4u, 5u)), float(4 * 5 * 6 - 1));
+
+        // Changes to read-only files stay in memory
+        volume(LiFFT::types::Vec<3>(0u, 0u, 0u)) = 42;
+        volume = RealVolume::openRaw(filePath, extents, headerSize);
+        BOOST_REQUIRE_EQUAL(volume(LiFFT::types::Vec<3>(0u, 0u, 0u)), 0.f);
+
+        BOOST_REQUIRE_THROW(RealVolume::openRaw(filePath, Extents(4u, 5u, 7u), headerSize), std::runtime_error);
+        BOOST_REQUIRE_THROW(RealVolume::openRaw(filePath, extents, 2), std::runtime_error);
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(Npy)
+    {
+        const std::string filePath = "mappedVolume.npy";
+        const Extents extents(3u, 7u, 9u);
+        {
+            RealVolume volume = RealVolume::createNpy(filePath, extents);
+            BOOST_REQUIRE(volume.isWritable());
+            // Data must be aligned for vectorized code
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<size_t>(volume.getData()) % 64, 0u);
+            generateData(volume, Cosinus<float>(3, 1));
+            volume.flush();
+        }
+        RealVolume volume = RealVolume::openNpy(filePath);
+        BOOST_REQUIRE(!volume.isFortranOrder());
+        for(unsigned i = 0; i < 3; ++i)
+            BOOST_REQUIRE_EQUAL(volume.getExtents()[i], extents[i]);
+        LiFFT::mem::RealContainer<3, float> expected(extents);
+        generateData(expected, Cosinus<float>(3, 1));
+        checkResult(expected, volume, "Npy volume");
+
+        // Wrong type and dimensions
+        BOOST_REQUIRE_THROW((LiFFT::mem::MappedVolume<3, double>::openNpy(filePath)), std::runtime_error);
+        BOOST_REQUIRE_THROW((LiFFT::mem::MappedVolume<2, float>::openNpy(filePath)), std::runtime_error);
+        std::remove(filePath.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(NpyHeader)
+    {
+        // Header as written by NumPy for np.zeros((2, 3), dtype=np.complex64, order='F')
+        std::string dict = "{'descr': '<c8', 'fortran_order': True, 'shape': (2, 3), }";
+        dict.resize(118 - 1, ' ');
+        dict += '\n';
+        const std::string header = std::string("\x93NUMPY\x01\x00", 8) + char(dict.size()) + char(0) + dict;
+        LiFFT::mem::detail::NpyHeader parsed = LiFFT::mem::detail::parseNpyHeader(header.data(), header.size());
+        BOOST_REQUIRE_EQUAL(parsed.descr, "<c8");
+        BOOST_REQUIRE(parsed.isFortranOrder);
+        BOOST_REQUIRE_EQUAL(parsed.shape.size(), 2u);
+        BOOST_REQUIRE_EQUAL(parsed.shape[0], 2u);
+        BOOST_REQUIRE_EQUAL(parsed.shape[1], 3u);
+        BOOST_REQUIRE_EQUAL(parsed.dataOffset, 128u);
+
+        const std::string filePath = "mappedVolumeF.npy";
+        {
+            std::ofstream file(filePath, std::ios::binary);
+            file.write(header.data(), header.size());
+            const std::string data(2 * 3 * 8, '\0');
+            file.write(data.data(), data.size());
+        }
+        auto volume = LiFFT::mem::MappedVolume<2, float, true>::openNpy(filePath);
+        BOOST_REQUIRE(volume.isFortranOrder());
+        BOOST_REQUIRE_EQUAL(volume.getExtents()[0], 3u);
+        BOOST_REQUIRE_EQUAL(volume.getExtents()[1], 2u);
+        std::remove(filePath.c_str());
+
+        parsed = LiFFT::mem::detail::parseNpyHeader(
+                    LiFFT::mem::detail::makeNpyHeader("<f8", std::vector<size_t>(1, 5)).data(), 128);
+        BOOST_REQUIRE_EQUAL(parsed.descr, "<f8");
+        BOOST_REQUIRE_EQUAL(parsed.shape.size(), 1u);
+        BOOST_REQUIRE_EQUAL(parsed.shape[0], 5u);
+        BOOST_REQUIRE_EQUAL(parsed.dataOffset % 64, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(FFT)
+    {
+        const std::string inPath = "mappedInput.raw";
+        const std::string outPath = "mappedOutput.npy";
+        using Volume = LiFFT::mem::MappedVolume<testNumDims, TestPrecision>;
+        using ComplexVolume = LiFFT::mem::MappedVolume<testNumDims, TestPrecision, true>;
+        const auto extents = baseR2CInput.getExtents();
+        auto outExtents = extents;
+        outExtents[testNumDims - 1] = extents[testNumDims - 1] / 2 + 1;
+
+        Volume input = Volume::createRaw(inPath, extents);
+        generateData(input, Rect<TestPrecision>(20, testSize / 2));
+        ComplexVolume output = ComplexVolume::createNpy(outPath, outExtents);
+
+        using FFT_Type = LiFFT::FFT_Definition< LiFFT::FFT_Kind::Real2Complex, testNumDims, TestPrecision >;
+        auto inWrapped = FFT_Type::wrapInput(input);
+        auto outWrapped = FFT_Type::wrapOutput(output);
+        // The mapped memory is used directly
+        BOOST_REQUIRE(!inWrapped.usesInternalMemory());
+        BOOST_REQUIRE(!outWrapped.usesInternalMemory());
+        auto fft = LiFFT::makeFFT< TestLibrary, false >(inWrapped, outWrapped);
+        generateData(input, Rect<TestPrecision>(20, testSize / 2));
+        fft(inWrapped, outWrapped);
+        output.flush();
+
+        LiFFT::policies::copy(input, baseR2CInput);
+        execBaseR2C();
+        checkResult(baseR2COutput, ComplexVolume::openNpy(outPath), "R2C with mapped files");
+        std::remove(inPath.c_str());
+        std::remove(outPath.c_str());
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
@@ -0,0 +1,121 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testDefines.hpp"
+#include "libLiFFT/MemoryPlanner.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include <boost/test/unit_test.hpp>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(MemoryPlanner)
+
+    // Libraries only add device memory, so the host requirements are the same for all test libraries
+    using Library = TestLibrary;
+    using Extents = LiFFT::types::Vec<3>;
+
+    BOOST_AUTO_TEST_CASE(Requirements)
+    {
+        using R2C = LiFFT::MemoryPlanner< LiFFT::FFT_3D_R2C_F<>, Library >;
+        const Extents extents(64u, 32u, 16u);
+        const size_t numElements = 64 * 32 * 16;
+        const size_t numHalf = 64 * 32 * (16 / 2 + 1);
+
+        LiFFT::MemoryRequirements req = R2C::getRequirements(extents);
+        BOOST_REQUIRE_EQUAL(req.input, numElements * sizeof(float));
+        BOOST_REQUIRE_EQUAL(req.output, numHalf * 2 * sizeof(float));
+        BOOST_REQUIRE_EQUAL(req.staging, 0u);
+        BOOST_REQUIRE_EQUAL(req.getTotal(), req.input + req.output);
+
+        LiFFT::MemoryStrategy strategy;
+        strategy.stageInput = true;
+        req = R2C::getRequirements(extents, strategy);
+        BOOST_REQUIRE_EQUAL(req.staging, req.input);
+
+        // Inplace: only the padded input is needed
+        req = R2C::getRequirements(extents, true, strategy);
+        BOOST_REQUIRE_EQUAL(req.input, numHalf * 2 * sizeof(float));
+        BOOST_REQUIRE_EQUAL(req.output, 0u);
+        BOOST_REQUIRE_EQUAL(req.staging, 0u);
+
+        using C2C = LiFFT::MemoryPlanner< LiFFT::FFT_3D_C2C_D<>, Library >;
+        req = C2C::getRequirements(extents);
+        BOOST_REQUIRE_EQUAL(req.input, numElements * 2 * sizeof(double));
+        BOOST_REQUIRE_EQUAL(req.output, req.input);
+
+        using C2R = LiFFT::MemoryPlanner< LiFFT::FFT_3D_C2R_F<>, Library >;
+        req = C2R::getRequirements(extents);
+        BOOST_REQUIRE_EQUAL(req.input, numHalf * 2 * sizeof(float));
+        BOOST_REQUIRE_EQUAL(req.output, numElements * sizeof(float));
+    }
+
+    BOOST_AUTO_TEST_CASE(MatchesAllocation)
+    {
+        using FFT = LiFFT::FFT_2D_R2C_F<>;
+        const LiFFT::types::Vec<2> extents(100u, 50u);
+        LiFFT::mem::RealContainer<2, float> input(extents);
+        LiFFT::mem::ComplexContainer<2, float> output(LiFFT::types::Vec<2>(100u, 50u / 2 + 1));
+        LiFFT::MemoryRequirements req = LiFFT::MemoryPlanner< FFT, Library >::getRequirements(extents);
+        BOOST_REQUIRE_EQUAL(req.input, input.getMemSize());
+        BOOST_REQUIRE_EQUAL(req.output, output.getMemSize());
+
+        using FFT_Inplace = LiFFT::FFT_2D_R2C_F<true>;
+        auto inOut = FFT_Inplace::createNewInput(extents);
+        req = LiFFT::MemoryPlanner< FFT_Inplace, Library >::getRequirements(extents);
+        BOOST_REQUIRE_EQUAL(req.input, inOut.getMemSize());
+    }
+
+    BOOST_AUTO_TEST_CASE(Choose)
+    {
+        using Planner = LiFFT::MemoryPlanner< LiFFT::FFT_3D_R2C_F<>, Library >;
+        const Extents extents(64u, 32u, 16u);
+        const size_t outOfPlace = Planner::getRequirements(extents, false).getTotal();
+        const size_t inplace = Planner::getRequirements(extents, true).getTotal();
+        BOOST_REQUIRE_LT(inplace, outOfPlace);
+
+        LiFFT::MemoryPlan plan = Planner::choose(extents, outOfPlace);
+        BOOST_REQUIRE(!plan.isInplace);
+        BOOST_REQUIRE_EQUAL(plan.numSlabs, 1u);
+        BOOST_REQUIRE_EQUAL(plan.slabSize, 64u);
+
+        plan = Planner::choose(extents, outOfPlace - 1);
+        BOOST_REQUIRE(plan.isInplace);
+        BOOST_REQUIRE_EQUAL(plan.numSlabs, 1u);
+        BOOST_REQUIRE_EQUAL(plan.requirements.getTotal(), inplace);
+
+        BOOST_REQUIRE_THROW(Planner::choose(extents, inplace - 1), std::runtime_error);
+
+        // A third of the data does not fit inplace (rounding), 4 slabs do
+        plan = Planner::choose(extents, inplace / 3, LiFFT::MemoryStrategy(), true);
+        BOOST_REQUIRE(plan.isInplace);
+        BOOST_REQUIRE_EQUAL(plan.numSlabs, 4u);
+        BOOST_REQUIRE_EQUAL(plan.slabSize, 16u);
+        BOOST_REQUIRE_LE(plan.requirements.getTotal(), inplace / 3);
+
+        plan = Planner::choose(extents, outOfPlace / 2, LiFFT::MemoryStrategy(), true);
+        BOOST_REQUIRE(!plan.isInplace);
+        BOOST_REQUIRE_EQUAL(plan.numSlabs, 2u);
+        BOOST_REQUIRE_EQUAL(plan.slabSize, 32u);
+
+        // Single rows always need to fit
+        BOOST_REQUIRE_THROW(Planner::choose(extents, 100, LiFFT::MemoryStrategy(), true), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
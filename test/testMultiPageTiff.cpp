@@ -0,0 +1,130 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/mem/FileContainer.hpp"
+#include "libLiFFT/mem/RealValues.hpp"
+#include "libLiFFT/accessors/VolumeAccessor.hpp"
+#include "libLiFFT/types/SliceView.hpp"
+#include "tiffWriter/multiPageImage.hpp"
+#include "tiffWriter/traitsAndPolicies.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(MultiPageTiff)
+
+    using Volume = LiFFT::mem::RealContainer<3, float>;
+    using MultiPageImage = tiffWriter::FloatMultiPageImage<>;
+
+    const LiFFT::types::Vec3 extents(5u, 48u, 64u);
+
+    float
+    getValue(unsigned z, unsigned y, unsigned x)
+    {
+        return getRampValue(z, y, x, extents[2]);
+    }
+
+    struct VolumeFile: TempTiffFiles
+    {
+        const std::string path = "multiPage.tif";
+
+        VolumeFile()
+        {
+            addVolume(path, extents[2], extents[1], extents[0]);
+        }
+    };
+
+    BOOST_AUTO_TEST_CASE(RoundTrip)
+    {
+        VolumeFile file;
+        MultiPageImage img(file.path);
+        BOOST_REQUIRE(img.isOpen());
+        BOOST_REQUIRE_EQUAL(img.getNumPages(), extents[0]);
+        LiFFT::policies::GetExtents<MultiPageImage> imgExtents(img);
+        for(unsigned i = 0; i < 3; ++i)
+            BOOST_REQUIRE_EQUAL(imgExtents[i], extents[i]);
+
+        using FileType = LiFFT::mem::FileContainer< MultiPageImage, LiFFT::accessors::VolumeAccessor, float >;
+        FileType container(file.path);
+        auto& loaded = container.getData();
+        BOOST_REQUIRE_EQUAL(container.getMemSize(), extents[0] * extents[1] * extents[2] * sizeof(float));
+        for(unsigned z = 0; z < extents[0]; ++z)
+            for(unsigned y = 0; y < extents[1]; ++y)
+                for(unsigned x = 0; x < extents[2]; ++x)
+                    BOOST_REQUIRE_EQUAL(loaded(LiFFT::types::Vec3(z, y, x)), getValue(z, y, x));
+    }
+
+    BOOST_AUTO_TEST_CASE(LazyPages)
+    {
+        VolumeFile file;
+        const MultiPageImage img(file.path);
+        // Random page order
+        for(unsigned z: {3u, 0u, 4u, 4u, 1u})
+        {
+            BOOST_REQUIRE_EQUAL(img(7, 5, z), getValue(z, 5, 7));
+            BOOST_REQUIRE_EQUAL(img.getCurrentPage(), z);
+        }
+        BOOST_REQUIRE_THROW(img(0, 0, extents[0]), std::out_of_range);
+
+        // Copy a single page
+        Volume page(LiFFT::types::Vec3(1u, static_cast<unsigned>(extents[1]), static_cast<unsigned>(extents[2])));
+        auto view = LiFFT::types::makeSliceView<0>(page, LiFFT::types::makeRange());
+        MultiPageImage img2(file.path);
+        for(unsigned y = 0; y < extents[1]; ++y)
+            for(unsigned x = 0; x < extents[2]; ++x)
+                view(LiFFT::types::Vec2(y, x)) = img2(x, y, 2);
+        for(unsigned y = 0; y < extents[1]; ++y)
+            for(unsigned x = 0; x < extents[2]; ++x)
+                BOOST_REQUIRE_EQUAL(page(LiFFT::types::Vec3(0u, y, x)), getValue(2, y, x));
+    }
+
+    BOOST_AUTO_TEST_CASE(Write)
+    {
+        const std::string path = "multiPageWrite.tif";
+        {
+            MultiPageImage img(path, 8, 4, 3);
+            img(1, 1, 0) = 1.f;
+            // Skips page 1 which is written as zeros
+            img(2, 3, 2) = 2.f;
+            BOOST_REQUIRE_THROW(img(0, 0, 0), std::runtime_error);
+            BOOST_REQUIRE_THROW(img(0, 0, 3), std::out_of_range);
+            img.save();
+        }
+        MultiPageImage img(path);
+        BOOST_REQUIRE_EQUAL(img.getNumPages(), 3u);
+        BOOST_REQUIRE_EQUAL(img.getWidth(), 8u);
+        BOOST_REQUIRE_EQUAL(img.getHeight(), 4u);
+        for(unsigned z = 0; z < 3; ++z)
+            for(unsigned y = 0; y < 4; ++y)
+                for(unsigned x = 0; x < 8; ++x)
+                {
+                    float expected = 0;
+                    if(z == 0 && x == 1 && y == 1)
+                        expected = 1;
+                    else if(z == 2 && x == 2 && y == 3)
+                        expected = 2;
+                    BOOST_REQUIRE_EQUAL(img(x, y, z), expected);
+                }
+        img.close();
+        std::remove(path.c_str());
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
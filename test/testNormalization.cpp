@@ -0,0 +1,94 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/accessors/ZipAccessor.hpp"
+#include <boost/test/unit_test.hpp>
+#include <functional>
+
+using LiFFT::generateData;
+using namespace LiFFT::generators;
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(Normalization)
+
+    BOOST_AUTO_TEST_CASE(RoundTripByN)
+    {
+        using FFT_Fwd = LiFFT::FFT_2D_C2C<TestPrecision>;
+        using FFT_Bwd = LiFFT::FFT_Definition<LiFFT::FFT_Kind::Complex2Complex, testNumDims, TestPrecision, std::false_type>;
+        ComplexContainer data(TestExtents::all(testSize));
+        ComplexContainer spectrum(TestExtents::all(testSize));
+        ComplexContainer result(TestExtents::all(testSize));
+        generateData(data, Rect<TestPrecision>(20,testSize/2));
+        auto input = FFT_Fwd::wrapInput(data);
+        auto specOut = FFT_Fwd::wrapOutput(spectrum);
+        auto specIn = FFT_Bwd::wrapInput(spectrum);
+        auto output = FFT_Bwd::wrapOutput(result);
+        auto fftFwd = LiFFT::makeFFT<TestLibrary>(input, specOut);
+        auto fftBwd = LiFFT::makeFFT<TestLibrary>(specIn, output, LiFFT::Normalization::byN());
+        fftFwd(input, specOut);
+        fftBwd(specIn, output);
+        checkResult(data, result, "C2C round trip (1/N)", CmpError(1e-3, 5e-5));
+    }
+
+    BOOST_AUTO_TEST_CASE(InplaceRoundTripBySqrtN)
+    {
+        using FFT_Fwd = LiFFT::FFT_2D_C2C<TestPrecision, true>;
+        using FFT_Bwd = LiFFT::FFT_Definition<LiFFT::FFT_Kind::Complex2Complex, testNumDims, TestPrecision, std::false_type, true>;
+        ComplexContainer data(TestExtents::all(testSize));
+        ComplexContainer orig(TestExtents::all(testSize));
+        generateData(data, Rect<TestPrecision>(20,testSize/2));
+        LiFFT::policies::copy(data, orig);
+        auto inoutFwd = FFT_Fwd::wrapInput(data);
+        auto inoutBwd = FFT_Bwd::wrapInput(data);
+        auto fftFwd = LiFFT::makeFFT<TestLibrary>(inoutFwd, LiFFT::Normalization::bySqrtN());
+        auto fftBwd = LiFFT::makeFFT<TestLibrary>(inoutBwd, LiFFT::Normalization::bySqrtN());
+        fftFwd(inoutFwd);
+        fftBwd(inoutBwd);
+        checkResult(orig, data, "C2C inplace round trip (1/sqrt(N))", CmpError(1e-3, 5e-5));
+    }
+
+    BOOST_AUTO_TEST_CASE(FoldedIntoInputCopy)
+    {
+        // The zip accessor returns values, so the input is copied to internal memory and scaled on the fly
+        using FFT_Type = LiFFT::FFT_2D_R2C<TestPrecision>;
+        const TestPrecision factor = 0.25;
+        RealContainer data(TestExtents::all(testSize));
+        RealContainer ones(TestExtents::all(testSize));
+        generateData(data, Rect<TestPrecision>(20,testSize/2));
+        generateData(ones, SetToConst<TestPrecision>(1));
+        auto acc = LiFFT::accessors::makeZipAccessor(ones, std::multiplies<LiFFT::types::Real<TestPrecision>>(), LiFFT::traits::getIdentityAccessor(data));
+        auto input = FFT_Type::wrapInput(data, acc);
+        auto output = FFT_Type::createNewOutput(input);
+        auto fft = LiFFT::makeFFT<TestLibrary>(input, output, LiFFT::Normalization::custom(factor));
+        fft(input, output);
+        LiFFT::policies::copy(data, baseR2CInput);
+        execBaseR2C();
+        TestExtents idx = TestExtents::all(0);
+        for(idx[0] = 0; idx[0] < baseR2COutput.getExtents()[0]; idx[0]++)
+            for(idx[1] = 0; idx[1] < baseR2COutput.getExtents()[1]; idx[1]++)
+            {
+                baseR2COutput(idx).real = baseR2COutput(idx).real * factor;
+                baseR2COutput(idx).imag = baseR2COutput(idx).imag * factor;
+            }
+        checkResult(baseR2COutput, output, "R2C with copied input (custom)");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}  // namespace LiFFTTest
@@ -0,0 +1,154 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+
+#include "testDefines.hpp"
+#include "libLiFFT/mem/DataContainer.hpp"
+#include "libLiFFT/mem/NumaAllocator.hpp"
+#include "libLiFFT/generateData.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(Placement)
+
+    using LiFFT::mem::NumaAllocator;
+    using LiFFT::mem::NumaPolicy;
+    using LiFFT::mem::HugePages;
+    using Extents = LiFFT::types::Vec<3>;
+
+    template< class T_Container >
+    LiFFT::mem::Placement
+    getPlacement(T_Container& data)
+    {
+        return LiFFT::mem::getPlacement(data.getData(), data.getMemSize());
+    }
+
+    size_t
+    getNumPresent(const LiFFT::mem::Placement& placement)
+    {
+        return std::accumulate(placement.pagesPerNode.begin(), placement.pagesPerNode.end(), size_t(0));
+    }
+
+    /**
+     * Returns true if the placement of the pages could be queried, prints a message otherwise
+     */
+    bool
+    isKnown(const LiFFT::mem::Placement& placement)
+    {
+        if(placement.numUnknown == 0)
+            return true;
+        BOOST_TEST_MESSAGE("Page placement cannot be queried on this system, skipping the checks");
+        return false;
+    }
+
+    BOOST_AUTO_TEST_CASE(ParallelFirstTouch)
+    {
+        using Container = LiFFT::mem::RealContainer<3, TestPrecision, false, NumaAllocator<>>;
+        Container data(Extents(64u, 64u, 130u));
+        BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(data.getData()) % 64u, 0u);
+        LiFFT::mem::Placement placement = getPlacement(data);
+        if(isKnown(placement))
+        {
+            BOOST_REQUIRE_EQUAL(placement.numNotPresent, 0u);
+            BOOST_REQUIRE_GT(getNumPresent(placement), 0u);
+        }
+
+        LiFFT::generateData(data, LiFFT::generators::SetToConst<TestPrecision>(3));
+        BOOST_REQUIRE_EQUAL(data(Extents(63u, 63u, 129u)), 3);
+#ifdef __linux__
+        // The calling thread touches the first chunk, its affinity must be restored afterwards
+        cpu_set_t before, after;
+        BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(before), &before), 0);
+        Container other(Extents(64u, 64u, 130u));
+        BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(after), &after), 0);
+        BOOST_REQUIRE(CPU_EQUAL(&before, &after));
+#endif
+    }
+
+    BOOST_AUTO_TEST_CASE(FirstTouch)
+    {
+        using Container = LiFFT::mem::ComplexContainer<3, TestPrecision, false, NumaAllocator<NumaPolicy::FirstTouch, HugePages::None>>;
+        Container data(Extents(32u, 32u, 32u));
+        // Nothing but the first page (holding the mapping info) is touched on allocation
+        LiFFT::mem::Placement placement = getPlacement(data);
+        if(!isKnown(placement))
+            return;
+        BOOST_REQUIRE_LE(getNumPresent(placement), 1u);
+        BOOST_REQUIRE_GT(placement.numNotPresent, 0u);
+        LiFFT::generateData(data, LiFFT::generators::SetToConst<TestPrecision>(1));
+        placement = getPlacement(data);
+        BOOST_REQUIRE_EQUAL(placement.numNotPresent, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(Interleave)
+    {
+        using Container = LiFFT::mem::RealContainer<3, TestPrecision, false, NumaAllocator<NumaPolicy::Interleave>>;
+        Container data(Extents(16u, 128u, 128u));
+        LiFFT::mem::Placement placement = getPlacement(data);
+        if(!isKnown(placement))
+            return;
+        BOOST_REQUIRE_EQUAL(placement.numNotPresent, 0u);
+        // Every online node gets pages (as far as there are enough pages), node ids may have holes
+        for(unsigned node: LiFFT::mem::detail::getOnlineNumaNodes())
+            BOOST_REQUIRE_GT(placement.pagesPerNode.at(node), 0u);
+    }
+
+#ifdef __linux__
+    BOOST_AUTO_TEST_CASE(NodeAffinity)
+    {
+        const unsigned node = LiFFT::mem::detail::getOnlineNumaNodes().front();
+        const std::vector<unsigned> nodeCpus = LiFFT::mem::detail::readIdList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        cpu_set_t before, pinned, after;
+        BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(before), &before), 0);
+        {
+            LiFFT::mem::detail::NodeAffinityGuard guard(node);
+            BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(pinned), &pinned), 0);
+        }
+        BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(after), &after), 0);
+        BOOST_REQUIRE(CPU_EQUAL(&before, &after));
+        if(nodeCpus.empty())
+            return;
+        for(unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(CPU_ISSET(cpu, &pinned))
+                BOOST_REQUIRE(std::find(nodeCpus.begin(), nodeCpus.end(), cpu) != nodeCpus.end());
+        }
+    }
+#endif
+
+    BOOST_AUTO_TEST_CASE(NodeList)
+    {
+        using LiFFT::mem::detail::parseIdList;
+        const std::vector<unsigned> expected = {0, 1, 2, 3, 5};
+        const std::vector<unsigned> nodes = parseIdList("0-3,5");
+        BOOST_REQUIRE_EQUAL_COLLECTIONS(nodes.begin(), nodes.end(), expected.begin(), expected.end());
+        BOOST_REQUIRE(parseIdList("").empty());
+        BOOST_REQUIRE_EQUAL(parseIdList("7").size(), 1u);
+    }
+
+    BOOST_AUTO_TEST_CASE(InvalidNode)
+    {
+        using Container = LiFFT::mem::RealContainer<1, TestPrecision, false, NumaAllocator<NumaPolicy::Bind, HugePages::None, 1 << 20>>;
+        BOOST_CHECK_THROW(Container(LiFFT::types::Vec<1>(100u)), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
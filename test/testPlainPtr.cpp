@@ -46,6 +46,18 @@ namespace LiFFTTest {
         checkResult(baseR2COutput, outWrapped, "R2C with PlainPtrWrapper");
     }
 
+    BOOST_AUTO_TEST_CASE(LargeIndices)
+    {
+        // 2048^3 elements exceed 32 bit indices, no memory is accessed here
+        using Extents3 = LiFFT::types::Vec<3>;
+        const size_t numElements = size_t(2048) * 2048 * 2048;
+        LiFFT::types::Real<TestPrecision> dummy;
+        auto wrapped = LiFFT::mem::wrapPtr<false>(&dummy, Extents3::all(2048u));
+        BOOST_REQUIRE_EQUAL(LiFFT::policies::getNumElements(wrapped), numElements);
+        BOOST_REQUIRE_EQUAL(LiFFT::policies::flattenIdx(Extents3::all(2047u), wrapped), numElements - 1);
+        BOOST_REQUIRE_EQUAL(LiFFT::policies::flattenIdx(Extents3(1024u, 0u, 1u), wrapped), numElements / 2 + 1);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace LiFFTTest
@@ -0,0 +1,138 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/mem/FileContainer.hpp"
+#include "libLiFFT/mem/PrefetchFileContainer.hpp"
+#include "libLiFFT/accessors/ImageAccessor.hpp"
+#include "tiffWriter/image.hpp"
+#include "tiffWriter/traitsAndPolicies.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(PrefetchFile)
+
+    using FileAccessor = LiFFT::accessors::ImageAccessorGetColorAsFp<TestPrecision>;
+    using FileType = LiFFT::mem::FileContainer< tiffWriter::FloatImage<>, FileAccessor, TestPrecision >;
+    using PrefetchType = LiFFT::mem::PrefetchFileContainer< tiffWriter::FloatImage<>, FileAccessor, TestPrecision >;
+
+    struct Files: TempTiffFiles
+    {
+        Files()
+        {
+            // One file with different extents to check the reallocation
+            for(unsigned i = 0; i < 5; ++i)
+                addImage("prefetch" + std::to_string(i) + ".tif", i == 3 ? 40 : 64, 48);
+        }
+    };
+
+    void
+    checkFile(PrefetchType& container, const std::string& filePath)
+    {
+        FileType expected(filePath);
+        expected.loadData();
+        BOOST_REQUIRE_EQUAL(container.getFilePath(), filePath);
+        BOOST_REQUIRE_EQUAL(container.getMemSize(), expected.getMemSize());
+        for(unsigned i = 0; i < 2; ++i)
+            BOOST_REQUIRE_EQUAL(container.getExtents()[i], expected.getExtents()[i]);
+        BOOST_REQUIRE(std::memcmp(container.getAllocatedMemory(), expected.getAllocatedMemory(), expected.getMemSize()) == 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(Sequence)
+    {
+        Files files;
+        for(unsigned depth = 0; depth < 4; ++depth)
+        {
+            PrefetchType container(files.paths, depth);
+            BOOST_REQUIRE_EQUAL(container.getPrefetchDepth(), depth);
+            void* buffer = nullptr;
+            for(const std::string& path: files.paths)
+            {
+                container.setFilePath(path);
+                checkFile(container, path);
+                // The current buffer only changes with the extents
+                if(path == files.paths[1] || path == files.paths[2])
+                    BOOST_REQUIRE_EQUAL(container.getAllocatedMemory(), buffer);
+                buffer = container.getAllocatedMemory();
+            }
+            container.setFilePath("");
+            BOOST_REQUIRE(!container.getAllocatedMemory());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(Prefetch)
+    {
+        Files files;
+        PrefetchType container(2);
+        BOOST_REQUIRE(container.prefetch(files.paths[0]));
+        BOOST_REQUIRE(container.prefetch(files.paths[1]));
+        BOOST_REQUIRE(!container.prefetch(files.paths[2]));
+        // Skips the first prefetched file
+        container.setFilePath(files.paths[1]);
+        checkFile(container, files.paths[1]);
+        // Not prefetched
+        container.setFilePath(files.paths[4]);
+        checkFile(container, files.paths[4]);
+        container.loadData(true);
+        checkFile(container, files.paths[4]);
+    }
+
+    BOOST_AUTO_TEST_CASE(FFT)
+    {
+        Files files;
+        // Equal extents, so one FFT can be used for all files
+        std::vector<std::string> sequence = {files.paths[0], files.paths[1], files.paths[2], files.paths[4]};
+        using FFT_Type = LiFFT::FFT_2D_R2C<TestPrecision>;
+        PrefetchType container(sequence, 2);
+        container.setFilePath(sequence[0]);
+        auto input = FFT_Type::wrapInput(container);
+        auto output = FFT_Type::createNewOutput(input);
+        // Planning must not overwrite the data of the first file
+        auto fft = LiFFT::makeFFT<TestLibrary, false>(input, output);
+        for(unsigned i = 0; i < sequence.size(); ++i)
+        {
+            if(i)
+                container.setFilePath(sequence[i]);
+            fft(input, output);
+            FileType expected(sequence[i]);
+            auto input2 = FFT_Type::wrapInput(expected);
+            auto output2 = FFT_Type::createNewOutput(input2);
+            auto fft2 = LiFFT::makeFFT<TestLibrary>(input2, output2);
+            expected.loadData(true);
+            fft2(input2, output2);
+            checkResult(output2, output, "FFT of prefetched file " + sequence[i]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(Errors)
+    {
+        Files files;
+        std::vector<std::string> sequence = {files.paths[0], "doesNotExist.tif", files.paths[1]};
+        PrefetchType container(sequence, 2);
+        container.setFilePath(sequence[0]);
+        checkFile(container, sequence[0]);
+        BOOST_REQUIRE_THROW(container.setFilePath(sequence[1]), std::runtime_error);
+        container.setFilePath(sequence[2]);
+        checkFile(container, sequence[2]);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace LiFFTTest
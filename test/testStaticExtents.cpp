@@ -0,0 +1,102 @@
+/* This file is part of libLiFFT.
+ *
+ * libLiFFT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * libLiFFT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libLiFFT.  If not, see <www.gnu.org/licenses/>.
+ */
+ 
+#include "testUtils.hpp"
+#include "libLiFFT/FFT.hpp"
+#include "libLiFFT/generateData.hpp"
+#include "libLiFFT/types/StaticExtents.hpp"
+#include "libLiFFT/policies/flattenIdx.hpp"
+#include <boost/test/unit_test.hpp>
+
+using LiFFT::generateData;
+using namespace LiFFT::generators;
+
+namespace LiFFTTest {
+
+    BOOST_AUTO_TEST_SUITE(StaticExtents)
+
+    BOOST_AUTO_TEST_CASE(Container)
+    {
+        using Extents = LiFFT::types::StaticExtents<3, 5, 7>;
+        static_assert(Extents::numDims == 3, "Wrong dimensions");
+        static_assert(Extents::numElements == 3 * 5 * 7, "Wrong number of elements");
+        static_assert(Extents()[1] == 5 && Extents::getStride(0) == 35 && Extents::getStride(2) == 1, "Wrong extents/strides");
+        static_assert(std::is_same< LiFFT::types::ReplaceLastExtent<Extents, 4>::type, LiFFT::types::StaticExtents<3, 5, 4> >::value, "Wrong replacement");
+
+        LiFFT::mem::StaticRealContainer<float, 3, 5, 7> data;
+        LiFFT::mem::RealContainer<3, float> dynData(LiFFT::types::Vec3(3u, 5u, 7u));
+        static_assert(LiFFT::traits::HasStaticExtents<decltype(data)>::value, "Extents should be static");
+        static_assert(!LiFFT::traits::HasStaticExtents<decltype(dynData)>::value, "Extents should be dynamic");
+        BOOST_REQUIRE_EQUAL(LiFFT::policies::getNumElements(data), Extents::numElements);
+        LiFFT::types::Vec3 idx;
+        for(idx[0] = 0; idx[0] < 3; ++idx[0])
+            for(idx[1] = 0; idx[1] < 5; ++idx[1])
+                for(idx[2] = 0; idx[2] < 7; ++idx[2])
+                {
+                    BOOST_REQUIRE_EQUAL(LiFFT::policies::flattenIdx(idx, data), LiFFT::policies::flattenIdx(idx, dynData));
+                    data(idx) = idx[0] * 100 + idx[1] * 10 + idx[2];
+                }
+        LiFFT::policies::copy(data, dynData);
+        LiFFT::mem::StaticRealContainer<float, 3, 5, 7> data2;
+        LiFFT::policies::copy(dynData, data2);
+        checkResult(data, data2, "Copy via dynamic container");
+    }
+
+    BOOST_AUTO_TEST_CASE(StaticR2C)
+    {
+        using FFT_Type = LiFFT::FFT_2D_R2C<TestPrecision>::WithExtents< LiFFT::types::StaticExtents<testSize, testSize> >;
+        auto input = FFT_Type::createNewInput();
+        static_assert(LiFFT::traits::HasStaticExtents<decltype(input)::Base>::value, "Input should have static extents");
+        auto output = FFT_Type::createNewOutput(input);
+        auto fft = LiFFT::makeFFT<TestLibrary>(input, output);
+        generateData(input, Rect<TestPrecision>(20,testSize/2));
+        LiFFT::policies::copy(input, baseR2CInput);
+        fft(input, output);
+        execBaseR2C();
+        checkResult(baseR2COutput, output, "R2C with static extents");
+    }
+
+    BOOST_AUTO_TEST_CASE(StaticC2R)
+    {
+        // The full size of the C2R output is known at planning time
+        using Extents = LiFFT::types::StaticExtents<testSize, testSize>;
+        using FFT_Fwd = LiFFT::FFT_2D_R2C<TestPrecision>::WithExtents<Extents>;
+        using FFT_Bwd = LiFFT::FFT_2D_C2R<TestPrecision>::WithExtents<Extents>;
+        RealContainer data(TestExtents::all(testSize));
+        RealContainer result(TestExtents::all(testSize));
+        LiFFT::mem::StaticComplexContainer<TestPrecision, testSize, testSize/2+1> spectrum;
+        generateData(data, Rect<TestPrecision>(20,testSize/2));
+        auto input = FFT_Fwd::wrapInput(data);
+        auto specOut = FFT_Fwd::wrapOutput(spectrum);
+        auto specIn = FFT_Bwd::wrapInput(spectrum);
+        auto output = FFT_Bwd::wrapOutput(result);
+        auto fftFwd = LiFFT::makeFFT<TestLibrary>(input, specOut);
+        auto fftBwd = LiFFT::makeFFT<TestLibrary>(specIn, output, LiFFT::Normalization::byN());
+        generateData(data, Rect<TestPrecision>(20,testSize/2));
+        fftFwd(input, specOut);
+        fftBwd(specIn, output);
+        checkResult(data, result, "R2C/C2R round trip with static extents", CmpError(1e-3, 5e-5));
+    }
+
+    BOOST_AUTO_TEST_CASE(ExtentsMismatch)
+    {
+        using FFT_Type = LiFFT::FFT_2D_C2C<TestPrecision>::WithExtents< LiFFT::types::StaticExtents<64, 64> >;
+        ComplexContainer data(TestExtents(64u, 32u));
+        BOOST_CHECK_THROW(FFT_Type::wrapInput(data), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}  // namespace LiFFTTest
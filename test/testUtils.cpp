@@ -27,6 +27,9 @@
 #include "libLiFFT/policies/CalcIntensityFunctor.hpp"
 #include "libLiFFT/types/View.hpp"
 #include "libLiFFT/types/SliceView.hpp"
+#include "tiffWriter/image.hpp"
+#include "tiffWriter/multiPageImage.hpp"
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 // see https://stackoverflow.com/questions/222557/what-uses-are-there-for-placement-new
@@ -178,4 +181,41 @@ namespace LiFFTTest {
         (*fftC2C)(input, output);
     }
 
+    TempTiffFiles::TempTiffFiles(const std::vector<std::string>& filePaths, unsigned width, unsigned height)
+    {
+        for(const std::string& path: filePaths)
+            addImage(path, width, height);
+    }
+
+    TempTiffFiles::~TempTiffFiles()
+    {
+        for(const std::string& path: paths)
+            std::remove(path.c_str());
+    }
+
+    void
+    TempTiffFiles::addImage(const std::string& path, unsigned width, unsigned height)
+    {
+        const unsigned z = paths.size();
+        paths.push_back(path);
+        tiffWriter::FloatImage<> img;
+        img.open(path, width, height);
+        for(unsigned y = 0; y < height; ++y)
+            for(unsigned x = 0; x < width; ++x)
+                img(x, y) = getRampValue(z, y, x, width);
+        img.save();
+    }
+
+    void
+    TempTiffFiles::addVolume(const std::string& path, unsigned width, unsigned height, unsigned numPages)
+    {
+        paths.push_back(path);
+        tiffWriter::FloatMultiPageImage<> img(path, width, height, numPages);
+        for(unsigned z = 0; z < numPages; ++z)
+            for(unsigned y = 0; y < height; ++y)
+                for(unsigned x = 0; x < width; ++x)
+                    img(x, y, z) = getRampValue(z, y, x, width);
+        img.save();
+    }
+
 }  // namespace LiFFTTest
@@ -23,6 +23,8 @@
 #include <boost/test/unit_test.hpp>
 #include <cmath>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #define TEST(function) if(!(function)) return 1
 
@@ -63,6 +65,41 @@ namespace LiFFTTest {
      */
     void execBaseC2C();
 
+    /**
+     * Value of pixel (x, y) of image/page z of the files written by \ref TempTiffFiles
+     */
+    inline float
+    getRampValue(unsigned z, unsigned y, unsigned x, unsigned width)
+    {
+        return z * 10000.f + y * width + x;
+    }
+
+    /**
+     * Float TIFF files filled with \ref getRampValue that are removed in the destructor
+     */
+    struct TempTiffFiles
+    {
+        std::vector<std::string> paths;
+
+        TempTiffFiles() = default;
+        /**
+         * Writes one image per path, the index of the path is used as z
+         */
+        TempTiffFiles(const std::vector<std::string>& filePaths, unsigned width, unsigned height);
+        ~TempTiffFiles();
+        TempTiffFiles(const TempTiffFiles&) = delete;
+        TempTiffFiles& operator=(const TempTiffFiles&) = delete;
+
+        /**
+         * Writes an image using the number of files written so far as z
+         */
+        void addImage(const std::string& path, unsigned width, unsigned height);
+        /**
+         * Writes a multi-page file, page z is filled with the values of image z
+         */
+        void addVolume(const std::string& path, unsigned width, unsigned height, unsigned numPages);
+    };
+
     /**
      * Maximum error detected during a compare run
      */
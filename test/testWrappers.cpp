@@ -19,9 +19,11 @@
 #include "libLiFFT/mem/DataContainer.hpp"
 #include "libLiFFT/types/View.hpp"
 #include "libLiFFT/types/SliceView.hpp"
+#include "libLiFFT/types/Expression.hpp"
 #include <boost/test/unit_test.hpp>
 #include <boost/mpl/list.hpp>
 #include <boost/mpl/int.hpp>
+#include <limits>
 
 namespace LiFFTTest {
 
@@ -117,6 +119,32 @@ namespace LiFFTTest {
         }
     }
 
+    BOOST_AUTO_TEST_CASE(AlignedMemory)
+    {
+        using Extents = LiFFT::types::Vec<2>;
+        using FFT = LiFFT::FFT_2D_R2C_F<>;
+        constexpr size_t alignment = LiFFT::mem::DefaultAllocator::alignment;
+        for(unsigned size = 1; size < 20; size += 3)
+        {
+            LiFFT::mem::RealContainer<2, float> real(Extents(size, size + 1));
+            LiFFT::mem::ComplexContainer<2, float> complex(Extents(size + 1, size));
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(real.getData()) % alignment, 0u);
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(complex.getData()) % alignment, 0u);
+            // Expressions have no memory, so the wrapper uses internal memory
+            auto input = FFT::wrapInput(LiFFT::types::makeExpr(real) * 2.f);
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(input.getDataPtr()) % alignment, 0u);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(AllocationOverflow)
+    {
+        using Allocator = LiFFT::mem::DefaultAllocator;
+        // numElements * sizeof(T) would wrap around to a small size
+        const size_t numElements = std::numeric_limits<size_t>::max() / sizeof(double) + 2;
+        BOOST_REQUIRE_THROW(Allocator::allocate<double>(numElements), std::bad_alloc);
+        BOOST_REQUIRE_THROW(Allocator::allocate<double>(std::numeric_limits<size_t>::max() / sizeof(double)), std::bad_alloc);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace LiFFTTest